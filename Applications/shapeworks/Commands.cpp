@@ -106,6 +106,11 @@ void OptimizeCommand::buildParser() {
       .action("store_true")
       .set_default(false)
       .help("XML console output [default: false].");
+  parser.add_option("--resume")
+      .action("store")
+      .type("string")
+      .set_default("")
+      .help("Resume from the latest checkpoint in this checkpoint or output directory.");
 
   Command::buildParser();
 }
@@ -114,6 +119,7 @@ bool OptimizeCommand::execute(const optparse::Values& options, SharedCommandData
   const std::string& projectFile(static_cast<std::string>(options.get("name")));
   bool show_progress = static_cast<bool>(options.get("progress"));
   bool xml_status = static_cast<bool>(options.get("xmlconsole"));
+  std::string resume = static_cast<std::string>(options.get("resume"));
 
   if (projectFile.length() == 0) {
     std::cerr << "Must specify project name with --name <project.xlsx|.swproj>\n";
@@ -125,6 +131,11 @@ bool OptimizeCommand::execute(const optparse::Values& options, SharedCommandData
   Optimize app;
   setup_callbacks(show_progress, xml_status);
 
+  if (!resume.empty()) {
+    // the working directory changes to the project's directory below
+    app.SetResumeDirectory(boost::filesystem::absolute(resume).string());
+  }
+
   if (isProject) {
     try {
       // load spreadsheet project
@@ -231,6 +242,63 @@ bool GroomCommand::execute(const optparse::Values& options, SharedCommandData& s
   }
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// GroomCache
+///////////////////////////////////////////////////////////////////////////////
+void GroomCacheCommand::buildParser() {
+  const std::string prog = "groom-cache";
+  const std::string desc = "report or clean up the groom cache of a shapeworks project";
+  parser.prog(prog).description(desc);
+
+  parser.add_option("--name").action("store").type("string").set_default("").help("Path to project file.");
+  parser.add_option("--clear").action("store_true").set_default(false).help("Remove every cache entry [default: false].");
+  parser.add_option("--max_size")
+      .action("store")
+      .type("double")
+      .set_default(-1.0)
+      .help("Remove the least recently used entries until the cache is at most this many MB.");
+
+  Command::buildParser();
+}
+
+bool GroomCacheCommand::execute(const optparse::Values& options, SharedCommandData& sharedData) {
+  const std::string& projectFile(static_cast<std::string>(options.get("name")));
+  bool clear = static_cast<bool>(options.get("clear"));
+  double max_size = static_cast<double>(options.get("max_size"));
+
+  if (projectFile.length() == 0) {
+    std::cerr << "Must specify project name with --name <project.xlsx|.swproj>\n";
+    return false;
+  }
+
+  try {
+    ProjectHandle project = std::make_shared<Project>();
+    project->load(projectFile);
+
+    const auto oldBasePath = boost::filesystem::current_path();
+    auto base = StringUtils::getPath(projectFile);
+    if (base != projectFile) {
+      boost::filesystem::current_path(base.c_str());
+      project->set_filename(StringUtils::getFilename(projectFile));
+    }
+
+    GroomCache cache(Groom::get_cache_directory(project), 0);
+    if (clear) {
+      cache.clear();
+    } else if (max_size >= 0) {
+      cache.prune(static_cast<size_t>(max_size * 1024 * 1024));
+    }
+    std::cout << "Groom cache " << cache.get_directory() << ": " << cache.get_count() << " entries, "
+              << cache.get_size() / (1024.0 * 1024.0) << " MB\n";
+
+    boost::filesystem::current_path(oldBasePath);
+    return true;
+  } catch (std::exception& e) {
+    SW_ERROR(e.what());
+    return false;
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Analyze
 ///////////////////////////////////////////////////////////////////////////////
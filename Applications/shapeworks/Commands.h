@@ -51,6 +51,8 @@ COMMAND_DECLARE(ReadParticleSystem, ParticleSystemCommand);
 COMMAND_DECLARE(Compactness, ParticleSystemCommand);
 COMMAND_DECLARE(Generalization, ParticleSystemCommand);
 COMMAND_DECLARE(Specificity, ParticleSystemCommand);
+COMMAND_DECLARE(ConvertParticles, ParticleSystemCommand);
+COMMAND_DECLARE(PackParticles, ParticleSystemCommand);
 
 // Mesh Commands
 COMMAND_DECLARE(ReadMesh, MeshCommand);
@@ -99,6 +101,7 @@ COMMAND_DECLARE(LandmarkGeodesics, MeshCommand);
 COMMAND_DECLARE(Seed, ShapeworksCommand);
 COMMAND_DECLARE(OptimizeCommand, OptimizeCommandGroup);
 COMMAND_DECLARE(GroomCommand, GroomCommandGroup);
+COMMAND_DECLARE(GroomCacheCommand, GroomCommandGroup);
 COMMAND_DECLARE(AnalyzeCommand, AnalyzeCommandGroup);
 COMMAND_DECLARE(ConvertProjectCommand, ProjectCommandGroup);
 
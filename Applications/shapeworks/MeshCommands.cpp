@@ -1314,6 +1314,9 @@ void MeshToDT::buildParser() {
       "Spacing of output image in z-direction [default: unit spacing].");
   parser.add_option("--pad").action("store").type("int").set_default(1).help(
       "Number of pixels to pad the output region [default: 1].");
+  parser.add_option("--narrow_band").action("store").type("double").set_default(0.0).help(
+      "Only compute exact distances within this distance of the surface, clamping the rest [default: 0.0 (whole "
+      "image)].");
 
   Command::buildParser();
 }
@@ -1328,12 +1331,13 @@ bool MeshToDT::execute(const optparse::Values &options, SharedCommandData &share
   double y = static_cast<double>(options.get("sy"));
   double z = static_cast<double>(options.get("sz"));
   unsigned pad = static_cast<unsigned>(options.get("pad"));
+  double narrow_band = static_cast<double>(options.get("narrow_band"));
 
   Point3 spacing({x, y, z});
   auto region = sharedData.mesh->boundingBox();
   Dims padding({pad, pad, pad});
 
-  sharedData.image = sharedData.mesh->toDistanceTransform(region, spacing, padding);
+  sharedData.image = sharedData.mesh->toDistanceTransform(region, spacing, padding, narrow_band);
   return true;
 }
 
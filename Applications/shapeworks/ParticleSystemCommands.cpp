@@ -1,4 +1,7 @@
+#include <boost/filesystem.hpp>
+
 #include "Commands.h"
+#include "ParticleFile.h"
 #include "ShapeEvaluation.h"
 
 namespace shapeworks {
@@ -12,7 +15,7 @@ void ReadParticleSystem::buildParser()
   const std::string desc = "reads a particle system";
   parser.prog(prog).description(desc);
 
-  parser.add_option("--names").action("store").type("multistring").set_default("").help("Paths to .particle files (must be followed by `--`), ex: \"--names *.particle -- next-command...\")");
+  parser.add_option("--names").action("store").type("multistring").set_default("").help("Paths to .particle files or a single packed .swcohort file (must be followed by `--`), ex: \"--names *.particle -- next-command...\")");
 
   Command::buildParser();
 }
@@ -122,4 +125,72 @@ bool Specificity::execute(const optparse::Values &options, SharedCommandData &sh
   return true;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// ConvertParticles
+///////////////////////////////////////////////////////////////////////////////
+void ConvertParticles::buildParser()
+{
+  const std::string prog = "convert-particles";
+  const std::string desc = "converts particle files to another format (text, .vtk or binary .swpts), chosen by extension";
+  parser.prog(prog).description(desc);
+
+  parser.add_option("--names").action("store").type("multistring").set_default("").help("Paths to particle files (must be followed by `--`), ex: \"convert-particles --names *.particles -- --extension .swpts\")");
+  parser.add_option("--extension").action("store").type("string").set_default(".swpts").help("Extension of the converted files, written next to the originals [default: %default].");
+
+  Command::buildParser();
+}
+
+bool ConvertParticles::execute(const optparse::Values &options, SharedCommandData &sharedData)
+{
+  std::vector<std::string> filenames = options.get("names");
+  const std::string extension = static_cast<std::string>(options.get("extension"));
+
+  try {
+    for (const auto& filename : filenames) {
+      const std::string output = boost::filesystem::path(filename).replace_extension(extension).string();
+      particles::write_particles(output, particles::read_particles(filename));
+    }
+    return true;
+  } catch (std::exception &e) {
+    std::cerr << "exception while converting particles: " << e.what() << std::endl;
+    return false;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PackParticles
+///////////////////////////////////////////////////////////////////////////////
+void PackParticles::buildParser()
+{
+  const std::string prog = "pack-particles";
+  const std::string desc = "packs the particle files of a cohort into a single memory mappable .swcohort file";
+  parser.prog(prog).description(desc);
+
+  parser.add_option("--names").action("store").type("multistring").set_default("").help("Paths to particle files, all domains of a subject in a row (must be followed by `--`), ex: \"pack-particles --names *.particles -- --output cohort.swcohort\")");
+  parser.add_option("--domains").action("store").type("int").set_default("1").help("Number of domains per subject [default: %default].");
+  parser.add_option("--output").action("store").type("string").set_default("").help("Name of the cohort file to write.");
+
+  Command::buildParser();
+}
+
+bool PackParticles::execute(const optparse::Values &options, SharedCommandData &sharedData)
+{
+  std::vector<std::string> filenames = options.get("names");
+  const int domains = static_cast<int>(options.get("domains"));
+  const std::string output = static_cast<std::string>(options.get("output"));
+
+  if (output.empty()) {
+    std::cerr << "pack-particles: no output filename specified\n";
+    return false;
+  }
+
+  try {
+    particles::CohortFile::pack(output, filenames, domains);
+    return true;
+  } catch (std::exception &e) {
+    std::cerr << "exception while packing particles: " << e.what() << std::endl;
+    return false;
+  }
+}
+
 } //shapeworks
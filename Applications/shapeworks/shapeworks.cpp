@@ -59,6 +59,8 @@ int main(int argc, char *argv[])
   shapeworks.addCommand(Compactness::getCommand());
   shapeworks.addCommand(Generalization::getCommand());
   shapeworks.addCommand(Specificity::getCommand());
+  shapeworks.addCommand(ConvertParticles::getCommand());
+  shapeworks.addCommand(PackParticles::getCommand());
 
   // Mesh Commands
   shapeworks.addCommand(ReadMesh::getCommand());
@@ -107,6 +109,7 @@ int main(int argc, char *argv[])
   shapeworks.addCommand(Seed::getCommand());
   shapeworks.addCommand(OptimizeCommand::getCommand());
   shapeworks.addCommand(GroomCommand::getCommand());
+  shapeworks.addCommand(GroomCacheCommand::getCommand());
   shapeworks.addCommand(AnalyzeCommand::getCommand());
   shapeworks.addCommand(ConvertProjectCommand::getCommand());
 
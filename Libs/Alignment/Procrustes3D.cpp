@@ -1,7 +1,9 @@
 #include "Procrustes3D.h"
 
+#include <tbb/parallel_for.h>
 #include <vnl/algo/vnl_svd.h>
 
+#include <functional>
 #include <iostream>
 
 //---------------------------------------------------------------------------
@@ -46,63 +48,52 @@ void Procrustes3D::RemoveTranslation(SimilarityTransformListType& transforms, Sh
 void Procrustes3D::AlignShapes(SimilarityTransformListType& transforms, ShapeListType& shapes) {
   const RealType SOS_EPSILON = 1.0e-8;
 
-  PointType center;
-  ShapeListIteratorType shapeListIt;
-  SimilarityTransformListIteratorType transformIt;
-  ShapeIteratorType shapeIt;
-
   ShapeType mean;
 
   SimilarityTransform3D transform;
   transform.rotation.set_identity();
   transform.scale = 1.0;
+  transform.translation.fill(0.0);
 
-  transforms.clear();
-  transforms.reserve(shapes.size());
-
-  // Remove translation
-  for (shapeListIt = shapes.begin(); shapeListIt != shapes.end(); shapeListIt++) {
-    ShapeType& shape = (*shapeListIt);
-    center.fill(0.0);
+  transforms.assign(shapes.size(), transform);
 
-    for (shapeIt = shape.begin(); shapeIt != shape.end(); shapeIt++) {
-      center += (*shapeIt);
-    }
-
-    center /= static_cast<RealType>(shape.size());
-
-    transform.translation = -center;
+  // Shapes are aligned independently of each other (given the mean), so all per shape steps run in parallel.  Every
+  // result only depends on the shape it belongs to, so the alignment does not depend on the thread count.
+  const auto for_each_shape = [&](const std::function<void(size_t)>& f) {
+    tbb::parallel_for(tbb::blocked_range<size_t>{0, shapes.size()}, [&](const tbb::blocked_range<size_t>& r) {
+      for (size_t i = r.begin(); i < r.end(); i++) {
+        f(i);
+      }
+    });
+  };
 
-    // First time through transforms we need to push_back
-    transforms.push_back(transform);
+  // Remove translation
+  for_each_shape([&](size_t i) {
+    ShapeType& shape = shapes[i];
+    PointType center;
+    ComputeCenterOfMass(shape, center);
+    transforms[i].translation = -center;
 
     // Apply translation to shape
-    for (shapeIt = shape.begin(); shapeIt != shape.end(); shapeIt++) {
-      (*shapeIt) -= center;
+    for (auto& point : shape) {
+      point -= center;
     }
-  }
+  });
 
   // Remove rotation and scale iteratively
   RealType sumOfSquares = ComputeSumOfSquares(shapes);
   RealType newSumOfSquares, diff = 1e10;
 
   while (diff > SOS_EPSILON) {
-    shapeListIt = shapes.begin();
-    transformIt = transforms.begin();
-
     // by computing the mean shape based on all samples, we are removing biasness that was introduced by LeaveOneOutMean
     ComputeMeanShape(mean, shapes);
 
-    while (shapeListIt != shapes.end()) {
-      AlignTwoShapes((*transformIt), mean, (*shapeListIt));
-      shapeListIt++;
-      transformIt++;
-    }
+    for_each_shape([&](size_t i) { AlignTwoShapes(transforms[i], mean, shapes[i]); });
 
     // Fix scalings so geometric average = 1
     RealType scaleAve = 0.0;
-    for (transformIt = transforms.begin(); transformIt != transforms.end(); transformIt++) {
-      scaleAve += log((*transformIt).scale);
+    for (const auto& t : transforms) {
+      scaleAve += log(t.scale);
     }
 
     scaleAve = exp(scaleAve / static_cast<RealType>(transforms.size()));
@@ -112,19 +103,14 @@ void Procrustes3D::AlignShapes(SimilarityTransformListType& transforms, ShapeLis
     scaleSim.translation.fill(0.0);
     scaleSim.scale = 1.0 / scaleAve;
 
-    shapeListIt = shapes.begin();
-    transformIt = transforms.begin();
-    while (shapeListIt != shapes.end()) {
-      TransformShape((*shapeListIt), scaleSim);
+    for_each_shape([&](size_t i) {
+      TransformShape(shapes[i], scaleSim);
       if (m_Scaling) {
-        (*transformIt).scale /= scaleAve;
+        transforms[i].scale /= scaleAve;
       } else {
-        (*transformIt).scale = 1;
+        transforms[i].scale = 1;
       }
-
-      shapeListIt++;
-      transformIt++;
-    }
+    });
 
     newSumOfSquares = ComputeSumOfSquares(shapes);
     diff = sumOfSquares - newSumOfSquares;
@@ -242,26 +228,35 @@ void Procrustes3D::ConstructTransformMatrix(SimilarityTransform3D& transform, Tr
 
 //---------------------------------------------------------------------------
 Procrustes3D::RealType Procrustes3D::ComputeSumOfSquares(ShapeListType& shapes) {
-  ShapeListIteratorType shapeIt1, shapeIt2;
-  ShapeIteratorType pointIt1, pointIt2;
-
-  RealType sum = 0.0;
+  // The sum of squared distances between all pairs of shapes, computed from the distances to the mean of each point,
+  // since sum_a sum_b |x_a - x_b|^2 = 2 N sum_a |x_a - mean|^2.  This is linear instead of quadratic in the number
+  // of shapes.
+  const size_t numShapes = shapes.size();
+  const size_t numPoints = shapes[0].size();
+
+  // one partial sum per point, added up in order below so the result does not depend on the thread count
+  std::vector<RealType> pointSums(numPoints);
+  tbb::parallel_for(tbb::blocked_range<size_t>{0, numPoints}, [&](const tbb::blocked_range<size_t>& r) {
+    for (size_t k = r.begin(); k < r.end(); k++) {
+      PointType mean(0.0, 0.0, 0.0);
+      for (const auto& shape : shapes) {
+        mean += shape[k];
+      }
+      mean /= static_cast<RealType>(numShapes);
 
-  for (shapeIt1 = shapes.begin(); shapeIt1 != shapes.end(); shapeIt1++) {
-    for (shapeIt2 = shapes.begin(); shapeIt2 != shapes.end(); shapeIt2++) {
-      ShapeType& shape1 = (*shapeIt1);
-      ShapeType& shape2 = (*shapeIt2);
-
-      pointIt1 = shape1.begin();
-      pointIt2 = shape2.begin();
-      while (pointIt1 != shape1.end() && pointIt2 != shape2.end()) {
-        sum += ((*pointIt1) - (*pointIt2)).squared_magnitude();
-        pointIt1++;
-        pointIt2++;
+      RealType sum = 0.0;
+      for (const auto& shape : shapes) {
+        sum += (shape[k] - mean).squared_magnitude();
       }
+      pointSums[k] = sum;
     }
+  });
+
+  RealType sum = 0.0;
+  for (auto pointSum : pointSums) {
+    sum += pointSum;
   }
-  return sum / static_cast<RealType>(shapes.size() * shapes[0].size());
+  return 2.0 * numShapes * sum / static_cast<RealType>(numShapes * numPoints);
 }
 
 //---------------------------------------------------------------------------
@@ -329,31 +324,19 @@ void Procrustes3D::AlignTwoShapes(SimilarityTransform3D& transform, ShapeType& s
 
 //---------------------------------------------------------------------------
 void Procrustes3D::ComputeMeanShape(ShapeType& mean, ShapeListType& shapeList) {
-  ShapeListIteratorType shapeListIt;
-  ShapeIteratorType shapeIt, meanIt;
-
   size_t numPoints = shapeList[0].size();
 
-  mean.clear();
-  mean.reserve(numPoints);
-  for (size_t i = 0; i < numPoints; i++) {
-    mean.push_back(vnl_vector_fixed<RealType, 3>(0.0, 0.0, 0.0));
-  }
+  mean.assign(numPoints, PointType(0.0, 0.0, 0.0));
 
-  for (shapeListIt = shapeList.begin(); shapeListIt != shapeList.end(); shapeListIt++) {
-    ShapeType& shape = (*shapeListIt);
-    shapeIt = shape.begin();
-    meanIt = mean.begin();
-    while (shapeIt != shape.end()) {
-      (*meanIt) += (*shapeIt);
-      shapeIt++;
-      meanIt++;
+  // each point sums the shapes in order, so the mean does not depend on the thread count
+  tbb::parallel_for(tbb::blocked_range<size_t>{0, numPoints}, [&](const tbb::blocked_range<size_t>& r) {
+    for (size_t k = r.begin(); k < r.end(); k++) {
+      for (const auto& shape : shapeList) {
+        mean[k] += shape[k];
+      }
+      mean[k] /= static_cast<RealType>(shapeList.size());
     }
-  }
-
-  for (meanIt = mean.begin(); meanIt != mean.end(); meanIt++) {
-    (*meanIt) /= static_cast<RealType>(shapeList.size());
-  }
+  });
 }
 
 //---------------------------------------------------------------------------
@@ -1,10 +1,13 @@
 #include <Groom.h>
+#include <GroomCache.h>
 #include <GroomParameters.h>
+#include <GroomScheduler.h>
 #include <Image/Image.h>
 #include <Mesh/Mesh.h>
 #include <Mesh/MeshUtils.h>
 #include <Project/ProjectUtils.h>
 #include <Utils/StringUtils.h>
+#include <itkImageIOFactory.h>
 #include <itkRegionOfInterestImageFilter.h>
 #include <tbb/parallel_for.h>
 #include <vtkCenterOfMass.h>
@@ -13,6 +16,8 @@
 #include <Logging.h>
 
 #include <boost/filesystem.hpp>
+#include <cmath>
+#include <numeric>
 #include <vector>
 
 using namespace shapeworks;
@@ -31,6 +36,7 @@ bool Groom::run() {
   used_names_.clear();
   this->progress_ = 0;
   this->progress_counter_ = 0;
+  this->cached_stage_count_ = 0;
   this->total_ops_ = this->get_total_ops();
 
   auto subjects = this->project_->get_subjects();
@@ -38,40 +44,40 @@ bool Groom::run() {
   if (subjects.empty()) {
     throw std::invalid_argument("No subjects to groom");
   }
-  std::atomic<bool> success = true;
 
-  tbb::parallel_for(tbb::blocked_range<size_t>{0, subjects.size()}, [&](const tbb::blocked_range<size_t>& r) {
-    for (size_t i = r.begin(); i < r.end(); ++i) {
-      for (int domain = 0; domain < project_->get_number_of_domains_per_subject(); domain++) {
-        if (this->abort_) {
-          success = false;
-          continue;
-        }
-
-        bool is_image = project_->get_original_domain_types()[domain] == DomainType::Image;
-        bool is_mesh = project_->get_original_domain_types()[domain] == DomainType::Mesh;
-        bool is_contour = project_->get_original_domain_types()[domain] == DomainType::Contour;
-
-        if (is_image) {
-          if (!this->image_pipeline(subjects[i], domain)) {
-            success = false;
-          }
-        }
-
-        if (is_mesh) {
-          if (!this->mesh_pipeline(subjects[i], domain)) {
-            success = false;
-          }
-        }
+  // stream the subjects through reading, processing and writing, within the memory budget
+  auto base_params = GroomParameters(this->project_);
+  if (base_params.get_groom_cache()) {
+    this->cache_ = std::make_unique<GroomCache>(Groom::get_cache_directory(this->project_),
+                                                static_cast<size_t>(base_params.get_groom_cache_size() * 1024 * 1024));
+  }
+  GroomScheduler scheduler(static_cast<size_t>(base_params.get_groom_memory_budget() * 1024 * 1024));
 
-        if (is_contour) {
-          if (!this->contour_pipeline(subjects[i], domain)) {
-            success = false;
-          }
+  std::vector<GroomScheduler::Job> jobs;
+  for (size_t i = 0; i < subjects.size(); i++) {
+    for (int domain = 0; domain < project_->get_number_of_domains_per_subject(); domain++) {
+      auto domain_type = project_->get_original_domain_types()[domain];
+      auto subject = subjects[i];
+
+      if (domain_type == DomainType::Image) {
+        jobs.push_back(this->create_image_job(subject, domain));
+      } else if (domain_type == DomainType::Mesh || domain_type == DomainType::Contour) {
+        // meshes are small compared to volumes, so they are read and written by their compute stage
+        GroomScheduler::Job job;
+        job.footprint = Groom::estimate_mesh_footprint(subject->get_original_filenames()[domain]);
+        if (domain_type == DomainType::Mesh) {
+          job.process = [=]() { return this->mesh_pipeline(subject, domain); };
+        } else {
+          job.process = [=]() { return this->contour_pipeline(subject, domain); };
         }
+        jobs.push_back(job);
       }
     }
-  });
+  }
+
+  bool success = scheduler.run(jobs, [&]() -> bool { return this->abort_; });
+  scheduler.log_statistics();
+  this->cache_.reset();
 
   if (!this->run_alignment()) {
     success = false;
@@ -83,25 +89,23 @@ bool Groom::run() {
 }
 
 //---------------------------------------------------------------------------
-bool Groom::image_pipeline(std::shared_ptr<Subject> subject, size_t domain) {
+GroomScheduler::Job Groom::create_image_job(std::shared_ptr<Subject> subject, size_t domain) {
   // grab parameters
   auto params = GroomParameters(this->project_, this->project_->get_domain_names()[domain]);
 
   auto original = subject->get_original_filenames()[domain];
 
-  // load the image
-  Image image(original);
-
-  // define a groom transform
-  vtkSmartPointer<vtkTransform> transform = vtkSmartPointer<vtkTransform>::New();
-  transform->Identity();
+  GroomScheduler::Job job;
 
   if (params.get_skip_grooming()) {
-    std::vector<std::vector<double>> groomed_transforms;
-    groomed_transforms.push_back(ProjectUtils::convert_transform(transform));
-    subject->set_groomed_transforms(groomed_transforms);
+    job.write = [=]() {
+      // identity groom transform
+      vtkSmartPointer<vtkTransform> transform = vtkSmartPointer<vtkTransform>::New();
+      transform->Identity();
+      std::vector<std::vector<double>> groomed_transforms;
+      groomed_transforms.push_back(ProjectUtils::convert_transform(transform));
+      subject->set_groomed_transforms(groomed_transforms);
 
-    {
       // lock for project data structure
       std::scoped_lock lock(mutex_);
 
@@ -114,51 +118,97 @@ bool Groom::image_pipeline(std::shared_ptr<Subject> subject, size_t domain) {
 
       // store filenames back to subject
       subject->set_groomed_filenames(groomed_filenames);
+      return true;
+    };
+    return job;
+  }
+
+  // the data passed between the stages
+  struct State {
+    std::unique_ptr<Image> image;
+    std::unique_ptr<Mesh> mesh;
+    vtkSmartPointer<vtkTransform> transform;
+    //! groom cache key of each image stage, and the first stage that is not restored from the cache
+    std::vector<std::string> keys;
+    size_t first_stage = 0;
+  };
+  auto state = std::make_shared<State>();
+
+  // groomed filename
+  std::string groomed_name =
+      this->get_output_filename(original, params.get_convert_to_mesh() ? DomainType::Mesh : DomainType::Image);
+
+  job.footprint = Groom::estimate_image_footprint(original, params);
+
+  job.read = [=]() {
+    // restart from the last stage with a cached result, if any
+    if (this->cache_) {
+      auto stages = this->get_image_stages(params);
+      state->keys = this->get_image_stage_keys(stages, GroomCache::hash_file(original));
+      for (size_t i = state->keys.size(); i-- > 0;) {
+        if (stages[i].cached && (state->image = this->cache_->load(state->keys[i]))) {
+          SW_DEBUG("Restarting groom of {} after the {} stage from the cache", original, stages[i].description);
+          state->first_stage = i + 1;
+          this->cached_stage_count_ += i + 1;
+          return true;
+        }
+      }
     }
 
+    // load the image
+    state->image = std::make_unique<Image>(original);
     return true;
-  }
+  };
+
+  job.process = [=]() {
+    Image& image = *state->image;
+
+    // define a groom transform
+    state->transform = vtkSmartPointer<vtkTransform>::New();
+    state->transform->Identity();
 
-  this->run_image_pipeline(image, params);
+    this->run_image_pipeline(image, params, state->keys, state->first_stage);
 
-  // reflection
-  if (params.get_reflect()) {
-    auto table = subject->get_table_values();
-    if (table.find(params.get_reflect_column()) != table.end()) {
-      if (table[params.get_reflect_column()] == params.get_reflect_choice()) {
-        this->add_reflect_transform(transform, params.get_reflect_axis());
+    // reflection
+    if (params.get_reflect()) {
+      auto table = subject->get_table_values();
+      if (table.find(params.get_reflect_column()) != table.end()) {
+        if (table[params.get_reflect_column()] == params.get_reflect_choice()) {
+          this->add_reflect_transform(state->transform, params.get_reflect_axis());
+        }
       }
     }
-  }
 
-  // centering
-  if (params.get_use_center()) {
-    this->add_center_transform(transform, image);
-  }
+    // centering
+    if (params.get_use_center()) {
+      this->add_center_transform(state->transform, image);
+    }
 
-  if (this->abort_) {
-    return false;
-  }
+    if (this->abort_) {
+      return false;
+    }
 
-  // groomed filename
-  std::string groomed_name = this->get_output_filename(original, DomainType::Image);
+    if (params.get_convert_to_mesh()) {
+      state->mesh = std::make_unique<Mesh>(image.toMesh(0.0));
+      state->image.reset();
+      this->run_mesh_pipeline(*state->mesh, params);
+    }
+    return true;
+  };
 
-  if (params.get_convert_to_mesh()) {
-    Mesh mesh = image.toMesh(0.0);
-    this->run_mesh_pipeline(mesh, params);
-    groomed_name = this->get_output_filename(original, DomainType::Mesh);
-    // save the groomed mesh
-    MeshUtils::threadSafeWriteMesh(groomed_name, mesh);
-  } else {
-    // save image
-    image.write(groomed_name);
-  }
+  job.write = [=]() {
+    if (state->mesh) {
+      // save the groomed mesh
+      MeshUtils::threadSafeWriteMesh(groomed_name, *state->mesh);
+    } else {
+      // save image
+      state->image->write(groomed_name);
+    }
 
-  {
     // lock for project data structure
     std::scoped_lock lock(mutex_);
 
-    subject->set_groomed_transform(domain, ProjectUtils::convert_transform(transform));
+    subject->set_groomed_transform(domain, ProjectUtils::convert_transform(state->transform));
 
     // update groomed filenames
     std::vector<std::string> groomed_filenames = subject->get_groomed_filenames();
@@ -169,58 +219,99 @@ bool Groom::image_pipeline(std::shared_ptr<Subject> subject, size_t domain) {
 
     // store filenames back to subject
     subject->set_groomed_filenames(groomed_filenames);
+    return true;
+  };
+
+  return job;
+}
+
+//---------------------------------------------------------------------------
+size_t Groom::estimate_image_footprint(const std::string& filename, GroomParameters params) {
+  // the pipeline holds the image as float, and most of its filters keep their input alive while they write a new
+  // output
+  const double copies = 3;
+
+  try {
+    auto io = itk::ImageIOFactory::CreateImageIO(filename.c_str(), itk::ImageIOFactory::IOFileModeEnum::ReadMode);
+    if (io) {
+      io->SetFileName(filename);
+      io->ReadImageInformation();
+      double voxels = 1;
+      double voxel_volume = 1;
+      for (unsigned d = 0; d < io->GetNumberOfDimensions(); d++) {
+        voxels *= io->GetDimensions(d);
+        voxel_volume *= io->GetSpacing(d);
+      }
+
+      // resampling to a finer spacing grows the image
+      if (params.get_resample()) {
+        auto spacing = params.get_spacing();
+        if (params.get_isotropic()) {
+          auto iso = params.get_iso_spacing();
+          spacing = {iso, iso, iso};
+        }
+        double resampled_volume = spacing[0] * spacing[1] * spacing[2];
+        if (resampled_volume > 0) {
+          voxels *= std::max(1.0, voxel_volume / resampled_volume);
+        }
+      }
+      return static_cast<size_t>(voxels * sizeof(PixelType) * copies);
+    }
+  } catch (itk::ExceptionObject& e) {
+    SW_DEBUG("Unable to read image information of {}: {}", filename, e.what());
   }
 
-  return true;
+  // e.g. DICOM directories, only count what is on disk
+  boost::system::error_code error;
+  auto size = boost::filesystem::file_size(filename, error);
+  return error ? 0 : static_cast<size_t>(size * copies);
 }
 
 //---------------------------------------------------------------------------
-bool Groom::run_image_pipeline(Image& image, GroomParameters params) {
+size_t Groom::estimate_mesh_footprint(const std::string& filename) {
+  // meshes are read into memory a few times larger than their files
+  const size_t expansion = 4;
+  boost::system::error_code error;
+  auto size = boost::filesystem::file_size(filename, error);
+  return error ? 0 : static_cast<size_t>(size * expansion);
+}
+
+//---------------------------------------------------------------------------
+std::vector<Groom::ImageStage> Groom::get_image_stages(GroomParameters params) {
+  std::vector<ImageStage> stages;
+
   // isolate
   if (params.get_isolate_tool()) {
-    image.isolate();
-    this->increment_progress();
-  }
-  if (this->abort_) {
-    return false;
+    stages.push_back({"isolate", 1, false, [](Image& image) { image.isolate(); }});
   }
 
   // fill holes
   if (params.get_fill_holes_tool()) {
-    image.closeHoles();
-    this->increment_progress();
-  }
-  if (this->abort_) {
-    return false;
+    stages.push_back({"fill_holes", 1, false, [](Image& image) { image.closeHoles(); }});
   }
 
   // crop
   if (params.get_crop()) {
-    PhysicalRegion region = image.physicalBoundingBox(0.5);
-    image.crop(region);
-    this->increment_progress();
-  }
-  if (this->abort_) {
-    return false;
+    stages.push_back({"crop", 1, false, [](Image& image) {
+                        PhysicalRegion region = image.physicalBoundingBox(0.5);
+                        image.crop(region);
+                      }});
   }
 
   // autopad
   if (params.get_auto_pad_tool()) {
-    image.pad(params.get_padding_amount());
-    this->fix_origin(image);
-    this->increment_progress();
-  }
-  if (this->abort_) {
-    return false;
+    int padding = params.get_padding_amount();
+    stages.push_back({fmt::format("pad {}", padding), 1, false, [=](Image& image) {
+                        image.pad(padding);
+                        this->fix_origin(image);
+                      }});
   }
 
   // antialias
   if (params.get_antialias_tool()) {
-    image.antialias(params.get_antialias_iterations());
-    this->increment_progress();
-  }
-  if (this->abort_) {
-    return false;
+    int iterations = params.get_antialias_iterations();
+    stages.push_back({fmt::format("antialias {}", iterations), 1, true,
+                      [=](Image& image) { image.antialias(iterations); }});
   }
 
   // resample
@@ -234,31 +325,67 @@ bool Groom::run_image_pipeline(Image& image, GroomParameters params) {
     v[0] = spacing[0];
     v[1] = spacing[1];
     v[2] = spacing[2];
-    if (v[0] == 0 || v[1] == 0 || v[2] == 0) {
-      // skip resample
-    } else {
-      image.resample(v, Image::InterpolationType::Linear);
-    }
-    this->increment_progress();
-  }
-  if (this->abort_) {
-    return false;
+    stages.push_back({fmt::format("resample {} {} {}", v[0], v[1], v[2]), 1, true, [=](Image& image) {
+                        if (v[0] == 0 || v[1] == 0 || v[2] == 0) {
+                          // skip resample
+                        } else {
+                          image.resample(v, Image::InterpolationType::Linear);
+                        }
+                      }});
   }
 
   // create distance transform
   if (params.get_fast_marching()) {
-    image.computeDT();
-    this->increment_progress(10);
-  }
-
-  if (this->abort_) {
-    return false;
+    stages.push_back({"dt", 10, true, [](Image& image) { image.computeDT(); }});
   }
 
   // blur
   if (params.get_blur_tool()) {
-    image.gaussianBlur(params.get_blur_amount());
-    this->increment_progress();
+    double sigma = params.get_blur_amount();
+    stages.push_back({fmt::format("blur {}", sigma), 1, true, [=](Image& image) { image.gaussianBlur(sigma); }});
+  }
+
+  // the final result is always cached
+  if (!stages.empty()) {
+    stages.back().cached = true;
+  }
+  return stages;
+}
+
+//---------------------------------------------------------------------------
+std::vector<std::string> Groom::get_image_stage_keys(const std::vector<ImageStage>& stages,
+                                                     const std::string& input_hash) {
+  std::vector<std::string> keys;
+  if (input_hash.empty()) {
+    return keys;
+  }
+
+  // each key covers the input and every stage up to and including its own
+  std::string description = "image " + input_hash;
+  for (const auto& stage : stages) {
+    description += " | " + stage.description;
+    keys.push_back(GroomCache::make_key(description));
+  }
+  return keys;
+}
+
+//---------------------------------------------------------------------------
+bool Groom::run_image_pipeline(Image& image, GroomParameters params, const std::vector<std::string>& keys,
+                               size_t first_stage) {
+  auto stages = this->get_image_stages(params);
+
+  for (size_t i = 0; i < stages.size(); i++) {
+    if (i >= first_stage) {
+      stages[i].apply(image);
+      if (this->cache_ && !keys.empty() && stages[i].cached) {
+        this->cache_->store(keys[i], image);
+      }
+    }
+    this->increment_progress(stages[i].progress);
+
+    if (this->abort_) {
+      return false;
+    }
   }
 
   return true;
@@ -271,8 +398,10 @@ bool Groom::mesh_pipeline(std::shared_ptr<Subject> subject, size_t domain) {
 
   auto original = subject->get_original_filenames()[domain];
 
-  // groomed mesh name
-  std::string groom_name = this->get_output_filename(original, DomainType::Mesh);
+  // groomed mesh (or distance transform) name
+  bool convert_to_dt = !params.get_skip_grooming() && params.get_convert_to_dt();
+  std::string groom_name =
+      this->get_output_filename(original, convert_to_dt ? DomainType::Image : DomainType::Mesh);
 
   Mesh mesh = MeshUtils::threadSafeReadMesh(original);
 
@@ -296,8 +425,14 @@ bool Groom::mesh_pipeline(std::shared_ptr<Subject> subject, size_t domain) {
     if (params.get_use_center()) {
       this->add_center_transform(transform, mesh);
     }
-    // save the groomed mesh
-    MeshUtils::threadSafeWriteMesh(groom_name, mesh);
+
+    if (convert_to_dt) {
+      // save the distance transform of the groomed mesh
+      this->run_mesh_to_dt(mesh, params).write(groom_name);
+    } else {
+      // save the groomed mesh
+      MeshUtils::threadSafeWriteMesh(groom_name, mesh);
+    }
   } else {
     groom_name = original;
   }
@@ -358,6 +493,20 @@ bool Groom::run_mesh_pipeline(Mesh& mesh, GroomParameters params) {
   return true;
 }
 
+//---------------------------------------------------------------------------
+Image Groom::run_mesh_to_dt(const Mesh& mesh, GroomParameters params) {
+  double spacing = params.get_dt_spacing();
+  double narrow_band = params.get_dt_narrow_band();
+
+  // pad enough for the band outside of the surface to fit in the image
+  unsigned pad = std::max<unsigned>(1, static_cast<unsigned>(std::ceil(narrow_band / spacing)));
+
+  Image image = mesh.toDistanceTransform(PhysicalRegion(), Point3({spacing, spacing, spacing}), Dims({pad, pad, pad}),
+                                         narrow_band);
+  this->increment_progress();
+  return image;
+}
+
 //---------------------------------------------------------------------------
 bool Groom::contour_pipeline(std::shared_ptr<Subject> subject, size_t domain) {
   // grab parameters
@@ -460,6 +609,10 @@ int Groom::get_total_ops() {
       num_tools += params.get_mesh_smooth() ? 1 : 0;
       num_tools += params.get_remesh() ? 1 : 0;
     }
+
+    if (project_->get_original_domain_types()[i] == DomainType::Mesh) {
+      num_tools += params.get_convert_to_dt() ? 1 : 0;
+    }
   }
 
   // +10 for alignment
@@ -509,7 +662,7 @@ bool Groom::run_alignment() {
         meshes.push_back(mesh);
       }
 
-      size_t reference_mesh = MeshUtils::findReferenceMesh(meshes);
+      size_t reference_mesh = MeshUtils::findReferenceMesh(meshes, params.get_alignment_reference_shortlist());
 
       auto transforms = Groom::get_icp_transforms(meshes, reference_mesh);
 
@@ -521,7 +674,7 @@ bool Groom::run_alignment() {
         landmarks.push_back(get_landmarks(i, domain));
       }
 
-      size_t reference = Groom::find_reference_landmarks(landmarks);
+      size_t reference = Groom::find_reference_landmarks(landmarks, params.get_alignment_reference_shortlist());
 
       auto transforms = Groom::get_landmark_transforms(landmarks, reference);
       assign_transforms(transforms, domain);
@@ -546,7 +699,7 @@ bool Groom::run_alignment() {
     }
 
     if (global_icp) {
-      size_t reference_mesh = MeshUtils::findReferenceMesh(meshes);
+      size_t reference_mesh = MeshUtils::findReferenceMesh(meshes, base_params.get_alignment_reference_shortlist());
       auto transforms = Groom::get_icp_transforms(meshes, reference_mesh);
       size_t domain = num_domains;  // end
       assign_transforms(transforms, domain, true /* global */);
@@ -554,7 +707,7 @@ bool Groom::run_alignment() {
     } else if (global_landmarks) {
       std::vector<vtkSmartPointer<vtkPoints>> landmarks = get_combined_points();
 
-      size_t reference = Groom::find_reference_landmarks(landmarks);
+      size_t reference = Groom::find_reference_landmarks(landmarks, base_params.get_alignment_reference_shortlist());
       auto transforms = Groom::get_landmark_transforms(landmarks, reference);
       size_t domain = num_domains;  // end
       assign_transforms(transforms, domain, true /* global */);
@@ -609,6 +762,24 @@ vtkSmartPointer<vtkMatrix4x4> Groom::compute_landmark_transform(vtkSmartPointer<
   return matrix;
 }
 
+//---------------------------------------------------------------------------
+std::string Groom::get_cache_directory(ProjectHandle project) {
+  auto params = GroomParameters(project);
+
+  // next to the groomed files
+  auto filename = project->get_filename();
+  auto base = StringUtils::getPath(filename);
+  if (filename == "" || base == filename) {
+    base = ".";
+  }
+
+  auto prefix = params.get_groom_output_prefix();
+  if (prefix != "") {
+    base = base + "/" + prefix;
+  }
+  return base + "/groom_cache";
+}
+
 //---------------------------------------------------------------------------
 std::string Groom::get_output_filename(std::string input, DomainType domain_type) {
   // lock for thread-safe member access
@@ -716,7 +887,63 @@ double Groom::compute_landmark_distance(vtkSmartPointer<vtkPoints> one, vtkSmart
 }
 
 //---------------------------------------------------------------------------
-int Groom::find_reference_landmarks(std::vector<vtkSmartPointer<vtkPoints>> landmarks) {
+double Groom::compute_registered_landmark_distance(vtkSmartPointer<vtkPoints> source,
+                                                   vtkSmartPointer<vtkPoints> target) {
+  auto matrix = Groom::compute_landmark_transform(source, target);
+
+  auto transform = createMeshTransform(matrix);
+
+  auto transformed = vtkSmartPointer<vtkPoints>::New();
+  transform->TransformPoints(source, transformed);
+
+  return Groom::compute_landmark_distance(target, transformed);
+}
+
+//---------------------------------------------------------------------------
+int Groom::find_reference_landmarks(std::vector<vtkSmartPointer<vtkPoints>> landmarks, int shortlist_size) {
+  if (shortlist_size > 0 && landmarks.size() > 1) {
+    // shortlist by the distances between the landmarks of each subject, normalized for scale as the landmark
+    // transform is a similarity transform
+    std::vector<Eigen::VectorXd> descriptors(landmarks.size());
+    for (size_t i = 0; i < landmarks.size(); i++) {
+      auto points = landmarks[i];
+      vtkIdType num_points = points->GetNumberOfPoints();
+      Eigen::VectorXd descriptor(num_points * (num_points - 1) / 2);
+      Eigen::Index k = 0;
+      for (vtkIdType a = 0; a < num_points; a++) {
+        // GetPoint(id) returns a pointer to a buffer shared by all calls, so copy each point out
+        double p[3], q[3];
+        points->GetPoint(a, p);
+        for (vtkIdType b = a + 1; b < num_points; b++) {
+          points->GetPoint(b, q);
+          descriptor[k++] = std::sqrt(vtkMath::Distance2BetweenPoints(p, q));
+        }
+      }
+      double norm = descriptor.norm();
+      descriptors[i] = norm > 0 ? Eigen::VectorXd(descriptor / norm) : descriptor;
+    }
+    if (std::any_of(descriptors.begin(), descriptors.end(),
+                    [&](const Eigen::VectorXd& d) { return d.size() != descriptors[0].size(); })) {
+      throw std::runtime_error("all subjects must have the same number of landmarks for alignment");
+    }
+    auto candidates = MeshUtils::findCentralDescriptors(descriptors, shortlist_size);
+
+    std::vector<double> means(candidates.size(), 0);
+    for (size_t c = 0; c < candidates.size(); c++) {
+      std::vector<double> distances(landmarks.size(), 0);
+      tbb::parallel_for(tbb::blocked_range<size_t>{0, landmarks.size()}, [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t i = r.begin(); i < r.end(); ++i) {
+          if (i != candidates[c]) {
+            distances[i] = Groom::compute_registered_landmark_distance(landmarks[i], landmarks[candidates[c]]);
+          }
+        }
+      });
+      means[c] = std::accumulate(distances.begin(), distances.end(), 0.0) / (landmarks.size() - 1);
+    }
+
+    return candidates[std::distance(means.begin(), std::min_element(means.begin(), means.end()))];
+  }
+
   std::vector<std::pair<int, int>> pairs;
 
   // enumerate all pairs
@@ -735,15 +962,8 @@ int Groom::find_reference_landmarks(std::vector<vtkSmartPointer<vtkPoints>> land
     for (size_t i = r.begin(); i < r.end(); ++i) {
       auto pair = pairs[i];
 
-      auto matrix = Groom::compute_landmark_transform(landmarks[pair.first], landmarks[pair.second]);
-
-      auto transform = createMeshTransform(matrix);
-
-      auto transformed = vtkSmartPointer<vtkPoints>::New();
-      transform->TransformPoints(landmarks[pair.first], transformed);
-
       // compute distance
-      double distance = Groom::compute_landmark_distance(landmarks[pair.second], transformed);
+      double distance = Groom::compute_registered_landmark_distance(landmarks[pair.first], landmarks[pair.second]);
       {
         // lock and store results
         std::scoped_lock lock(mutex);
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "GroomCache.h"
 #include "GroomParameters.h"
+#include "GroomScheduler.h"
 #include <Image/Image.h>
 #include <Project/Project.h>
 
@@ -32,11 +34,26 @@ class Groom {
   static vtkSmartPointer<vtkMatrix4x4> compute_landmark_transform(vtkSmartPointer<vtkPoints> source,
                                                                   vtkSmartPointer<vtkPoints> target);
 
+  //! Directory of the groom cache of a project
+  static std::string get_cache_directory(ProjectHandle project);
+
+  //! Number of image stages the last run restored from the groom cache instead of running them
+  int get_cached_stage_count() const { return cached_stage_count_; }
+
+  //! Util to compute the square distance between paired landmarks after transforming source onto target
+  static double compute_registered_landmark_distance(vtkSmartPointer<vtkPoints> source,
+                                                     vtkSmartPointer<vtkPoints> target);
+
+  //! Index of the subject whose landmarks have the smallest mean distance to the others after registration.  If
+  //! shortlist_size is positive, only that many candidates (by their inter-landmark distances) are registered
+  static int find_reference_landmarks(std::vector<vtkSmartPointer<vtkPoints>> landmarks, int shortlist_size = 0);
+
  protected:
 
   std::atomic<float> progress_ = 0;
   std::atomic<int> total_ops_ = 0;
   std::atomic<int> progress_counter_ = 0;
+  std::atomic<int> cached_stage_count_ = 0;
 
  private:
   //! Return the number of operations that will be performed
@@ -45,16 +62,45 @@ class Groom {
   //! Increment the progress one step
   void increment_progress(int amount = 1);
 
-  //! Run image based pipeline on a single subject
-  bool image_pipeline(std::shared_ptr<Subject> subject, size_t domain);
+  //! Create the job that reads, grooms and writes an image domain of a single subject
+  GroomScheduler::Job create_image_job(std::shared_ptr<Subject> subject, size_t domain);
+
+  //! Estimated peak memory of grooming an image
+  static size_t estimate_image_footprint(const std::string& filename, GroomParameters params);
+
+  //! Estimated peak memory of grooming a mesh or contour
+  static size_t estimate_mesh_footprint(const std::string& filename);
 
-  bool run_image_pipeline(Image& image, GroomParameters params);
+  //! One step of the image pipeline
+  struct ImageStage {
+    //! name and parameters, which determine the output of the stage from its input
+    std::string description;
+    //! progress steps of the stage
+    int progress;
+    //! whether the output of the stage is kept in the groom cache
+    bool cached;
+    std::function<void(Image&)> apply;
+  };
+
+  //! The enabled image pipeline stages, in order
+  std::vector<ImageStage> get_image_stages(GroomParameters params);
+
+  //! Groom cache key of the output of each stage, empty if the input can't be hashed
+  static std::vector<std::string> get_image_stage_keys(const std::vector<ImageStage>& stages,
+                                                       const std::string& input_hash);
+
+  //! Run the image pipeline from first_stage on, storing the cached stages under keys
+  bool run_image_pipeline(Image& image, GroomParameters params, const std::vector<std::string>& keys = {},
+                          size_t first_stage = 0);
 
   //! Run the mesh based pipeline on a single subject
   bool mesh_pipeline(std::shared_ptr<Subject> subject, size_t domain);
 
   bool run_mesh_pipeline(Mesh& mesh, GroomParameters params);
 
+  //! Compute the distance transform of a groomed mesh
+  Image run_mesh_to_dt(const Mesh& mesh, GroomParameters params);
+
   //! Run the contour based pipeline on a single subject
   bool contour_pipeline(std::shared_ptr<Subject> subject, size_t domain);
 
@@ -81,8 +127,6 @@ class Groom {
 
   vtkSmartPointer<vtkPoints> get_landmarks(int subject, int domain);
 
-  int find_reference_landmarks(std::vector<vtkSmartPointer<vtkPoints>> landmarks);
-
   void fix_origin(Image& image);
 
   bool verbose_ = false;
@@ -94,5 +138,8 @@ class Groom {
   std::mutex mutex_;
 
   std::set<std::string> used_names_;
+
+  //! intermediate image results, null if the groom cache is disabled
+  std::unique_ptr<GroomCache> cache_;
 };
 }  // namespace shapeworks
@@ -0,0 +1,178 @@
+#include "GroomCache.h"
+
+#include <Logging.h>
+
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <random>
+#include <vector>
+
+namespace fs = boost::filesystem;
+
+namespace shapeworks {
+
+namespace {
+const std::string extension = ".nrrd";
+
+//! 64 bit FNV-1a hash, continuing from hash
+uint64_t fnv1a(const char* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+  for (size_t i = 0; i < size; i++) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+std::string to_hex(uint64_t value) { return fmt::format("{:016x}", value); }
+
+//! Cache entries, most recently used first
+std::vector<fs::path> list_entries(const std::string& directory) {
+  std::vector<std::pair<std::time_t, fs::path>> entries;
+  boost::system::error_code error;
+  for (fs::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+    // skip the temporary files of entries being written
+    if (fs::is_regular_file(it->path()) && it->path().extension() == extension &&
+        it->path().stem().extension() != ".tmp") {
+      boost::system::error_code time_error;
+      auto time = fs::last_write_time(it->path(), time_error);
+      if (!time_error) {
+        entries.emplace_back(time, it->path());
+      }
+    }
+  }
+  std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+  std::vector<fs::path> paths;
+  for (const auto& entry : entries) {
+    paths.push_back(entry.second);
+  }
+  return paths;
+}
+}  // namespace
+
+//---------------------------------------------------------------------------
+GroomCache::GroomCache(std::string directory, size_t max_bytes) : directory_(directory), max_bytes_(max_bytes) {
+  fs::create_directories(directory_);
+  size_ = get_size();
+}
+
+//---------------------------------------------------------------------------
+std::string GroomCache::hash_file(const std::string& filename) {
+  if (!fs::is_regular_file(filename)) {
+    return "";
+  }
+
+  std::ifstream in(filename, std::ios::binary);
+  std::vector<char> buffer(1 << 20);
+  uint64_t hash = fnv1a(nullptr, 0);
+  uint64_t size = 0;
+  while (in) {
+    in.read(buffer.data(), buffer.size());
+    hash = fnv1a(buffer.data(), in.gcount(), hash);
+    size += in.gcount();
+  }
+  return to_hex(hash) + "-" + std::to_string(size);
+}
+
+//---------------------------------------------------------------------------
+std::string GroomCache::make_key(const std::string& description) {
+  // two differently seeded hashes, so that unrelated descriptions don't collide in practice
+  uint64_t first = fnv1a(description.data(), description.size());
+  uint64_t second = fnv1a(description.data(), description.size(), first ^ 0x9e3779b97f4a7c15ull);
+  return to_hex(first) + to_hex(second);
+}
+
+//---------------------------------------------------------------------------
+std::unique_ptr<Image> GroomCache::load(const std::string& key) {
+  auto filename = get_filename(key);
+  if (!fs::exists(filename)) {
+    return nullptr;
+  }
+
+  std::unique_ptr<Image> image;
+  try {
+    image = std::make_unique<Image>(filename);
+  } catch (std::exception& e) {
+    SW_WARN("Unable to read groom cache entry {}: {}", filename, e.what());
+    return nullptr;
+  }
+
+  // mark as recently used
+  boost::system::error_code error;
+  fs::last_write_time(filename, std::time(nullptr), error);
+  return image;
+}
+
+//---------------------------------------------------------------------------
+void GroomCache::store(const std::string& key, Image& image) {
+  auto filename = get_filename(key);
+
+  // write to a temporary file first so that a reader never sees a partial entry
+  std::random_device random;
+  auto temporary = directory_ + "/" + key + "." + to_hex((uint64_t(random()) << 32) | random()) + ".tmp" + extension;
+  try {
+    image.write(temporary);
+    fs::rename(temporary, filename);
+  } catch (std::exception& e) {
+    SW_WARN("Unable to write groom cache entry {}: {}", filename, e.what());
+    boost::system::error_code error;
+    fs::remove(temporary, error);
+    return;
+  }
+
+  boost::system::error_code error;
+  auto size = fs::file_size(filename, error);
+
+  std::scoped_lock lock(mutex_);
+  size_ += error ? 0 : size;
+  if (max_bytes_ > 0 && size_ > max_bytes_) {
+    remove_entries(max_bytes_);
+  }
+}
+
+//---------------------------------------------------------------------------
+void GroomCache::prune(size_t max_bytes) {
+  std::scoped_lock lock(mutex_);
+  remove_entries(max_bytes);
+}
+
+//---------------------------------------------------------------------------
+void GroomCache::clear() { prune(0); }
+
+//---------------------------------------------------------------------------
+void GroomCache::remove_entries(size_t max_bytes) {
+  size_t total = 0;
+  for (const auto& path : list_entries(directory_)) {
+    boost::system::error_code error;
+    auto size = fs::file_size(path, error);
+    if (error) {
+      continue;
+    }
+    if (total + size > max_bytes) {
+      fs::remove(path, error);
+    } else {
+      total += size;
+    }
+  }
+  size_ = total;
+}
+
+//---------------------------------------------------------------------------
+size_t GroomCache::get_size() const {
+  size_t total = 0;
+  for (const auto& path : list_entries(directory_)) {
+    boost::system::error_code error;
+    auto size = fs::file_size(path, error);
+    total += error ? 0 : size;
+  }
+  return total;
+}
+
+//---------------------------------------------------------------------------
+size_t GroomCache::get_count() const { return list_entries(directory_).size(); }
+
+//---------------------------------------------------------------------------
+std::string GroomCache::get_filename(const std::string& key) const { return directory_ + "/" + key + extension; }
+
+}  // namespace shapeworks
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Image/Image.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace shapeworks {
+
+/**
+ * \class GroomCache
+ * \ingroup Group-Groom
+ *
+ * A size bounded, content addressed store of intermediate groom results.
+ *
+ * Each entry is an image stored under a key made from the hash of the input
+ * file and the description of every groom stage that produced it, so an entry
+ * is found again only for the same input groomed with the same upstream
+ * parameters.  Entries are written atomically, and once the directory grows
+ * past its size limit the least recently used entries are removed.
+ */
+class GroomCache {
+ public:
+  //! max_bytes of 0 leaves the size unbounded
+  GroomCache(std::string directory, size_t max_bytes);
+
+  //! Content hash of a file, empty if it is not a regular file (e.g. a DICOM directory)
+  static std::string hash_file(const std::string& filename);
+
+  //! Key of a result from its description, the input hash followed by the stages that produced it
+  static std::string make_key(const std::string& description);
+
+  //! Load the entry stored under key, null if there is none
+  std::unique_ptr<Image> load(const std::string& key);
+
+  //! Store image under key, removing old entries if the cache grows past its limit
+  void store(const std::string& key, Image& image);
+
+  //! Remove the least recently used entries until the cache is within max_bytes
+  void prune(size_t max_bytes);
+
+  //! Remove every entry
+  void clear();
+
+  //! Total size of the entries in bytes
+  size_t get_size() const;
+
+  //! Number of entries
+  size_t get_count() const;
+
+  std::string get_directory() const { return directory_; }
+
+ private:
+  std::string get_filename(const std::string& key) const;
+
+  //! Remove the least recently used entries until the cache is within max_bytes, mutex_ must be held
+  void remove_entries(size_t max_bytes);
+
+  std::string directory_;
+  size_t max_bytes_;
+  //! tracked size of the entries, to know when to prune without listing the directory
+  size_t size_ = 0;
+  std::mutex mutex_;
+};
+
+}  // namespace shapeworks
@@ -22,6 +22,9 @@ const std::string ISOTROPIC = "isotropic";
 const std::string ISO_SPACING = "iso_spacing";
 const std::string SPACING = "spacing";
 const std::string CONVERT_MESH = "convert_to_mesh";
+const std::string CONVERT_TO_DT = "convert_to_dt";
+const std::string DT_SPACING = "dt_spacing";
+const std::string DT_NARROW_BAND = "dt_narrow_band";
 const std::string FILL_MESH_HOLES = "fill_mesh_holes";
 const std::string FILL_HOLES = "fill_holes";
 const std::string ISOLATE = "isolate";
@@ -42,7 +45,11 @@ const std::string MESH_SMOOTHING_VTK_WINDOWED_SINC_PASSBAND = "mesh_smoothing_vt
 
 const std::string ALIGNMENT_METHOD = "alignment_method";
 const std::string ALIGNMENT_ENABLED = "alignment_enabled";
+const std::string ALIGNMENT_REFERENCE_SHORTLIST = "alignment_reference_shortlist";
 const std::string GROOM_OUTPUT_PREFIX = "groom_output_prefix";
+const std::string GROOM_MEMORY_BUDGET = "groom_memory_budget";
+const std::string GROOM_CACHE = "groom_cache";
+const std::string GROOM_CACHE_SIZE = "groom_cache_size";
 const std::string REMESH = "remesh";
 const std::string REMESH_PERCENT_MODE = "remesh_percent_mode";
 const std::string REMESH_PERCENT = "remesh_percent";
@@ -66,6 +73,9 @@ const bool isotropic = true;
 const double iso_spacing = 0.0;
 const std::vector<double> spacing{0, 0, 0};
 const bool convert_mesh = false;
+const bool convert_to_dt = false;
+const double dt_spacing = 1.0;
+const double dt_narrow_band = 0.0;
 const bool fill_holes = true;
 const bool fill_holes_mesh = false;
 const bool isolate = true;
@@ -77,6 +87,9 @@ const bool blur = true;
 const double blur_sigma = 2.0;
 const bool fastmarching = true;
 const char* groom_output_prefix = "groomed";
+const double groom_memory_budget = 0.0;
+const bool groom_cache = false;
+const double groom_cache_size = 10240.0;
 const bool mesh_smooth = false;
 const std::string mesh_smoothing_method = GroomParameters::GROOM_SMOOTH_VTK_LAPLACIAN_C;
 const int mesh_smoothing_vtk_laplacian_iterations = 10;
@@ -85,6 +98,7 @@ const int mesh_smoothing_vtk_windowed_sinc_iterations = 10;
 const double mesh_smoothing_vtk_windowed_sinc_passband = 0.05;
 const std::string alignment_method = GroomParameters::GROOM_ALIGNMENT_ICP_C;
 const bool alignment_enabled = true;
+const int alignment_reference_shortlist = 0;
 const bool remesh = true;
 
 const bool remesh_percent_mode = true;
@@ -112,6 +126,9 @@ GroomParameters::GroomParameters(ProjectHandle project, std::string domain_name)
                                          Keys::ISO_SPACING,
                                          Keys::SPACING,
                                          Keys::CONVERT_MESH,
+                                         Keys::CONVERT_TO_DT,
+                                         Keys::DT_SPACING,
+                                         Keys::DT_NARROW_BAND,
                                          Keys::FILL_MESH_HOLES,
                                          Keys::FILL_HOLES,
                                          Keys::ISOLATE,
@@ -130,7 +147,11 @@ GroomParameters::GroomParameters(ProjectHandle project, std::string domain_name)
                                          Keys::MESH_SMOOTHING_VTK_WINDOWED_SINC_PASSBAND,
                                          Keys::ALIGNMENT_METHOD,
                                          Keys::ALIGNMENT_ENABLED,
+                                         Keys::ALIGNMENT_REFERENCE_SHORTLIST,
                                          Keys::GROOM_OUTPUT_PREFIX,
+                                         Keys::GROOM_MEMORY_BUDGET,
+                                         Keys::GROOM_CACHE,
+                                         Keys::GROOM_CACHE_SIZE,
                                          Keys::REMESH,
                                          Keys::REMESH_PERCENT_MODE,
                                          Keys::REMESH_PERCENT,
@@ -230,6 +251,28 @@ std::string GroomParameters::get_groom_output_prefix() {
 //---------------------------------------------------------------------------
 void GroomParameters::set_groom_output_prefix(std::string prefix) { params_.set(Keys::GROOM_OUTPUT_PREFIX, prefix); }
 
+//---------------------------------------------------------------------------
+double GroomParameters::get_groom_memory_budget() {
+  return params_.get(Keys::GROOM_MEMORY_BUDGET, Defaults::groom_memory_budget);
+}
+
+//---------------------------------------------------------------------------
+void GroomParameters::set_groom_memory_budget(double megabytes) { params_.set(Keys::GROOM_MEMORY_BUDGET, megabytes); }
+
+//---------------------------------------------------------------------------
+bool GroomParameters::get_groom_cache() { return params_.get(Keys::GROOM_CACHE, Defaults::groom_cache); }
+
+//---------------------------------------------------------------------------
+void GroomParameters::set_groom_cache(bool value) { params_.set(Keys::GROOM_CACHE, value); }
+
+//---------------------------------------------------------------------------
+double GroomParameters::get_groom_cache_size() {
+  return params_.get(Keys::GROOM_CACHE_SIZE, Defaults::groom_cache_size);
+}
+
+//---------------------------------------------------------------------------
+void GroomParameters::set_groom_cache_size(double megabytes) { params_.set(Keys::GROOM_CACHE_SIZE, megabytes); }
+
 //---------------------------------------------------------------------------
 bool GroomParameters::get_groom_all_domains_the_same() {
   return params_.get(Keys::GROOM_ALL_DOMAINS_THE_SAME, Defaults::groom_all_domains_the_same);
@@ -325,6 +368,16 @@ bool GroomParameters::get_alignment_enabled() {
 //---------------------------------------------------------------------------
 void GroomParameters::set_alignment_enabled(bool value) { params_.set(Keys::ALIGNMENT_ENABLED, value); }
 
+//---------------------------------------------------------------------------
+int GroomParameters::get_alignment_reference_shortlist() {
+  return params_.get(Keys::ALIGNMENT_REFERENCE_SHORTLIST, Defaults::alignment_reference_shortlist);
+}
+
+//---------------------------------------------------------------------------
+void GroomParameters::set_alignment_reference_shortlist(int shortlist_size) {
+  params_.set(Keys::ALIGNMENT_REFERENCE_SHORTLIST, shortlist_size);
+}
+
 //---------------------------------------------------------------------------
 bool GroomParameters::get_use_icp() {
   return get_alignment_enabled() && get_alignment_method() == GROOM_ALIGNMENT_ICP_C;
@@ -352,6 +405,24 @@ bool GroomParameters::get_convert_to_mesh() { return params_.get(Keys::CONVERT_M
 //---------------------------------------------------------------------------
 void GroomParameters::set_convert_to_mesh(bool value) { params_.set(Keys::CONVERT_MESH, value); }
 
+//---------------------------------------------------------------------------
+bool GroomParameters::get_convert_to_dt() { return params_.get(Keys::CONVERT_TO_DT, Defaults::convert_to_dt); }
+
+//---------------------------------------------------------------------------
+void GroomParameters::set_convert_to_dt(bool value) { params_.set(Keys::CONVERT_TO_DT, value); }
+
+//---------------------------------------------------------------------------
+double GroomParameters::get_dt_spacing() { return params_.get(Keys::DT_SPACING, Defaults::dt_spacing); }
+
+//---------------------------------------------------------------------------
+void GroomParameters::set_dt_spacing(double spacing) { params_.set(Keys::DT_SPACING, spacing); }
+
+//---------------------------------------------------------------------------
+double GroomParameters::get_dt_narrow_band() { return params_.get(Keys::DT_NARROW_BAND, Defaults::dt_narrow_band); }
+
+//---------------------------------------------------------------------------
+void GroomParameters::set_dt_narrow_band(double narrow_band) { params_.set(Keys::DT_NARROW_BAND, narrow_band); }
+
 //---------------------------------------------------------------------------
 bool GroomParameters::get_reflect() { return params_.get(Keys::REFLECT, Defaults::reflect); }
 
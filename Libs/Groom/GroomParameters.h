@@ -23,6 +23,17 @@ class GroomParameters {
   std::string get_groom_output_prefix();
   void set_groom_output_prefix(std::string prefix);
 
+  // estimated memory (in MB) of the subjects being groomed at once, 0 for no budget
+  double get_groom_memory_budget();
+  void set_groom_memory_budget(double megabytes);
+
+  // keep intermediate image groom results in a cache of at most groom_cache_size MB, so that re-grooming restarts
+  // from the last stage whose parameters are unchanged
+  bool get_groom_cache();
+  void set_groom_cache(bool value);
+  double get_groom_cache_size();
+  void set_groom_cache_size(double megabytes);
+
   bool get_groom_all_domains_the_same();
   void set_groom_all_domains_the_same(bool value);
 
@@ -80,6 +91,11 @@ class GroomParameters {
   double get_mesh_vtk_windowed_sinc_passband();
   void set_mesh_vtk_windowed_sinc_passband(double passband);
 
+  // number of candidates registered against all subjects when choosing the alignment reference, 0 registers every
+  // pair of subjects
+  int get_alignment_reference_shortlist();
+  void set_alignment_reference_shortlist(int shortlist_size);
+
   bool get_use_icp();
   bool get_use_center();
   bool get_use_landmarks();
@@ -90,6 +106,15 @@ class GroomParameters {
   bool get_convert_to_mesh();
   void set_convert_to_mesh(bool value);
 
+  // groom meshes into distance transforms (isotropic dt_spacing), only computing exact distances within
+  // dt_narrow_band of the surface if it is positive
+  bool get_convert_to_dt();
+  void set_convert_to_dt(bool value);
+  double get_dt_spacing();
+  void set_dt_spacing(double spacing);
+  double get_dt_narrow_band();
+  void set_dt_narrow_band(double narrow_band);
+
   // reflection
   bool get_reflect();
   void set_reflect(bool reflect);
@@ -0,0 +1,201 @@
+#include "GroomScheduler.h"
+
+#include <Logging.h>
+#include <tbb/task_arena.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace shapeworks {
+
+//---------------------------------------------------------------------------
+GroomScheduler::GroomScheduler(size_t memory_budget, size_t compute_threads) : memory_budget_(memory_budget) {
+  compute_threads_ = compute_threads > 0 ? compute_threads : tbb::this_task_arena::max_concurrency();
+  compute_threads_ = std::max<size_t>(1, compute_threads_);
+  // one job being read and one being written in addition to those being processed
+  max_in_flight_ = compute_threads_ + 2;
+}
+
+//---------------------------------------------------------------------------
+bool GroomScheduler::run(std::vector<Job>& jobs, const std::function<bool()>& aborted) {
+  process_queue_.clear();
+  write_queue_.clear();
+  reading_done_ = false;
+  processing_ = 0;
+  in_flight_ = 0;
+  admitted_bytes_ = 0;
+  peak_admitted_bytes_ = 0;
+  completed_ = 0;
+  success_ = true;
+  exception_ = nullptr;
+  statistics_ = {{"read"}, {"process"}, {"write"}};
+
+  auto start = std::chrono::steady_clock::now();
+
+  std::thread reader(&GroomScheduler::read_loop, this, std::ref(jobs), std::cref(aborted));
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < compute_threads_; i++) {
+    workers.emplace_back(&GroomScheduler::process_loop, this, std::ref(jobs));
+  }
+  std::thread writer(&GroomScheduler::write_loop, this, std::ref(jobs));
+
+  reader.join();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  writer.join();
+
+  wall_seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  if (exception_) {
+    std::rethrow_exception(exception_);
+  }
+  return success_;
+}
+
+//---------------------------------------------------------------------------
+std::vector<GroomScheduler::StageStatistics> GroomScheduler::get_statistics() const { return statistics_; }
+
+//---------------------------------------------------------------------------
+void GroomScheduler::log_statistics() const {
+  for (const auto& stage : statistics_) {
+    SW_LOG("Groom {} stage: {} jobs, {:.2f}s busy, {:.2f} jobs/s per thread", stage.name, stage.count, stage.seconds,
+           stage.seconds > 0 ? stage.count / stage.seconds : 0.0);
+  }
+  SW_LOG("Groom: {} jobs in {:.2f}s, {:.2f} jobs/s, peak admitted footprint {:.1f} MB", completed_, wall_seconds_,
+         wall_seconds_ > 0 ? completed_ / wall_seconds_ : 0.0, peak_admitted_bytes_ / (1024.0 * 1024.0));
+}
+
+//---------------------------------------------------------------------------
+void GroomScheduler::read_loop(std::vector<Job>& jobs, const std::function<bool()>& aborted) {
+  for (auto& job : jobs) {
+    if (aborted()) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      success_ = false;
+      continue;
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      changed_.wait(lock, [&] {
+        return in_flight_ == 0 || (in_flight_ < max_in_flight_ &&
+                                   (memory_budget_ == 0 || admitted_bytes_ + job.footprint <= memory_budget_));
+      });
+      in_flight_++;
+      admitted_bytes_ += job.footprint;
+      peak_admitted_bytes_ = std::max(peak_admitted_bytes_, admitted_bytes_);
+    }
+
+    if (!run_stage(Read, job.read)) {
+      finish(job, false);
+      continue;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      process_queue_.push_back(&job - jobs.data());
+    }
+    changed_.notify_all();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reading_done_ = true;
+  }
+  changed_.notify_all();
+}
+
+//---------------------------------------------------------------------------
+void GroomScheduler::process_loop(std::vector<Job>& jobs) {
+  while (true) {
+    size_t index;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      changed_.wait(lock, [&] { return !process_queue_.empty() || reading_done_; });
+      if (process_queue_.empty()) {
+        return;
+      }
+      index = process_queue_.front();
+      process_queue_.pop_front();
+      processing_++;
+    }
+
+    bool success = run_stage(Process, jobs[index].process);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      processing_--;
+      if (success) {
+        write_queue_.push_back(index);
+      }
+    }
+    if (!success) {
+      finish(jobs[index], false);
+    }
+    changed_.notify_all();
+  }
+}
+
+//---------------------------------------------------------------------------
+void GroomScheduler::write_loop(std::vector<Job>& jobs) {
+  while (true) {
+    size_t index;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      changed_.wait(lock, [&] {
+        return !write_queue_.empty() || (reading_done_ && process_queue_.empty() && processing_ == 0);
+      });
+      if (write_queue_.empty()) {
+        return;
+      }
+      index = write_queue_.front();
+      write_queue_.pop_front();
+    }
+
+    finish(jobs[index], run_stage(Write, jobs[index].write));
+  }
+}
+
+//---------------------------------------------------------------------------
+bool GroomScheduler::run_stage(Stage stage, const std::function<bool()>& function) {
+  if (!function) {
+    return true;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  bool success = false;
+  try {
+    success = function();
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!exception_) {
+      exception_ = std::current_exception();
+    }
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  statistics_[stage].count++;
+  statistics_[stage].seconds += seconds;
+  return success;
+}
+
+//---------------------------------------------------------------------------
+void GroomScheduler::finish(Job& job, bool success) {
+  size_t footprint = job.footprint;
+  job = Job();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    in_flight_--;
+    admitted_bytes_ -= footprint;
+    if (success) {
+      completed_++;
+    } else {
+      success_ = false;
+    }
+  }
+  changed_.notify_all();
+}
+
+}  // namespace shapeworks
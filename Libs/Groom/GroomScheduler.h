@@ -0,0 +1,93 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace shapeworks {
+
+/**
+ * \class GroomScheduler
+ * \ingroup Group-Groom
+ *
+ * Streams groom jobs through a read, a compute and a write stage.
+ *
+ * One thread reads, a pool of threads computes and one thread writes, so file
+ * I/O overlaps with the processing of other jobs.  Jobs are admitted (read) in
+ * order, only while the estimated footprint of the admitted but unwritten jobs
+ * fits in the memory budget.  A job that is larger than the budget on its own
+ * is admitted once nothing else is in flight.  The stages of a job are
+ * released as soon as it is written, freeing the data they captured before
+ * its memory is returned to the budget.
+ */
+class GroomScheduler {
+ public:
+  //! A unit of work, e.g. one domain of one subject.  A stage returning false fails the job and skips its other stages.
+  struct Job {
+    //! estimated peak memory of the job in bytes
+    size_t footprint = 0;
+    std::function<bool()> read;
+    std::function<bool()> process;
+    std::function<bool()> write;
+  };
+
+  //! Time spent in one stage
+  struct StageStatistics {
+    std::string name;
+    size_t count = 0;
+    double seconds = 0;
+  };
+
+  //! memory_budget in bytes, 0 for no budget.  compute_threads of 0 uses the TBB concurrency.
+  GroomScheduler(size_t memory_budget, size_t compute_threads = 0);
+
+  //! Run every job, jobs not yet admitted when aborted returns true are failed.  Returns false if any job failed.
+  //! The first exception thrown by a stage is rethrown once all stages have stopped.
+  bool run(std::vector<Job>& jobs, const std::function<bool()>& aborted);
+
+  //! Statistics of the read, process and write stages of the last run
+  std::vector<StageStatistics> get_statistics() const;
+
+  //! Log the time, throughput and peak admitted footprint of the last run
+  void log_statistics() const;
+
+ private:
+  enum Stage { Read = 0, Process, Write, NumStages };
+
+  void read_loop(std::vector<Job>& jobs, const std::function<bool()>& aborted);
+  void process_loop(std::vector<Job>& jobs);
+  void write_loop(std::vector<Job>& jobs);
+
+  //! Run one stage of a job, returns false if it failed or threw
+  bool run_stage(Stage stage, const std::function<bool()>& function);
+
+  //! Release the memory of a job that is done, successfully or not
+  void finish(Job& job, bool success);
+
+  size_t memory_budget_;
+  size_t compute_threads_;
+  //! at most this many jobs are admitted but not written, even without a memory budget
+  size_t max_in_flight_;
+
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::deque<size_t> process_queue_;
+  std::deque<size_t> write_queue_;
+  bool reading_done_ = false;
+  size_t processing_ = 0;
+  size_t in_flight_ = 0;
+  size_t admitted_bytes_ = 0;
+  size_t peak_admitted_bytes_ = 0;
+  size_t completed_ = 0;
+  bool success_ = true;
+  std::exception_ptr exception_;
+
+  std::vector<StageStatistics> statistics_;
+  double wall_seconds_ = 0;
+};
+
+}  // namespace shapeworks
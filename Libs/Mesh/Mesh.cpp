@@ -63,6 +63,7 @@
 #include "Libs/Optimize/Domain/VtkMeshWrapper.h"
 #include "Logging.h"
 #include "MeshComputeThickness.h"
+#include "MeshDistanceTransform.h"
 #include "MeshUtils.h"
 #include "PreviewMeshQC/FEAreaCoverage.h"
 #include "PreviewMeshQC/FEVTKExport.h"
@@ -772,6 +773,15 @@ double Mesh::geodesicDistance(int source, int target) const {
   return wrap.ComputeDistance(getPoint(source), -1, getPoint(target), -1);
 }
 
+//! the points of every vertex of a mesh
+static std::vector<Point3> vertexPoints(vtkPolyData* poly_data) {
+  std::vector<Point3> points(poly_data->GetNumberOfPoints());
+  for (vtkIdType i = 0; i < poly_data->GetNumberOfPoints(); i++) {
+    poly_data->GetPoint(i, points[i].GetDataPointer());
+  }
+  return points;
+}
+
 Field Mesh::geodesicDistance(const Point3 landmark) const {
   auto distance = vtkSmartPointer<vtkDoubleArray>::New();
   distance->SetNumberOfComponents(1);
@@ -779,10 +789,11 @@ Field Mesh::geodesicDistance(const Point3 landmark) const {
   distance->SetName("GeodesicDistanceToLandmark");
 
   VtkMeshWrapper wrap(this->poly_data_, true);
-
-  for (int i = 0; i < numPoints(); i++) {
-    distance->SetValue(i, wrap.ComputeDistance(landmark, -1, getPoint(i), -1));
-  }
+  wrap.ComputeDistancesToPoints({landmark}, vertexPoints(poly_data_), [&](size_t, const Eigen::VectorXd& distances) {
+    for (int i = 0; i < numPoints(); i++) {
+      distance->SetValue(i, distances[i]);
+    }
+  });
 
   return distance;
 }
@@ -794,12 +805,13 @@ Field Mesh::geodesicDistance(const std::vector<Point3> curve) const {
   minDistance->SetName("GeodesicDistanceToCurve");
   minDistance->Fill(1e20);
 
-  for (int i = 0; i < curve.size(); i++) {
-    Field distance = geodesicDistance(curve[i]);
+  // one wrapper (and factorization of the mesh) for all points of the curve
+  VtkMeshWrapper wrap(this->poly_data_, true);
+  wrap.ComputeDistancesToPoints(curve, vertexPoints(poly_data_), [&](size_t, const Eigen::VectorXd& distances) {
     for (int j = 0; j < numPoints(); j++) {
-      if (distance->GetTuple1(j) < minDistance->GetTuple1(j)) minDistance->SetValue(j, distance->GetTuple1(j));
+      if (distances[j] < minDistance->GetValue(j)) minDistance->SetValue(j, distances[j]);
     }
-  }
+  });
 
   return minDistance;
 }
@@ -1068,7 +1080,8 @@ Image Mesh::toImage(PhysicalRegion region, Point3 spacing) const {
   return Image(imgstenc->GetOutput());
 }
 
-Image Mesh::toDistanceTransform(PhysicalRegion region, const Point3 spacing, const Dims padding) const {
+Image Mesh::toDistanceTransform(PhysicalRegion region, const Point3 spacing, const Dims padding,
+                                double narrow_band) const {
   this->updateCellLocator();
 
   // if no region, use mesh bounding box
@@ -1085,6 +1098,11 @@ Image Mesh::toDistanceTransform(PhysicalRegion region, const Point3 spacing, con
   auto origin = region.min - spacing * toPoint(padding);
   img.setOrigin(origin);
 
+  if (narrow_band > 0.0) {
+    mesh::compute_narrow_band_distance(*this, img, narrow_band);
+    return img;
+  }
+
   auto itkimg = img.getITKImage();
 
   using IteratorType = itk::ImageRegionIterator<Image::ImageType>;
@@ -1134,11 +1152,19 @@ Mesh& Mesh::computeThickness(Image& image, Image* dt, double max_dist, std::stri
 }
 
 Mesh& Mesh::computeLandmarkGeodesics(const std::vector<Point3>& landmarks) {
-  for (int i = 0; i < landmarks.size(); i++) {
-    auto field = geodesicDistance(landmarks[i]);
+  // one wrapper (and factorization of the mesh) for all landmarks
+  VtkMeshWrapper wrap(this->poly_data_, true);
+  wrap.ComputeDistancesToPoints(landmarks, vertexPoints(poly_data_), [&](size_t i, const Eigen::VectorXd& distances) {
+    auto field = vtkSmartPointer<vtkDoubleArray>::New();
+    field->SetNumberOfComponents(1);
+    field->SetNumberOfTuples(numPoints());
+    field->SetName("GeodesicDistanceToLandmark");
+    for (int j = 0; j < numPoints(); j++) {
+      field->SetValue(j, distances[j]);
+    }
     std::string name = "geodesic_distance_to_" + std::to_string(i);
     setField(name, field, Mesh::FieldType::Point);
-  }
+  });
   return *this;
 }
 
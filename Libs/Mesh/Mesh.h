@@ -177,9 +177,11 @@ class Mesh {
   /// rasterizes specified region to create binary image of desired dims (default: unit spacing)
   Image toImage(PhysicalRegion region = PhysicalRegion(), Point3 spacing = Point3({1., 1., 1.})) const;
 
-  /// converts specified region to distance transform image (default: unit spacing) with (logical) padding
+  /// converts specified region to distance transform image (default: unit spacing) with (logical) padding.
+  /// If narrow_band is positive, exact distances are only computed within narrow_band of the surface and the
+  /// remaining voxels are set to +/- narrow_band.
   Image toDistanceTransform(PhysicalRegion region = PhysicalRegion(), const Point3 spacing = Point3({1., 1., 1.}),
-                            const Dims padding = Dims({1, 1, 1})) const;
+                            const Dims padding = Dims({1, 1, 1}), double narrow_band = 0.0) const;
 
   /// assign cortical thickness values from mesh points
   Mesh& computeThickness(Image& image, Image* dt = nullptr, double max_dist = 10000, std::string distance_mesh = "");
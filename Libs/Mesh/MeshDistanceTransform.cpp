@@ -0,0 +1,178 @@
+#include "MeshDistanceTransform.h"
+
+#include <tbb/parallel_for.h>
+#include <vtkIdList.h>
+#include <vtkPolyData.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include "Logging.h"
+
+namespace shapeworks::mesh {
+
+namespace {
+using Point2 = std::array<double, 2>;
+
+//---------------------------------------------------------------------------
+//! Twice the signed area of (a, b, p).  The end points are used in a canonical order, so the two triangles sharing an
+//! edge get exactly opposite values.
+double edge_function(const Point2& a, const Point2& b, const Point2& p) {
+  if (a < b) {
+    return (b[0] - a[0]) * (p[1] - a[1]) - (b[1] - a[1]) * (p[0] - a[0]);
+  }
+  return -((a[0] - b[0]) * (p[1] - b[1]) - (a[1] - b[1]) * (p[0] - b[0]));
+}
+
+//---------------------------------------------------------------------------
+//! Whether a point exactly on the edge (a, b) of a counter clockwise triangle belongs to the triangle.  Exactly one of
+//! (a, b) and (b, a) is owned, so a row through a shared edge or vertex is counted once.
+bool owns_edge(const Point2& a, const Point2& b) { return b[1] < a[1] || (b[1] == a[1] && b[0] < a[0]); }
+
+//---------------------------------------------------------------------------
+//! Index range [first, last] of the grid positions origin + i * spacing within [min, max], clamped to [0, count)
+std::pair<long, long> index_range(double min, double max, double origin, double spacing, long count) {
+  const long first = std::max<long>(0, static_cast<long>(std::ceil((min - origin) / spacing)));
+  const long last = std::min<long>(count - 1, static_cast<long>(std::floor((max - origin) / spacing)));
+  return {first, last};
+}
+}  // namespace
+
+//---------------------------------------------------------------------------
+void compute_narrow_band_distance(const Mesh& mesh, Image& image, double narrow_band) {
+  auto itk_image = image.getITKImage();
+  const auto size = itk_image->GetLargestPossibleRegion().GetSize();
+  const auto origin = itk_image->GetOrigin();
+  const auto spacing = itk_image->GetSpacing();
+  const long nx = size[0];
+  const long ny = size[1];
+  const long nz = size[2];
+  float* values = itk_image->GetBufferPointer();
+
+  auto poly_data = mesh.getVTKMesh();
+  std::vector<std::array<double, 3>> points(poly_data->GetNumberOfPoints());
+  for (vtkIdType i = 0; i < poly_data->GetNumberOfPoints(); i++) {
+    poly_data->GetPoint(i, points[i].data());
+  }
+
+  // polygons are split into triangle fans
+  std::vector<std::array<vtkIdType, 3>> triangles;
+  auto ids = vtkSmartPointer<vtkIdList>::New();
+  for (vtkIdType i = 0; i < poly_data->GetNumberOfCells(); i++) {
+    poly_data->GetCellPoints(i, ids);
+    for (vtkIdType j = 1; j + 1 < ids->GetNumberOfIds(); j++) {
+      triangles.push_back({ids->GetId(0), ids->GetId(j), ids->GetId(j + 1)});
+    }
+  }
+
+  // Scan conversion: every row along x crosses the (closed) surface an even number of times, and a voxel is inside if
+  // an odd number of crossings lie before it.  The rows are the grid positions in the yz plane, so the crossings of a
+  // triangle are found by rasterizing its projection.
+  std::vector<std::vector<double>> crossings(ny * nz);
+  for (const auto& triangle : triangles) {
+    std::array<Point2, 3> yz;
+    for (int v = 0; v < 3; v++) {
+      yz[v] = {points[triangle[v]][1], points[triangle[v]][2]};
+    }
+    std::array<int, 3> order{0, 1, 2};
+    const double area = edge_function(yz[0], yz[1], yz[2]);
+    if (area == 0.0) {
+      continue;  // parallel to the rows
+    } else if (area < 0.0) {
+      std::swap(order[1], order[2]);
+    }
+    const Point2& a = yz[order[0]];
+    const Point2& b = yz[order[1]];
+    const Point2& c = yz[order[2]];
+
+    const auto [j0, j1] = index_range(std::min({a[0], b[0], c[0]}), std::max({a[0], b[0], c[0]}), origin[1],
+                                      spacing[1], ny);
+    const auto [k0, k1] = index_range(std::min({a[1], b[1], c[1]}), std::max({a[1], b[1], c[1]}), origin[2],
+                                      spacing[2], nz);
+    for (long k = k0; k <= k1; k++) {
+      for (long j = j0; j <= j1; j++) {
+        const Point2 p{origin[1] + j * spacing[1], origin[2] + k * spacing[2]};
+        const double w0 = edge_function(b, c, p);
+        const double w1 = edge_function(c, a, p);
+        const double w2 = edge_function(a, b, p);
+        if ((w0 > 0.0 || (w0 == 0.0 && owns_edge(b, c))) && (w1 > 0.0 || (w1 == 0.0 && owns_edge(c, a))) &&
+            (w2 > 0.0 || (w2 == 0.0 && owns_edge(a, b)))) {
+          const double x = (w0 * points[triangle[order[0]]][0] + w1 * points[triangle[order[1]]][0] +
+                            w2 * points[triangle[order[2]]][0]) /
+                           (w0 + w1 + w2);
+          crossings[k * ny + j].push_back(x);
+        }
+      }
+    }
+  }
+
+  // NOTE: distance is positive inside, negative outside
+  tbb::parallel_for(tbb::blocked_range<long>(0, ny * nz), [&](const tbb::blocked_range<long>& r) {
+    for (long row = r.begin(); row < r.end(); row++) {
+      auto& xs = crossings[row];
+      std::sort(xs.begin(), xs.end());
+      size_t count = 0;
+      float* row_values = values + row * nx;
+      for (long i = 0; i < nx; i++) {
+        const double x = origin[0] + i * spacing[0];
+        while (count < xs.size() && xs[count] < x) {
+          count++;
+        }
+        row_values[i] = count % 2 ? narrow_band : -narrow_band;
+      }
+      std::vector<double>().swap(xs);
+    }
+  });
+
+  // exact distances for the voxels within the narrow band of a triangle
+  std::vector<unsigned char> in_band(nx * ny * nz, 0);
+  for (const auto& triangle : triangles) {
+    std::array<std::pair<long, long>, 3> range;
+    for (int d = 0; d < 3; d++) {
+      double min = points[triangle[0]][d];
+      double max = min;
+      for (int v = 1; v < 3; v++) {
+        min = std::min(min, points[triangle[v]][d]);
+        max = std::max(max, points[triangle[v]][d]);
+      }
+      range[d] = index_range(min - narrow_band, max + narrow_band, origin[d], spacing[d], size[d]);
+    }
+    for (long k = range[2].first; k <= range[2].second; k++) {
+      for (long j = range[1].first; j <= range[1].second; j++) {
+        for (long i = range[0].first; i <= range[0].second; i++) {
+          in_band[(k * ny + j) * nx + i] = 1;
+        }
+      }
+    }
+  }
+
+  std::vector<long> band;
+  for (long i = 0; i < static_cast<long>(in_band.size()); i++) {
+    if (in_band[i]) {
+      band.push_back(i);
+    }
+  }
+  std::vector<unsigned char>().swap(in_band);
+  SW_DEBUG("Narrow band distance: {} of {} voxels in the band", band.size(), nx * ny * nz);
+
+  tbb::parallel_for(tbb::blocked_range<size_t>(0, band.size()), [&](const tbb::blocked_range<size_t>& r) {
+    for (size_t b = r.begin(); b < r.end(); b++) {
+      const long index = band[b];
+      const long i = index % nx;
+      const long j = (index / nx) % ny;
+      const long k = index / (nx * ny);
+      const Point3 p({origin[0] + i * spacing[0], origin[1] + j * spacing[1], origin[2] + k * spacing[2]});
+
+      double distance = 0.0;
+      vtkIdType face_id = 0;
+      mesh.closestPoint(p, distance, face_id);
+
+      const double magnitude = std::min(distance, narrow_band);
+      values[index] = values[index] > 0 ? magnitude : -magnitude;
+    }
+  });
+}
+
+}  // namespace shapeworks::mesh
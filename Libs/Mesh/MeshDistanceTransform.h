@@ -0,0 +1,13 @@
+#pragma once
+
+#include <Image.h>
+#include <Mesh.h>
+
+namespace shapeworks::mesh {
+
+//! Fill image with the signed distance to a closed mesh (positive inside), computing exact distances only for voxels
+//! within narrow_band of the surface.  The other voxels are set to +/- narrow_band, the sign coming from a scan
+//! conversion of the mesh along the image rows.  The image must have an identity direction.
+void compute_narrow_band_distance(const Mesh& mesh, Image& image, double narrow_band);
+
+}  // namespace shapeworks::mesh
@@ -5,6 +5,7 @@
 #include <vtkCellData.h>
 #include <vtkDoubleArray.h>
 #include <vtkIterativeClosestPointTransform.h>
+#include <vtkKdTreePointLocator.h>
 #include <vtkLandmarkTransform.h>
 #include <vtkLookupTable.h>
 #include <vtkNamedColors.h>
@@ -35,6 +36,7 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <igl/remove_unreferenced.h>
+#include <numeric>
 
 
 
@@ -46,6 +48,86 @@ namespace shapeworks {
 // locking to handle non-thread-safe code
 static std::mutex mesh_mutex;
 
+namespace {
+// number of points kept from each mesh by the scalable reference mesh search
+const vtkIdType reference_cloud_size = 1000;
+// number of radial distance quantiles in the reference mesh descriptor
+const int reference_descriptor_quantiles = 16;
+// iterations of the rigid registration used to compare meshes, same as the exhaustive search
+const int reference_icp_iterations = 10;
+
+/// Decimated copy of a mesh with its own k-d tree and an alignment invariant descriptor
+struct ReferenceCloud {
+  Eigen::Matrix3Xd points;
+  Eigen::Vector3d centroid;
+  vtkSmartPointer<vtkKdTreePointLocator> locator;
+  Eigen::VectorXd descriptor;
+};
+
+ReferenceCloud createReferenceCloud(const Mesh& mesh)
+{
+  auto poly_data = mesh.getVTKMesh();
+  vtkIdType num_points = poly_data->GetNumberOfPoints();
+  if (num_points == 0) {
+    throw std::invalid_argument("empty mesh passed to MeshUtils::findReferenceMesh");
+  }
+  vtkIdType stride = std::max<vtkIdType>(1, (num_points + reference_cloud_size - 1) / reference_cloud_size);
+
+  ReferenceCloud cloud;
+  auto points = vtkSmartPointer<vtkPoints>::New();
+  for (vtkIdType i = 0; i < num_points; i += stride)
+    points->InsertNextPoint(poly_data->GetPoint(i));
+
+  cloud.points.resize(3, points->GetNumberOfPoints());
+  for (vtkIdType i = 0; i < points->GetNumberOfPoints(); i++)
+    points->GetPoint(i, cloud.points.col(i).data());
+  cloud.centroid = cloud.points.rowwise().mean();
+
+  auto point_set = vtkSmartPointer<vtkPolyData>::New();
+  point_set->SetPoints(points);
+  cloud.locator = vtkSmartPointer<vtkKdTreePointLocator>::New();
+  cloud.locator->SetDataSet(point_set);
+  cloud.locator->BuildLocator();
+
+  // quantiles of the distance to the centroid and the principal standard deviations, neither changes with a rigid
+  // transform
+  Eigen::Matrix3Xd centered = cloud.points.colwise() - cloud.centroid;
+  Eigen::VectorXd radii = centered.colwise().norm().transpose();
+  std::sort(radii.data(), radii.data() + radii.size());
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(centered * centered.transpose() / centered.cols());
+
+  cloud.descriptor.resize(reference_descriptor_quantiles + 3);
+  for (int q = 0; q < reference_descriptor_quantiles; q++)
+    cloud.descriptor[q] = radii[static_cast<Eigen::Index>((q + 0.5) / reference_descriptor_quantiles * radii.size())];
+  cloud.descriptor.tail<3>() = solver.eigenvalues().cwiseMax(0.0).cwiseSqrt();
+  return cloud;
+}
+
+/// Mean distance from source to the closest points of target after rigidly registering them with ICP
+double registeredDistance(const ReferenceCloud& source, const ReferenceCloud& target)
+{
+  // start by matching centroids, as createICPTransform does for the exhaustive search
+  Eigen::Matrix3Xd moved = source.points.colwise() + (target.centroid - source.centroid);
+  Eigen::Matrix3Xd matched(3, moved.cols());
+  double distance = 0;
+  for (int iteration = 0;; iteration++) {
+    distance = 0;
+    for (Eigen::Index i = 0; i < moved.cols(); i++) {
+      vtkIdType id = target.locator->FindClosestPoint(moved.col(i).data());
+      matched.col(i) = target.points.col(id);
+      distance += (matched.col(i) - moved.col(i)).norm();
+    }
+    distance /= moved.cols();
+    if (iteration == reference_icp_iterations)
+      break;
+
+    Eigen::Matrix4d transform = Eigen::umeyama(moved, matched, false);
+    moved = (transform.topLeftCorner<3, 3>() * moved).colwise() + transform.topRightCorner<3, 1>();
+  }
+  return distance;
+}
+}  // namespace
+
 const vtkSmartPointer<vtkMatrix4x4> MeshUtils::createICPTransform(const Mesh source,
                                                                   const Mesh target,
                                                                   Mesh::AlignmentType align,
@@ -130,8 +212,36 @@ PhysicalRegion MeshUtils::boundingBox(const std::vector<std::reference_wrapper<c
   return bbox;
 }
 
-size_t MeshUtils::findReferenceMesh(std::vector<Mesh>& meshes)
+size_t MeshUtils::findReferenceMesh(std::vector<Mesh>& meshes, int shortlist_size)
 {
+  if (shortlist_size > 0 && meshes.size() > 1) {
+    // decimate each mesh once, then only register the most central candidates against all others
+    std::vector<ReferenceCloud> clouds(meshes.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>{0, meshes.size()}, [&](const tbb::blocked_range<size_t>& r) {
+      for (size_t i = r.begin(); i < r.end(); ++i)
+        clouds[i] = createReferenceCloud(meshes[i]);
+    });
+
+    std::vector<Eigen::VectorXd> descriptors;
+    for (const auto& cloud : clouds)
+      descriptors.push_back(cloud.descriptor);
+    auto candidates = findCentralDescriptors(descriptors, shortlist_size);
+
+    // each task registers the candidate to one other cloud, so no k-d tree is queried by two threads at once
+    std::vector<double> means(candidates.size(), 0);
+    for (size_t c = 0; c < candidates.size(); c++) {
+      std::vector<double> distances(meshes.size(), 0);
+      tbb::parallel_for(tbb::blocked_range<size_t>{0, meshes.size()}, [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t i = r.begin(); i < r.end(); ++i)
+          if (i != candidates[c])
+            distances[i] = registeredDistance(clouds[candidates[c]], clouds[i]);
+      });
+      means[c] = std::accumulate(distances.begin(), distances.end(), 0.0) / (meshes.size() - 1);
+    }
+
+    return candidates[std::distance(means.begin(), std::min_element(means.begin(), means.end()))];
+  }
+
   std::vector<std::pair<int, int>> pairs;
 
   // enumerate all pairs of meshes
@@ -193,6 +303,24 @@ size_t MeshUtils::findReferenceMesh(std::vector<Mesh>& meshes)
   return std::distance(means.begin(), smallest);
 }
 
+std::vector<size_t> MeshUtils::findCentralDescriptors(const std::vector<Eigen::VectorXd>& descriptors, size_t count)
+{
+  std::vector<double> sums(descriptors.size(), 0);
+  tbb::parallel_for(tbb::blocked_range<size_t>{0, descriptors.size()}, [&](const tbb::blocked_range<size_t>& r) {
+    for (size_t i = r.begin(); i < r.end(); ++i)
+      for (size_t j = 0; j < descriptors.size(); j++)
+        sums[i] += (descriptors[i] - descriptors[j]).norm();
+  });
+
+  std::vector<size_t> order(descriptors.size());
+  std::iota(order.begin(), order.end(), 0);
+  count = std::min(count, order.size());
+  std::partial_sort(order.begin(), order.begin() + count, order.end(),
+                    [&](size_t a, size_t b) { return sums[a] < sums[b]; });
+  order.resize(count);
+  return order;
+}
+
 
 
 
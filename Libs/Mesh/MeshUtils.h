@@ -39,8 +39,13 @@ public:
   /// calculate bounding box incrementally for meshes
   static PhysicalRegion boundingBox(const std::vector<std::reference_wrapper<const Mesh>>& meshes, bool center = false);
 
-  /// determine the reference mesh
-  static size_t findReferenceMesh(std::vector<Mesh> &meshes);
+  /// determine the reference mesh, the one with the smallest mean distance to the others after rigid registration.
+  /// If shortlist_size is positive, only the shortlist_size meshes whose alignment invariant descriptors are most
+  /// central are registered, against decimated copies of the other meshes, instead of registering every pair
+  static size_t findReferenceMesh(std::vector<Mesh> &meshes, int shortlist_size = 0);
+
+  /// indices of the count descriptors with the smallest summed distance to all other descriptors
+  static std::vector<size_t> findCentralDescriptors(const std::vector<Eigen::VectorXd>& descriptors, size_t count);
 
 
   /// boundary loop extractor for a given mesh
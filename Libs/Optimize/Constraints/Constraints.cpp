@@ -263,6 +263,29 @@ void Constraints::UpdateMus(const Point3& pos, double C, size_t index) {
   }
 }
 
+//-----------------------------------------------------------------------------
+std::vector<std::vector<double>> Constraints::GetLagrangianParameters() {
+  std::vector<std::vector<double>> mus;
+  for (size_t i = 0; i < planeConstraints_.size(); i++) {
+    mus.push_back(planeConstraints_[i].getMus());
+  }
+  if (freeFormConstraint_.readyForOptimize()) {
+    mus.push_back(freeFormConstraint_.getMus());
+  }
+  return mus;
+}
+
+//-----------------------------------------------------------------------------
+void Constraints::SetLagrangianParameters(const std::vector<std::vector<double>>& mus) {
+  size_t next = 0;
+  for (size_t i = 0; i < planeConstraints_.size() && next < mus.size(); i++) {
+    planeConstraints_[i].setMus(mus[next++]);
+  }
+  if (freeFormConstraint_.readyForOptimize() && next < mus.size()) {
+    freeFormConstraint_.setMus(mus[next++]);
+  }
+}
+
 //-----------------------------------------------------------------------------
 void Constraints::addFreeFormConstraint(std::shared_ptr<shapeworks::Mesh> mesh) {
   freeFormConstraint_.setMesh(mesh);
@@ -114,6 +114,11 @@ class Constraints {
   /// Updates mus, the momentum variable of the augmented lagrangian
   void UpdateMus(const Point3 &pos, double C, size_t index);
 
+  /// Returns the mus of every constraint (planes first, then the free-form constraint if in use)
+  std::vector<std::vector<double>> GetLagrangianParameters();
+  /// Restores mus returned by GetLagrangianParameters
+  void SetLagrangianParameters(const std::vector<std::vector<double>> &mus);
+
   /// Gets the variable active, which determines whether constraints are being used
   bool GetActive() { return active_; }
   /// Sets the variable active, which determines whether constraints are being used
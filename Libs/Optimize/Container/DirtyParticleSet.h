@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace shapeworks {
+/*!
+ * @class DirtyParticleSet
+ * @brief A set of particle indices of one domain, stored as a bitset.
+ *
+ * Mark may be called from any number of threads at once without locking; the
+ * other methods must not run concurrently with Mark.  Used by the
+ * ParticleSystem to remember which particles changed while observer
+ * notifications are batched.
+ */
+class DirtyParticleSet {
+ public:
+  //! Resizes the set to hold indices [0, size) and clears it
+  void Reset(size_t size) {
+    const size_t num_words = (size + 63) / 64;
+    if (num_words != num_words_) {
+      words_.reset(new std::atomic<uint64_t>[num_words]);
+      num_words_ = num_words;
+    }
+    for (size_t i = 0; i < num_words_; i++) {
+      words_[i].store(0, std::memory_order_relaxed);
+    }
+    size_ = size;
+    empty_.store(true, std::memory_order_relaxed);
+  }
+
+  size_t Size() const { return size_; }
+
+  //! Adds index k to the set, k must be less than Size()
+  void Mark(size_t k) {
+    words_[k / 64].fetch_or(uint64_t(1) << (k % 64), std::memory_order_relaxed);
+    if (empty_.load(std::memory_order_relaxed)) {
+      empty_.store(false, std::memory_order_relaxed);
+    }
+  }
+
+  bool Empty() const { return empty_.load(std::memory_order_relaxed); }
+
+  //! Calls f(k) for every index k in the set, in increasing order, and clears the set
+  template <typename Function>
+  void Drain(Function f) {
+    if (Empty()) {
+      return;
+    }
+    for (size_t i = 0; i < num_words_; i++) {
+      uint64_t word = words_[i].exchange(0, std::memory_order_relaxed);
+      while (word) {
+        const int bit = CountTrailingZeros(word);
+        f(i * 64 + bit);
+        word &= word - 1;
+      }
+    }
+    empty_.store(true, std::memory_order_relaxed);
+  }
+
+ private:
+  static int CountTrailingZeros(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    int n = 0;
+    while (!(word & 1)) {
+      word >>= 1;
+      n++;
+    }
+    return n;
+#endif
+  }
+
+  std::unique_ptr<std::atomic<uint64_t>[]> words_;
+  size_t num_words_ = 0;
+  size_t size_ = 0;
+  std::atomic<bool> empty_{true};
+};
+
+}  // namespace shapeworks
@@ -43,6 +43,9 @@ class GenericContainer : public itk::DataObject {
       ugly syntax like ->operator[](k) */
   inline T& Get(size_t k) { return (*this)[k]; }
 
+  /** Const access, k must be a valid index. */
+  inline const T& Get(size_t k) const { return data[k]; }
+
   /** Number of objects in the container. */
   unsigned long int GetSize() const { return data.size(); }
 
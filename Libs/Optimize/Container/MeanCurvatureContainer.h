@@ -44,10 +44,8 @@ class MeanCurvatureContainer : public GenericContainerArray<TNumericType> {
     this->ComputeMeanCurvature(ps, event.GetPositionIndex(), event.GetDomainIndex());
   }
 
-  virtual void PositionSetEventCallback(itk::Object* o, const itk::EventObject& e) {
-    const ParticlePositionSetEvent& event = dynamic_cast<const ParticlePositionSetEvent&>(e);
-    const ParticleSystemType* ps = dynamic_cast<const ParticleSystemType*>(o);
-    this->ComputeMeanCurvature(ps, event.GetPositionIndex(), event.GetDomainIndex());
+  void PositionSetCallback(const ParticleSystemType* ps, unsigned int d, unsigned int idx) override {
+    this->ComputeMeanCurvature(ps, idx, d);
   }
 
   virtual void DomainAddEventCallback(itk::Object* o, const itk::EventObject& e) {
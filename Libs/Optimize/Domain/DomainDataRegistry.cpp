@@ -0,0 +1,68 @@
+#include "DomainDataRegistry.h"
+
+namespace shapeworks {
+
+//---------------------------------------------------------------------------
+DomainDataRegistry& DomainDataRegistry::Instance() {
+  static DomainDataRegistry instance;
+  return instance;
+}
+
+//---------------------------------------------------------------------------
+size_t DomainDataRegistry::GetNumberOfEntries() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t count = 0;
+  for (const auto& entry : entries_) {
+    if (!entry.second.expired()) {
+      count++;
+    }
+  }
+  return count;
+}
+
+//---------------------------------------------------------------------------
+size_t DomainDataRegistry::GetNumberOfHits() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return hits_;
+}
+
+//---------------------------------------------------------------------------
+std::shared_ptr<const void> DomainDataRegistry::Find(const Key& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    return nullptr;
+  }
+  auto data = it->second.lock();
+  if (!data) {
+    entries_.erase(it);
+    return nullptr;
+  }
+  hits_++;
+  return data;
+}
+
+//---------------------------------------------------------------------------
+std::shared_ptr<const void> DomainDataRegistry::Insert(const Key& key, std::shared_ptr<const void> data) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // drop the entries of data that is no longer in use
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    if (it->second.expired() && it->first != key) {
+      it = entries_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  auto& entry = entries_[key];
+  if (auto existing = entry.lock()) {
+    // another thread built the same data in the meantime
+    hits_++;
+    return existing;
+  }
+  entry = data;
+  return data;
+}
+
+}  // namespace shapeworks
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <typeindex>
+
+namespace shapeworks {
+
+/**
+ * \class DomainDataRegistry
+ *
+ * Shares the data domains compute from their inputs (level set grids, mesh
+ * geodesic operators, gradient of normals, ...) between domains built from
+ * identical inputs.  Longitudinal and augmentation studies, fixed domains and
+ * templates often load the same groomed file many times; with the registry
+ * each copy only costs its per-particle caches.
+ *
+ * Entries are keyed by a name, the type of the data and a hash of the content
+ * it was computed from.  The registry only holds weak references, so an entry
+ * is freed as soon as the last domain using it lets go of it.  Shared data
+ * must not be modified once it is in the registry.  Thread safe.
+ */
+class DomainDataRegistry {
+ public:
+  static DomainDataRegistry& Instance();
+
+  //! Returns the data stored under (name, hash), calling create to build it if there is none.
+  //! create is called without holding the lock, as building the data of a large input takes a while.
+  template <class T>
+  std::shared_ptr<T> GetOrCreate(const std::string& name, uint64_t hash,
+                                 const std::function<std::shared_ptr<T>()>& create) {
+    const Key key{std::type_index(typeid(T)), name, hash};
+    if (auto found = Find(key)) {
+      return std::static_pointer_cast<T>(std::const_pointer_cast<void>(found));
+    }
+    auto stored = Insert(key, create());
+    return std::static_pointer_cast<T>(std::const_pointer_cast<void>(stored));
+  }
+
+  //! Number of entries that are still in use
+  size_t GetNumberOfEntries();
+
+  //! Number of GetOrCreate calls that found shared data
+  size_t GetNumberOfHits();
+
+ private:
+  DomainDataRegistry() = default;
+
+  using Key = std::tuple<std::type_index, std::string, uint64_t>;
+
+  std::shared_ptr<const void> Find(const Key& key);
+
+  //! Stores data under key unless another thread stored data there first, returns the stored data
+  std::shared_ptr<const void> Insert(const Key& key, std::shared_ptr<const void> data);
+
+  std::mutex mutex_;
+  std::map<Key, std::weak_ptr<const void>> entries_;
+  size_t hits_ = 0;
+};
+
+/**
+ * \class ContentHash
+ *
+ * Incremental 64 bit FNV-1a hash of the inputs of a domain, used as the
+ * DomainDataRegistry key.
+ */
+class ContentHash {
+ public:
+  void Add(const void* data, size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+      hash_ ^= bytes[i];
+      hash_ *= 1099511628211ull;
+    }
+  }
+
+  template <class T>
+  void AddValue(const T& value) {
+    Add(&value, sizeof(T));
+  }
+
+  uint64_t Get() const { return hash_; }
+
+ private:
+  uint64_t hash_ = 14695981039346656037ull;
+};
+
+}  // namespace shapeworks
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace shapeworks {
+
+/**
+ * \class GeodesicCacheBudget
+ *
+ * Tracks the bytes held by the in-memory geodesic caches of all mesh domains
+ * and an optional limit on their total.  Each VtkMeshWrapper reports its
+ * allocations here and evicts its own entries while the total is over the
+ * limit, so the memory used for geodesics is bounded regardless of the number
+ * of meshes in a run.
+ */
+class GeodesicCacheBudget {
+ public:
+  static GeodesicCacheBudget& Instance() {
+    static GeodesicCacheBudget instance;
+    return instance;
+  }
+
+  //! Set the limit on the total number of bytes, 0 for no limit
+  void SetBudget(size_t bytes) { budget_ = bytes; }
+  size_t GetBudget() const { return budget_; }
+
+  void Add(size_t bytes) { used_ += bytes; }
+  void Remove(size_t bytes) { used_ -= bytes; }
+  size_t GetUsed() const { return used_; }
+
+  bool IsExceeded() const {
+    const size_t budget = budget_;
+    return budget > 0 && used_ > budget;
+  }
+
+ private:
+  GeodesicCacheBudget() = default;
+
+  std::atomic<size_t> budget_{0};
+  std::atomic<size_t> used_{0};
+};
+
+}  // namespace shapeworks
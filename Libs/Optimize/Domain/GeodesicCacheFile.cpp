@@ -0,0 +1,182 @@
+#include "GeodesicCacheFile.h"
+
+#include <Logging.h>
+
+#include <boost/filesystem.hpp>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace shapeworks {
+
+namespace {
+const char magic[8] = {'S', 'W', 'G', 'E', 'O', '0', '0', '1'};
+
+//! fields held in memory are written to a new segment once they reach this size
+const size_t max_pending_bytes = 64 * 1024 * 1024;
+
+struct Header {
+  char magic[8];
+  uint64_t num_vertices;
+  uint64_t num_faces;
+  uint64_t num_records;
+};
+}  // namespace
+
+//---------------------------------------------------------------------------
+GeodesicCacheFile::GeodesicCacheFile(const std::string& filename, size_t num_vertices, size_t num_faces,
+                                     size_t max_bytes)
+    : filename_(filename), num_vertices_(num_vertices), num_faces_(num_faces), max_bytes_(max_bytes) {
+  Open();
+}
+
+//---------------------------------------------------------------------------
+GeodesicCacheFile::~GeodesicCacheFile() {
+  try {
+    Flush();
+  } catch (std::exception& e) {
+    SW_WARN("Unable to write geodesic cache {}: {}", filename_, e.what());
+  }
+}
+
+//---------------------------------------------------------------------------
+std::string GeodesicCacheFile::GetFilename(const std::string& directory, uint64_t mesh_hash) {
+  std::stringstream ss;
+  ss << std::hex << std::setw(16) << std::setfill('0') << mesh_hash << ".swgeo";
+  return (boost::filesystem::path(directory) / ss.str()).string();
+}
+
+//---------------------------------------------------------------------------
+void GeodesicCacheFile::Open() {
+  // the segments are <stem>.swgeo and <stem>.<unique>.swgeo, skipping the .tmp files of segments being written
+  const auto path = boost::filesystem::path(filename_);
+  const auto directory = path.has_parent_path() ? path.parent_path() : boost::filesystem::path(".");
+  const auto prefix = path.stem().string() + ".";
+
+  boost::system::error_code error;
+  for (boost::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+    const auto name = it->path().filename().string();
+    if (it->path().extension() == path.extension() && name.compare(0, prefix.size(), prefix) == 0 &&
+        boost::filesystem::is_regular_file(it->path())) {
+      AddSegment(it->path().string());
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+bool GeodesicCacheFile::AddSegment(const std::string& filename) {
+  boost::iostreams::mapped_file_source file;
+  try {
+    file.open(filename);
+  } catch (std::exception& e) {
+    SW_WARN("Unable to open geodesic cache {}: {}", filename, e.what());
+    return false;
+  }
+
+  // a stale file (e.g. from a mesh with a hash collision) or a truncated one is ignored
+  Header header;
+  if (file.size() >= sizeof(Header)) {
+    std::memcpy(&header, file.data(), sizeof(Header));
+  }
+  if (file.size() < sizeof(Header) || std::memcmp(header.magic, magic, sizeof(magic)) != 0 ||
+      header.num_vertices != num_vertices_ || header.num_faces != num_faces_ ||
+      file.size() != sizeof(Header) + header.num_records * RecordBytes()) {
+    SW_WARN("Ignoring incompatible geodesic cache {}", filename);
+    return false;
+  }
+
+  const char* record = file.data() + sizeof(Header);
+  for (size_t i = 0; i < header.num_records; i++) {
+    int64_t v;
+    std::memcpy(&v, record, sizeof(int64_t));
+    // concurrent runs may have written the same field, the first one found is kept
+    mapped_records_.emplace(static_cast<int>(v), reinterpret_cast<const double*>(record + sizeof(int64_t)));
+    record += RecordBytes();
+  }
+  segment_bytes_ += file.size();
+  segments_.push_back(file);
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool GeodesicCacheFile::Get(int v, Eigen::VectorXd& out) const {
+  auto mapped = mapped_records_.find(v);
+  if (mapped != mapped_records_.end()) {
+    out = Eigen::Map<const Eigen::VectorXd>(mapped->second, num_vertices_);
+    return true;
+  }
+  auto added = new_records_.find(v);
+  if (added != new_records_.end()) {
+    out = added->second;
+    return true;
+  }
+  return false;
+}
+
+//---------------------------------------------------------------------------
+void GeodesicCacheFile::Put(int v, const Eigen::VectorXd& dists) {
+  if (mapped_records_.count(v) || new_records_.count(v)) {
+    return;
+  }
+  if (segment_bytes_ + sizeof(Header) + (new_records_.size() + 1) * RecordBytes() > max_bytes_) {
+    return;
+  }
+  new_records_[v] = dists;
+
+  if (new_records_.size() * RecordBytes() >= max_pending_bytes) {
+    try {
+      Flush();
+    } catch (std::exception& e) {
+      // drop the fields instead of holding on to them, the cache is only an optimization
+      SW_WARN("Unable to write geodesic cache {}: {}", filename_, e.what());
+      new_records_.clear();
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+void GeodesicCacheFile::Flush() {
+  if (new_records_.empty()) {
+    return;
+  }
+
+  const auto path = boost::filesystem::path(filename_);
+  if (path.has_parent_path()) {
+    boost::filesystem::create_directories(path.parent_path());
+  }
+  const auto segment_name = path.stem().string() + ".%%%%-%%%%-%%%%-%%%%" + path.extension().string();
+  const auto segment = path.parent_path() / boost::filesystem::unique_path(segment_name);
+  const auto tmp = segment.string() + ".tmp";
+
+  {
+    std::ofstream out(tmp, std::ios::binary);
+    if (!out) {
+      throw std::runtime_error("Unable to open " + tmp + " for writing");
+    }
+
+    Header header;
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.num_vertices = num_vertices_;
+    header.num_faces = num_faces_;
+    header.num_records = new_records_.size();
+    out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+
+    for (const auto& [v, data] : new_records_) {
+      const int64_t v64 = v;
+      out.write(reinterpret_cast<const char*>(&v64), sizeof(int64_t));
+      out.write(reinterpret_cast<const char*>(data.data()), num_vertices_ * sizeof(double));
+    }
+    if (!out) {
+      out.close();
+      boost::filesystem::remove(tmp);
+      throw std::runtime_error("Error writing " + tmp);
+    }
+  }
+
+  boost::filesystem::rename(tmp, segment);
+  new_records_.clear();
+  AddSegment(segment.string());
+}
+
+}  // namespace shapeworks
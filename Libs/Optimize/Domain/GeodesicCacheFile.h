@@ -0,0 +1,76 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace shapeworks {
+
+/**
+ * \class GeodesicCacheFile
+ *
+ * A persistent cache of heat method geodesic distance fields for one mesh.
+ *
+ * Each record holds the geodesic distance from one vertex to every vertex of
+ * the mesh.  These are what VtkMeshWrapper assembles its per-triangle
+ * MeshGeoEntry values from, and they do not depend on the heat method
+ * factorization or on the cache limits of a run, so they can be reused by any
+ * later run on the same mesh.
+ *
+ * The cache is stored as a set of segment files next to the cache filename,
+ * each memory mapped read-only.  Fields computed during the run are held in
+ * memory only until they fill a segment (or until Flush() or destruction),
+ * then written to a temporary file that is renamed to a new, uniquely named
+ * segment.  Segments are never rewritten, so readers never see a partially
+ * written file, concurrent runs on the same mesh add segments instead of
+ * replacing each other's, and a run that dies loses at most one segment.
+ * The segments never grow beyond max_bytes in total.
+ */
+class GeodesicCacheFile {
+ public:
+  GeodesicCacheFile(const std::string& filename, size_t num_vertices, size_t num_faces, size_t max_bytes);
+  ~GeodesicCacheFile();
+
+  //! Returns the cache file name for a mesh with the given content hash
+  static std::string GetFilename(const std::string& directory, uint64_t mesh_hash);
+
+  //! Copies the distance field of vertex v into out, returns false if it is not cached
+  bool Get(int v, Eigen::VectorXd& out) const;
+
+  //! Stores the distance field of vertex v, if the size limit allows it
+  void Put(int v, const Eigen::VectorXd& dists);
+
+  //! Writes the fields not yet in a segment to a new segment
+  void Flush();
+
+  size_t GetNumberOfRecords() const { return mapped_records_.size() + new_records_.size(); }
+
+ private:
+  //! Maps every segment of the cache that exists on disk
+  void Open();
+
+  //! Maps one segment and indexes its records, returns false if it is incompatible
+  bool AddSegment(const std::string& filename);
+
+  size_t RecordBytes() const { return sizeof(int64_t) + num_vertices_ * sizeof(double); }
+
+  std::string filename_;
+  size_t num_vertices_;
+  size_t num_faces_;
+  size_t max_bytes_;
+
+  std::vector<boost::iostreams::mapped_file_source> segments_;
+
+  //! total size of the mapped segments
+  size_t segment_bytes_ = 0;
+
+  //! vertex -> start of its distance field in a mapped segment
+  std::unordered_map<int, const double*> mapped_records_;
+
+  //! fields computed during this run, not yet in a segment
+  std::unordered_map<int, Eigen::VectorXd> new_records_;
+};
+
+}  // namespace shapeworks
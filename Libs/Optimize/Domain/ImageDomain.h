@@ -1,6 +1,7 @@
 #pragma once
 
 #include <itkImage.h>
+#include <itkImageRegionConstIterator.h>
 #include <itkImageRegionConstIteratorWithIndex.h>
 #include <itkImageToVTKImageFilter.h>
 #include <itkZeroCrossingImageFilter.h>
@@ -10,6 +11,7 @@
 #include <chrono>
 #include <fstream>
 
+#include "DomainDataRegistry.h"
 #include "ParticleRegionDomain.h"
 
 // we have to undef foreach here because both Qt and OpenVDB define foreach
@@ -21,6 +23,8 @@
 #include <openvdb/tools/GridOperators.h>
 #include <openvdb/tools/Interpolation.h>
 #include <openvdb/tools/SignedFloodFill.h>
+
+#include "VDBAccessorCache.h"
 #endif
 
 namespace shapeworks {
@@ -43,46 +47,29 @@ class ImageDomain : public ParticleRegionDomain {
   using PointType = ParticleRegionDomain::PointType;
 
   /** Set/Get the itk::Image specifying the particle domain.  The set method
-      modifies the parent class LowerBound and UpperBound. */
+      modifies the parent class LowerBound and UpperBound.  Domains of
+      identical images (and narrow bands) share their grids through the
+      DomainDataRegistry. */
   void SetImage(ImageType* I, double narrow_band) {
     this->m_FixedDomain = false;
     // this->Modified();
 
     openvdb::initialize();  // It is safe to initialize multiple times.
 
-    // Set a large background value, so that we quickly catch particles outside or on the edge the narrow band.
-    // (Downside: its more difficult to display the correct location of the point of failure.)
-    m_VDBImage = openvdb::FloatGrid::create(1e8);
-    m_VDBImage->setGridClass(openvdb::GRID_LEVEL_SET);
-    auto vdbAccessor = m_VDBImage->getAccessor();
-
     // Save properties of the Image needed for the optimizer
     m_Size = I->GetRequestedRegion().GetSize();
     m_Spacing = I->GetSpacing();
     m_Origin = I->GetOrigin();
     m_Index = I->GetRequestedRegion().GetIndex();
 
-    // Transformation from index space to world space
-    openvdb::math::Mat4f mat;
-    mat.setIdentity();
-    mat.postScale(openvdb::Vec3f(m_Spacing[0], m_Spacing[1], m_Spacing[2]));
-    mat.postTranslate(openvdb::Vec3f(m_Origin[0], m_Origin[1], m_Origin[2]));
-    const auto xform = openvdb::math::Transform::createLinearTransform(mat);
-    m_VDBImage->setTransform(xform);
-
-    itk::ImageRegionIterator<ImageType> it(I, I->GetRequestedRegion());
-    it.GoToBegin();
-
-    while (!it.IsAtEnd()) {
-      const auto idx = it.GetIndex();
-      const auto pixel = it.Get();
-      if (abs(pixel) > narrow_band) {
-        ++it;
-        continue;
-      }
-      const auto coord = openvdb::Coord(idx[0], idx[1], idx[2]);
-      vdbAccessor.setValue(coord, pixel);
-      ++it;
+    m_ImageHash = ComputeImageHash(I, narrow_band);
+    auto& registry = DomainDataRegistry::Instance();
+    m_VDBImage = registry.GetOrCreate<openvdb::FloatGrid>(
+        "image", m_ImageHash, [&]() { return this->CreateVDBImage(I, narrow_band); });
+    m_possible_zero_crossings = registry.GetOrCreate<const std::vector<PointType>>(
+        "image_zero_crossings", m_ImageHash, [&]() { return this->FindPossibleZeroCrossings(I); });
+    if (!m_possible_zero_crossings->empty()) {
+      m_ZeroCrossingPoint = m_possible_zero_crossings->back();
     }
 
     typename ImageType::PointType l0;
@@ -106,8 +93,9 @@ class ImageDomain : public ParticleRegionDomain {
     this->SetLowerBound(l);
     this->SetUpperBound(u);
 
+    m_ImageAccessors.SetGrid(m_VDBImage);
+
     // Precompute and save values that are used in parts of the optimizer
-    this->SetupImageForCrossingPointUpdate(I);  // this->UpdateZeroCrossingPoint(I);
     this->UpdateSurfaceArea(I);
   }
 
@@ -133,7 +121,7 @@ class ImageDomain : public ParticleRegionDomain {
   inline T Sample(const PointType& p) const {
     if (this->IsInsideBuffer(p)) {
       const auto coord = this->ToVDBCoord(p);
-      return openvdb::tools::BoxSampler::sample(m_VDBImage->tree(), coord);
+      return openvdb::tools::BoxSampler::sample(m_ImageAccessors.Local(), coord);
     } else {
       std::ostringstream message;
       message << "Domain " << m_DomainID << ": " << m_DomainName << " : Distance transform queried for a Point, " << p
@@ -155,13 +143,16 @@ class ImageDomain : public ParticleRegionDomain {
   }
 
   /** Used when a domain is fixed. */
-  void DeleteImages() override { m_VDBImage = 0; }
+  void DeleteImages() override {
+    m_ImageAccessors.SetGrid(nullptr);
+    m_VDBImage = 0;
+  }
 
   // Updates zero crossing points. Raster scans candidate zero crossing points, and finds one that does not violate any
   // constraints.
   void UpdateZeroCrossingPoint() override {
-    for (size_t i = 0; i < m_possible_zero_crossings.size(); i++) {
-      this->m_ZeroCrossingPoint = m_possible_zero_crossings[i];
+    for (size_t i = 0; i < m_possible_zero_crossings->size(); i++) {
+      this->m_ZeroCrossingPoint = (*m_possible_zero_crossings)[i];
       if (!this->GetConstraints()->isAnyViolated(this->m_ZeroCrossingPoint)) {
         // std::cout << "Chosen initial point " << this->m_ZeroCrossingPoint << std::endl;
         break;
@@ -175,6 +166,9 @@ class ImageDomain : public ParticleRegionDomain {
     }
   }
 
+  //! Hash of the image and narrow band this domain was built from, the key of its shared data
+  uint64_t GetImageHash() const { return m_ImageHash; }
+
  protected:
   openvdb::FloatGrid::Ptr GetVDBImage() const { return m_VDBImage; }
 
@@ -196,8 +190,8 @@ class ImageDomain : public ParticleRegionDomain {
     const auto idxCoord = this->transform()->worldToIndex(worldCoord);
 
     // Make sure the coordinate is part of the narrow band
-    if (m_VDBImage->tree().isValueOff(
-            openvdb::Coord::round(idxCoord))) {  // `isValueOff` requires an integer coordinate
+    if (!m_ImageAccessors.Local().isValueOn(
+            openvdb::Coord::round(idxCoord))) {  // `isValueOn` requires an integer coordinate
       // If multiple threads crash here at the same time, the error message displayed is just "terminate called
       // recursively", which isn't helpful. So we std::cerr the error to make sure its printed to the console.
       std::cerr << "Sampled point outside the narrow band: " << p << std::endl;
@@ -213,16 +207,68 @@ class ImageDomain : public ParticleRegionDomain {
 
  private:
   openvdb::FloatGrid::Ptr m_VDBImage;
+  //! per thread accessors of m_VDBImage
+  VDBAccessorCache<openvdb::FloatGrid> m_ImageAccessors;
   typename ImageType::SizeType m_Size;
   typename ImageType::SpacingType m_Spacing;
   PointType m_Origin;
   PointType m_ZeroCrossingPoint;
   typename ImageType::RegionType::IndexType m_Index;  // Index defining the corner of the region
   double m_SurfaceArea;
-  std::vector<PointType> m_possible_zero_crossings;
+  uint64_t m_ImageHash = 0;
+  std::shared_ptr<const std::vector<PointType>> m_possible_zero_crossings;
+
+  static uint64_t ComputeImageHash(ImageType* I, double narrow_band) {
+    ContentHash hash;
+    const auto region = I->GetRequestedRegion();
+    hash.AddValue(region.GetIndex());
+    hash.AddValue(region.GetSize());
+    hash.AddValue(I->GetSpacing());
+    hash.AddValue(I->GetOrigin());
+    hash.AddValue(I->GetDirection());
+    hash.AddValue(narrow_band);
+    itk::ImageRegionConstIterator<ImageType> it(I, region);
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it) {
+      hash.AddValue(it.Get());
+    }
+    return hash.Get();
+  }
+
+  // Converts the narrow band of the image to a level set grid
+  openvdb::FloatGrid::Ptr CreateVDBImage(ImageType* I, double narrow_band) const {
+    // Set a large background value, so that we quickly catch particles outside or on the edge the narrow band.
+    // (Downside: its more difficult to display the correct location of the point of failure.)
+    auto grid = openvdb::FloatGrid::create(1e8);
+    grid->setGridClass(openvdb::GRID_LEVEL_SET);
+    auto vdbAccessor = grid->getAccessor();
+
+    // Transformation from index space to world space
+    openvdb::math::Mat4f mat;
+    mat.setIdentity();
+    mat.postScale(openvdb::Vec3f(m_Spacing[0], m_Spacing[1], m_Spacing[2]));
+    mat.postTranslate(openvdb::Vec3f(m_Origin[0], m_Origin[1], m_Origin[2]));
+    const auto xform = openvdb::math::Transform::createLinearTransform(mat);
+    grid->setTransform(xform);
+
+    itk::ImageRegionIterator<ImageType> it(I, I->GetRequestedRegion());
+    it.GoToBegin();
+
+    while (!it.IsAtEnd()) {
+      const auto idx = it.GetIndex();
+      const auto pixel = it.Get();
+      if (abs(pixel) > narrow_band) {
+        ++it;
+        continue;
+      }
+      const auto coord = openvdb::Coord(idx[0], idx[1], idx[2]);
+      vdbAccessor.setValue(coord, pixel);
+      ++it;
+    }
+    return grid;
+  }
 
   // Computes possible zero crossing points. Later on, one can find the ones that do not violate constraints.
-  void SetupImageForCrossingPointUpdate(ImageType* I) {
+  static std::shared_ptr<const std::vector<PointType>> FindPossibleZeroCrossings(ImageType* I) {
     typename itk::ZeroCrossingImageFilter<ImageType, ImageType>::Pointer zc =
         itk::ZeroCrossingImageFilter<ImageType, ImageType>::New();
     zc->SetInput(I);
@@ -230,14 +276,15 @@ class ImageDomain : public ParticleRegionDomain {
     typename itk::ImageRegionConstIteratorWithIndex<ImageType> zcIt(zc->GetOutput(),
                                                                     zc->GetOutput()->GetRequestedRegion());
 
+    auto crossings = std::make_shared<std::vector<PointType>>();
     for (zcIt.GoToReverseBegin(); !zcIt.IsAtReverseEnd(); --zcIt) {
       if (zcIt.Get() == 1.0) {
         PointType pos;
         I->TransformIndexToPhysicalPoint(zcIt.GetIndex(), pos);
-        this->m_ZeroCrossingPoint = pos;
-        m_possible_zero_crossings.push_back(pos);
+        crossings->push_back(pos);
       }
     }
+    return crossings;
   }
 
   void UpdateSurfaceArea(ImageType* I) {
@@ -31,7 +31,10 @@ class ImageDomainWithCurvature : public ImageDomainWithGradN<T> {
   void SetImage(ImageType* I, double narrow_band) {
     // Computes partial derivatives in parent class
     Superclass::SetImage(I, narrow_band);
-    m_VDBCurvature = openvdb::tools::meanCurvature(*this->GetVDBImage());
+    m_VDBCurvature = DomainDataRegistry::Instance().GetOrCreate<openvdb::FloatGrid>(
+        "image_mean_curvature", this->GetImageHash(),
+        [&]() { return openvdb::tools::meanCurvature(*this->GetVDBImage()); });
+    m_CurvatureAccessors.SetGrid(m_VDBCurvature);
     this->ComputeSurfaceStatistics(I);
   }
 
@@ -40,7 +43,7 @@ class ImageDomainWithCurvature : public ImageDomainWithGradN<T> {
       return 0;
     }
     const auto coord = this->ToVDBCoord(p);
-    return openvdb::tools::BoxSampler::sample(m_VDBCurvature->tree(), coord);
+    return openvdb::tools::BoxSampler::sample(m_CurvatureAccessors.Local(), coord);
   }
 
   inline double GetSurfaceMeanCurvature() const override { return m_SurfaceMeanCurvature; }
@@ -58,6 +61,8 @@ class ImageDomainWithCurvature : public ImageDomainWithGradN<T> {
 
  private:
   openvdb::FloatGrid::Ptr m_VDBCurvature;
+  //! per thread accessors of m_VDBCurvature
+  VDBAccessorCache<openvdb::FloatGrid> m_CurvatureAccessors;
 
   // Cache surface statistics
   double m_SurfaceMeanCurvature;
@@ -42,15 +42,18 @@ class ImageDomainWithGradN : public ImageDomainWithGradients<T> {
 
     // Compute the gradient of normals component-wise
     for (int i = 0; i < 3; i++) {
-      auto norm_i = openvdb::FloatGrid::create();
-      norm_i->setTransform(this->transform());
-      auto norm_i_accessor = norm_i->getAccessor();
-      for (openvdb::VectorGrid::ValueOnCIter it = grad->cbeginValueOn(); it.test(); ++it) {
-        const openvdb::Vec3f& v = *it;
-        norm_i_accessor.setValue(it.getCoord(), v[i] / v.length());
-      }
-
-      m_VDBGradNorms[i] = openvdb::tools::gradient(*norm_i);
+      m_VDBGradNorms[i] = DomainDataRegistry::Instance().GetOrCreate<openvdb::VectorGrid>(
+          "image_gradient_normal_" + std::to_string(i), this->GetImageHash(), [&]() {
+            auto norm_i = openvdb::FloatGrid::create();
+            norm_i->setTransform(this->transform());
+            auto norm_i_accessor = norm_i->getAccessor();
+            for (openvdb::VectorGrid::ValueOnCIter it = grad->cbeginValueOn(); it.test(); ++it) {
+              const openvdb::Vec3f& v = *it;
+              norm_i_accessor.setValue(it.getCoord(), v[i] / v.length());
+            }
+            return openvdb::tools::gradient(*norm_i);
+          });
+      m_GradNormAccessors[i].SetGrid(m_VDBGradNorms[i]);
     }
   }  // end setimage
 
@@ -62,7 +65,7 @@ class ImageDomainWithGradN : public ImageDomainWithGradients<T> {
 
     GradNType grad_n;
     for (int i = 0; i < 3; i++) {
-      auto grad_ni = openvdb::tools::BoxSampler::sample(m_VDBGradNorms[i]->tree(), coord);
+      auto grad_ni = openvdb::tools::BoxSampler::sample(m_GradNormAccessors[i].Local(), coord);
       grad_n.set(i, 0, grad_ni[0]);
       grad_n.set(i, 1, grad_ni[1]);
       grad_n.set(i, 2, grad_ni[2]);
@@ -72,6 +75,7 @@ class ImageDomainWithGradN : public ImageDomainWithGradients<T> {
 
   void DeletePartialDerivativeImages() override {
     for (unsigned int i = 0; i < DIMENSION; i++) {
+      m_GradNormAccessors[i].SetGrid(nullptr);
       m_VDBGradNorms[i] = 0;
     }
   }
@@ -90,6 +94,8 @@ class ImageDomainWithGradN : public ImageDomainWithGradients<T> {
 
  private:
   typename openvdb::VectorGrid::Ptr m_VDBGradNorms[3];
+  //! per thread accessors of m_VDBGradNorms
+  VDBAccessorCache<openvdb::VectorGrid> m_GradNormAccessors[3];
 };
 
 }  // end namespace shapeworks
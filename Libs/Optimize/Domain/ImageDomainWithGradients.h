@@ -33,7 +33,9 @@ class ImageDomainWithGradients : public ImageDomain<T> {
       modifies the parent class LowerBound and UpperBound. */
   void SetImage(ImageType* I, double narrow_band) {
     ImageDomain<T>::SetImage(I, narrow_band);
-    m_VDBGradient = openvdb::tools::gradient(*this->GetVDBImage());
+    m_VDBGradient = DomainDataRegistry::Instance().GetOrCreate<openvdb::VectorGrid>(
+        "image_gradient", this->GetImageHash(), [&]() { return openvdb::tools::gradient(*this->GetVDBImage()); });
+    m_GradientAccessors.SetGrid(m_VDBGradient);
   }
 
   inline vnl_vector_fixed<float, DIMENSION> SampleGradientAtPoint(const PointType& p, int idx) const {
@@ -65,6 +67,7 @@ class ImageDomainWithGradients : public ImageDomain<T> {
   /** Used when a domain is fixed. */
   void DeleteImages() override {
     ImageDomain<T>::DeleteImages();
+    m_GradientAccessors.SetGrid(nullptr);
     m_VDBGradient = 0;
   }
 
@@ -90,7 +93,7 @@ class ImageDomainWithGradients : public ImageDomain<T> {
   inline VectorType SampleGradient(const PointType& p, int idx) const {
     if (this->IsInsideBuffer(p)) {
       const auto coord = this->ToVDBCoord(p);
-      const auto _v = openvdb::tools::BoxSampler::sample(m_VDBGradient->tree(), coord);
+      const auto _v = openvdb::tools::BoxSampler::sample(m_GradientAccessors.Local(), coord);
       const VectorType v(_v.asPointer());  // This copies 3 floats from a VDB vector to a vnl vector
       return v;
     } else {
@@ -101,6 +104,8 @@ class ImageDomainWithGradients : public ImageDomain<T> {
   }
 
   openvdb::VectorGrid::Ptr m_VDBGradient;
+  //! per thread accessors of m_VDBGradient
+  VDBAccessorCache<openvdb::VectorGrid> m_GradientAccessors;
 };
 
 }  // end namespace shapeworks
@@ -44,6 +44,18 @@ struct MeshGeoEntry {
     max_dist = std::max({max0, max1, max2});
   }
 
+  // approximate number of bytes allocated by this entry
+  size_t bytes() const {
+    if (is_full_mode()) {
+      return (data_full[0].size() + data_full[1].size() + data_full[2].size()) * sizeof(double);
+    }
+    if (data_partial.empty()) {
+      return 0;
+    }
+    // one node plus one info byte per bucket
+    return (data_partial.mask() + 1) * (sizeof(std::pair<int, Eigen::Vector3d>) + 1);
+  }
+
   bool has_entry(int target) {
     return is_full_mode() || data_partial.find(target) != data_partial.end();
   }
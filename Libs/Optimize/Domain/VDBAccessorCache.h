@@ -0,0 +1,45 @@
+#pragma once
+
+#include <openvdb/openvdb.h>
+#include <tbb/enumerable_thread_specific.h>
+
+#include <memory>
+
+namespace shapeworks {
+/** \class VDBAccessorCache
+ *
+ * A read-only OpenVDB value accessor per thread for one grid.  An accessor
+ * remembers the nodes of its last lookup, so a lookup close to the previous one
+ * (the corners of an interpolation, the next particle of a neighborhood) skips
+ * most of the tree traversal.  Accessors are not thread safe, so each thread
+ * gets its own.  The accessors don't register with the tree, so the grid must
+ * not be modified while the cache holds it.
+ */
+template <class GridType>
+class VDBAccessorCache {
+ public:
+  using AccessorType = typename GridType::ConstUnsafeAccessor;
+
+  //! Sets the grid to sample, dropping the accessors of the previous grid.  Not thread safe.
+  void SetGrid(typename GridType::Ptr grid) {
+    m_Accessors.clear();
+    m_Grid = grid;
+  }
+
+  typename GridType::Ptr GetGrid() const { return m_Grid; }
+
+  //! Returns the accessor of the calling thread
+  AccessorType& Local() const {
+    auto& accessor = m_Accessors.local();
+    if (!accessor) {
+      accessor = std::make_unique<AccessorType>(m_Grid->constTree());
+    }
+    return *accessor;
+  }
+
+ private:
+  typename GridType::Ptr m_Grid;
+  mutable tbb::enumerable_thread_specific<std::unique_ptr<AccessorType>> m_Accessors;
+};
+
+}  // namespace shapeworks
@@ -14,6 +14,14 @@
 #include <igl/grad.h>
 #include <igl/per_vertex_normals.h>
 #include <geometrycentral/surface/surface_mesh_factories.h>
+#include <tbb/parallel_for.h>
+
+#include <array>
+#include <map>
+
+#include <Logging.h>
+
+#include "DomainDataRegistry.h"
 
 namespace shapeworks {
 
@@ -32,6 +40,25 @@ inline TO convert(FROM &value) {
 }
 }
 
+namespace {
+// FNV-1a hash of the mesh geometry and connectivity, used to key the persistent geodesic cache
+uint64_t HashMesh(const Eigen::MatrixXd& V, const Eigen::MatrixXi& F) {
+  uint64_t hash = 14695981039346656037ull;
+  auto add_bytes = [&](const void* data, size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+      hash ^= bytes[i];
+      hash *= 1099511628211ull;
+    }
+  };
+  const int64_t dims[4] = {V.rows(), V.cols(), F.rows(), F.cols()};
+  add_bytes(dims, sizeof(dims));
+  add_bytes(V.data(), V.size() * sizeof(double));
+  add_bytes(F.data(), F.size() * sizeof(int));
+  return hash;
+}
+}
+
 template<class T>
 inline std::string PrintValue(T value) {
   return "(" + std::to_string(value[0]) + ", " + std::to_string(value[1]) + ", " +
@@ -46,8 +73,81 @@ using GradNType = VtkMeshWrapper::GradNType;
 
 //---------------------------------------------------------------------------
 VtkMeshWrapper::VtkMeshWrapper(vtkSmartPointer<vtkPolyData> poly_data,
-                               bool is_geodesics_enabled, size_t geodesics_cache_size_multiplier) {
+                               bool is_geodesics_enabled, size_t geodesics_cache_size_multiplier,
+                               const std::string& geodesics_cache_directory,
+                               size_t geodesics_cache_file_bytes) {
   original_mesh_ = poly_data;
+  const uint64_t hash = HashPolyData(poly_data);
+  surface_ = DomainDataRegistry::Instance().GetOrCreate<const SurfaceData>(
+    "vtk_mesh_surface", hash, [&]() { return CreateSurfaceData(poly_data); });
+
+  this->cell_locator_ = vtkSmartPointer<vtkCellLocator>::New();
+  this->cell_locator_->SetCacheCellBounds(true);
+  this->cell_locator_->SetDataSet(surface_->poly_data);
+  this->cell_locator_->BuildLocator();
+
+  this->is_geodesics_enabled_ = is_geodesics_enabled;
+  if (is_geodesics_enabled_) {
+    if(geodesics_cache_size_multiplier == 0) {
+      // this is heuristic that gives a good trade off between memory usage and performance
+      geodesics_cache_size_multiplier = 120;
+    }
+
+    Eigen::MatrixXd V;
+    Eigen::MatrixXi F;
+    GetIGLMesh(surface_->poly_data, V, F);
+
+    // the caller provides how many times the number of triangles entries should be stored in cache, where an entry
+    // is the geodesic distance from each of a triangle's vertices to one vertex
+    this->geo_max_cache_bytes_ = geodesics_cache_size_multiplier * surface_->triangles.size() * 3 * sizeof(double);
+    this->geodesics_ = DomainDataRegistry::Instance().GetOrCreate<const GeodesicData>(
+      "vtk_mesh_geodesics", hash, [&]() { return CreateGeodesicData(*surface_, V, F); });
+
+    // Resize cache to correct size
+    this->geo_dist_cache_.resize(F.rows());
+    this->geo_referenced_.resize(F.rows(), 0);
+
+    if (!geodesics_cache_directory.empty()) {
+      if (geodesics_cache_file_bytes == 0) {
+        // by default, allow the file to hold as much as the in-memory cache
+        geodesics_cache_file_bytes = this->geo_max_cache_bytes_;
+      }
+      const auto filename = GeodesicCacheFile::GetFilename(geodesics_cache_directory, HashMesh(V, F));
+      this->geo_file_cache_ =
+          std::make_unique<GeodesicCacheFile>(filename, V.rows(), F.rows(), geodesics_cache_file_bytes);
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+uint64_t VtkMeshWrapper::HashPolyData(vtkPolyData* poly_data)
+{
+  ContentHash hash;
+  const vtkIdType n_points = poly_data->GetNumberOfPoints();
+  const vtkIdType n_cells = poly_data->GetNumberOfCells();
+  hash.AddValue(n_points);
+  hash.AddValue(n_cells);
+  for (vtkIdType i = 0; i < n_points; i++) {
+    double p[3];
+    poly_data->GetPoint(i, p);
+    hash.Add(p, sizeof(p));
+  }
+  auto ids = vtkSmartPointer<vtkIdList>::New();
+  for (vtkIdType i = 0; i < n_cells; i++) {
+    poly_data->GetCellPoints(i, ids);
+    const vtkIdType n_ids = ids->GetNumberOfIds();
+    hash.AddValue(n_ids);
+    hash.Add(ids->GetPointer(0), n_ids * sizeof(vtkIdType));
+  }
+  return hash.Get();
+}
+
+//---------------------------------------------------------------------------
+std::shared_ptr<const VtkMeshWrapper::SurfaceData>
+VtkMeshWrapper::CreateSurfaceData(vtkSmartPointer<vtkPolyData> poly_data)
+{
+  auto surface = std::make_shared<SurfaceData>();
+
   vtkSmartPointer<vtkTriangleFilter> triangle_filter =
           vtkSmartPointer<vtkTriangleFilter>::New();
   triangle_filter->SetInputData(poly_data);
@@ -67,13 +167,13 @@ VtkMeshWrapper::VtkMeshWrapper(vtkSmartPointer<vtkPolyData> poly_data,
   normals->ComputePointNormalsOn();
   normals->Update();
 
-  this->poly_data_ = normals->GetOutput();
-  this->poly_data_->BuildCells();
-  this->poly_data_->BuildLinks();
+  surface->poly_data = normals->GetOutput();
+  surface->poly_data->BuildCells();
+  surface->poly_data->BuildLinks();
 
   vtkSmartPointer<vtkGenericCell> cell = vtkSmartPointer<vtkGenericCell>::New();
-  for (int i = 0; i < this->poly_data_->GetNumberOfCells(); i++) {
-    this->poly_data_->GetCell(i, cell);
+  for (int i = 0; i < surface->poly_data->GetNumberOfCells(); i++) {
+    surface->poly_data->GetCell(i, cell);
     if (cell->GetNumberOfPoints() != 3) {
       throw std::runtime_error("Mesh input was not triangular");
     }
@@ -87,32 +187,22 @@ VtkMeshWrapper::VtkMeshWrapper(vtkSmartPointer<vtkPolyData> poly_data,
     triangle->GetPoints()->SetPoint(1, cell->GetPoints()->GetPoint(1));
     triangle->GetPoints()->SetPoint(2, cell->GetPoints()->GetPoint(2));
 
-    this->triangles_.push_back(triangle);
+    surface->triangles.push_back(triangle);
   }
 
-  this->cell_locator_ = vtkSmartPointer<vtkCellLocator>::New();
-  this->cell_locator_->SetCacheCellBounds(true);
-  this->cell_locator_->SetDataSet(this->poly_data_);
-  this->cell_locator_->BuildLocator();
-
-  this->ComputeMeshBounds();
+  ComputeMeshBounds(*surface);
 
   Eigen::MatrixXd V;
   Eigen::MatrixXi F;
-  this->GetIGLMesh(V, F);
-  this->ComputeGradN(V, F);
+  GetIGLMesh(surface->poly_data, V, F);
+  ComputeGradN(*surface, V, F);
 
-  this->is_geodesics_enabled_ = is_geodesics_enabled;
-  if (is_geodesics_enabled_) {
-    if(geodesics_cache_size_multiplier == 0) {
-      // this is heuristic that gives a good trade off between memory usage and performance
-      geodesics_cache_size_multiplier = 120;
-    }
+  return surface;
+}
 
-    // the caller provides how many times the number of triangles entries should be stored in cache
-    this->geo_max_cache_entries_ = geodesics_cache_size_multiplier * this->triangles_.size();
-    this->PrecomputeGeodesics(V, F);
-  }
+//---------------------------------------------------------------------------
+VtkMeshWrapper::~VtkMeshWrapper() {
+  GeodesicCacheBudget::Instance().Remove(geo_cache_bytes_);
 }
 
 //---------------------------------------------------------------------------
@@ -148,18 +238,20 @@ double VtkMeshWrapper::ComputeDistance(const PointType &pt_a, int idx_a,
   }
 
   // Define for convenience
-  const auto& faces = this->triangles_;
+  const auto& faces = surface_->triangles;
   const auto vb0 = faces[face_b]->GetPointId(0);
   const auto vb1 = faces[face_b]->GetPointId(1);
   const auto vb2 = faces[face_b]->GetPointId(2);
 
   // Ensure we have geodesics available in the cache. This will resize the cache to fit face_b or max_dist, whichever
   // is greater. We do this pre-emptively since GeodesicsFromTriangleToTriangle would pull geodesics to every point
-  // into the cache if face_b is not found. 1.5 is an heuristic to pull in a little more than we need
+  // into the cache if face_b is not found. 1.5 is an heuristic to pull in a little more than we need. An entry that
+  // already has face_b is used as is (requesting a max_dist of 0), so GeodesicsFromTriangle counts it as a hit
+  double max_dist = 0.0;
   if(!geo_dist_cache_[face_a].has_entry(face_b)) {
-    const double max_dist = idx_a >= 0 ? this->particle_neighboorhood_[idx_a]*1.5 : std::numeric_limits<double>::infinity();
-    GeodesicsFromTriangle(face_a, max_dist, face_b);
+    max_dist = idx_a >= 0 ? this->particle_neighboorhood_[idx_a]*1.5 : std::numeric_limits<double>::infinity();
   }
+  GeodesicsFromTriangle(face_a, max_dist, face_b);
 
   // Compute geodesic distance via barycentric approximation
   // Geometric Correspondence for Ensembles of Nonregular Shapes, Datar et al
@@ -174,7 +266,7 @@ double VtkMeshWrapper::ComputeDistance(const PointType &pt_a, int idx_a,
   }
 
   // Compute gradient of geodesics
-  const auto& G = face_grad_[face_a];
+  const auto& G = geodesics_->face_grad[face_a];
   Eigen::Vector3d out_grad_eigen = (G*geo_to_b).rowwise().sum();
   out_grad_eigen *= geo_dist / out_grad_eigen.norm();
 
@@ -186,6 +278,72 @@ double VtkMeshWrapper::ComputeDistance(const PointType &pt_a, int idx_a,
   return geo_dist;
 }
 
+//---------------------------------------------------------------------------
+void VtkMeshWrapper::ComputeDistancesToPoints(const std::vector<PointType>& sources,
+                                              const std::vector<PointType>& targets,
+                                              const std::function<void(size_t, const Eigen::VectorXd&)>& f) const
+{
+  const int n_targets = targets.size();
+  Eigen::VectorXd distances(n_targets);
+  if (!is_geodesics_enabled_) {
+    for (size_t i = 0; i < sources.size(); i++) {
+      for (int j = 0; j < n_targets; j++) {
+        distances[j] = sources[i].EuclideanDistanceTo(targets[j]);
+      }
+      f(i, distances);
+    }
+    return;
+  }
+
+  // the face (and barycentric coordinates) of every target, as ComputeDistance finds them for point b
+  std::vector<int> target_faces(n_targets);
+  std::vector<Eigen::Vector3d> target_bary(n_targets);
+  for (int j = 0; j < n_targets; j++) {
+    target_faces[j] = ComputeFaceAndWeights(targets[j], -1, target_bary[j]);
+  }
+
+  // geodesics from the vertices of the previous source's face, consecutive points of a curve often share some
+  std::map<int, Eigen::VectorXd> previous;
+
+  for (size_t i = 0; i < sources.size(); i++) {
+    vec3 bary_a;
+    const int face_a = ComputeFaceAndWeights(sources[i], -1, bary_a);
+
+    std::map<int, Eigen::VectorXd> current;
+    std::array<const Eigen::VectorXd*, 3> geo_from_a;
+    for (int k = 0; k < 3; k++) {
+      const int v = surface_->triangles[face_a]->GetPointId(k);
+      auto it = current.find(v);
+      if (it == current.end()) {
+        auto found = previous.find(v);
+        it = current.emplace(v, found != previous.end() ? std::move(found->second) : GeodesicsFromVertex(v)).first;
+      }
+      geo_from_a[k] = &it->second;
+    }
+    previous = std::move(current);
+
+    tbb::parallel_for(tbb::blocked_range<int>{0, n_targets}, [&](const tbb::blocked_range<int>& r) {
+      for (int j = r.begin(); j < r.end(); j++) {
+        const int face_b = target_faces[j];
+        // same fallback as ComputeDistance for points on the same or neighboring faces
+        if (face_a == face_b || AreFacesInKRing(face_a, face_b)) {
+          distances[j] = sources[i].EuclideanDistanceTo(targets[j]);
+          continue;
+        }
+        Eigen::Matrix3d geo;
+        for (int k = 0; k < 3; k++) {
+          for (int l = 0; l < 3; l++) {
+            geo(k, l) = (*geo_from_a[k])[surface_->triangles[face_b]->GetPointId(l)];
+          }
+        }
+        distances[j] = bary_a.dot(geo * target_bary[j]);
+      }
+    });
+
+    f(i, distances);
+  }
+}
+
 //---------------------------------------------------------------------------
 // Fetches face/triangle index and barycentric coordinates of point in face,
 // caching or retrieving results from cache if already cached.
@@ -233,9 +391,9 @@ bool VtkMeshWrapper::IsWithinDistance(const PointType &pt_a, int idx_a,
     return dist < test_dist;
   }
 
-  const auto vb0 = this->triangles_[face_b]->GetPointId(0);
-  const auto vb1 = this->triangles_[face_b]->GetPointId(1);
-  const auto vb2 = this->triangles_[face_b]->GetPointId(2);
+  const auto vb0 = surface_->triangles[face_b]->GetPointId(0);
+  const auto vb1 = surface_->triangles[face_b]->GetPointId(1);
+  const auto vb2 = surface_->triangles[face_b]->GetPointId(2);
 
   // 1.5 is an heuristic to pull in a little more than we need
   const auto& geo_entry = GeodesicsFromTriangle(face_a, test_dist*1.5);
@@ -291,7 +449,7 @@ PointType VtkMeshWrapper::GeodesicWalk(PointType p, int idx,
       particle_triangles_.resize(idx + 1, -1);
     }
 
-    particle_triangles_[idx] = ending_face;
+    SetParticleTriangle(idx, ending_face);
     geo_lq_cached_ = false;
 
     this->CalculateNormalAtPoint(new_point_pt, idx);
@@ -323,7 +481,8 @@ VtkMeshWrapper::ProjectVectorToSurfaceTangent(const PointType &pointa, int idx,
 
   int faceIndex = this->GetTriangleForPoint(point, idx, closest_point);
 
-  double* normal = this->poly_data_->GetCellData()->GetNormals()->GetTuple(faceIndex);
+  double normal[3];
+  surface_->poly_data->GetCellData()->GetNormals()->GetTuple(faceIndex, normal);
 
   Eigen::Vector3d vec_normal = convert<double*, vec3>(normal);
   Eigen::Vector3d vec_vector = convert<VectorType &, vec3>(vector);
@@ -352,8 +511,8 @@ GradNType VtkMeshWrapper::SampleGradNAtPoint(PointType p, int idx) const
   GradNType weighted_grad_normal = GradNType(0.0);
 
   for (int i = 0; i < 3; i++) {
-    auto id = this->triangles_[face_index]->GetPointId(i);
-    GradNType grad_normal = grad_normals_[id];
+    auto id = surface_->triangles[face_index]->GetPointId(i);
+    GradNType grad_normal = surface_->grad_normals[id];
     grad_normal *= weights[i];
     weighted_grad_normal += grad_normal;
   }
@@ -405,7 +564,7 @@ int VtkMeshWrapper::GetTriangleForPoint(const double pt[3], int idx, double clos
 
   if (idx >= 0) {
     // update cache, no need to check size as it was already checked above
-    particle_triangles_[idx] = cell_id;
+    SetParticleTriangle(idx, cell_id);
   }
 
   assert(cell_id >= 0);
@@ -433,21 +592,21 @@ VtkMeshWrapper::ProjectVectorToFace(const Eigen::Vector3d &normal,
 }
 
 //---------------------------------------------------------------------------
-void VtkMeshWrapper::ComputeMeshBounds()
+void VtkMeshWrapper::ComputeMeshBounds(SurfaceData& surface)
 {
   double buffer = 5.0;
   double bounds[6];
-  this->poly_data_->GetBounds(bounds);
-  this->mesh_lower_bound_[0] = bounds[0] - buffer;
-  this->mesh_lower_bound_[1] = bounds[2] - buffer;
-  this->mesh_lower_bound_[2] = bounds[4] - buffer;
-  this->mesh_upper_bound_[0] = bounds[1] + buffer;
-  this->mesh_upper_bound_[1] = bounds[3] + buffer;
-  this->mesh_upper_bound_[2] = bounds[5] + buffer;
+  surface.poly_data->GetBounds(bounds);
+  surface.lower_bound[0] = bounds[0] - buffer;
+  surface.lower_bound[1] = bounds[2] - buffer;
+  surface.lower_bound[2] = bounds[4] - buffer;
+  surface.upper_bound[0] = bounds[1] + buffer;
+  surface.upper_bound[1] = bounds[3] + buffer;
+  surface.upper_bound[2] = bounds[5] + buffer;
 }
 
 //---------------------------------------------------------------------------
-void VtkMeshWrapper::ComputeGradN(const Eigen::MatrixXd& V, const Eigen::MatrixXi& F)
+void VtkMeshWrapper::ComputeGradN(SurfaceData& surface, const Eigen::MatrixXd& V, const Eigen::MatrixXi& F)
 {
   const int n_verts = V.rows();
   const int n_faces = F.rows();
@@ -483,12 +642,12 @@ void VtkMeshWrapper::ComputeGradN(const Eigen::MatrixXd& V, const Eigen::MatrixX
   }
 
   // Copy back to VNL data structure
-  grad_normals_.resize(n_verts);
+  surface.grad_normals.resize(n_verts);
   for (int j = 0; j < n_verts; j++) {
     for (int i = 0; i < 3; i++) {
-      grad_normals_[j].set(i, 0, GN_pervertex(j, i * 3 + 0));
-      grad_normals_[j].set(i, 1, GN_pervertex(j, i * 3 + 1));
-      grad_normals_[j].set(i, 2, GN_pervertex(j, i * 3 + 2));
+      surface.grad_normals[j].set(i, 0, GN_pervertex(j, i * 3 + 0));
+      surface.grad_normals[j].set(i, 1, GN_pervertex(j, i * 3 + 1));
+      surface.grad_normals[j].set(i, 2, GN_pervertex(j, i * 3 + 2));
     }
   }
 
@@ -503,7 +662,7 @@ bool VtkMeshWrapper::IsInTriangle(const double* pt, int face_index) const
   double dist2;
   double bary[3];
 
-  int ret = this->triangles_[face_index]->EvaluatePosition(pt, closest, sub_id, pcoords, dist2,
+  int ret = surface_->triangles[face_index]->EvaluatePosition(pt, closest, sub_id, pcoords, dist2,
                                                            bary);
   if (ret && dist2 < epsilon) {
     bool bary_check = ((bary[0] >= -epsilon) && (bary[0] <= 1 + epsilon)) &&
@@ -523,15 +682,16 @@ Eigen::Vector3d VtkMeshWrapper::ComputeBarycentricCoordinates(const Eigen::Vecto
   double pcoords[3];
   double dist2;
   Eigen::Vector3d bary;
-  this->triangles_[face]->EvaluatePosition(pt.data(), closest, sub_id, pcoords, dist2, bary.data());
+  surface_->triangles[face]->EvaluatePosition(pt.data(), closest, sub_id, pcoords, dist2, bary.data());
   return bary;
 }
 
 //---------------------------------------------------------------------------
 const Eigen::Vector3d VtkMeshWrapper::GetFaceNormal(int face_index) const
 {
-  auto normals = this->poly_data_->GetCellData()->GetNormals();
-  double* normal = normals->GetTuple(face_index);
+  auto normals = surface_->poly_data->GetCellData()->GetNormals();
+  double normal[3];
+  normals->GetTuple(face_index, normal);
   Eigen::Vector3d n(normal[0], normal[1], normal[2]);
   return n;
 }
@@ -678,11 +838,12 @@ VtkMeshWrapper::GetBarycentricIntersection(Eigen::Vector3d start, Eigen::Vector3
   double ratio = -start[edge] / delta[edge];
   vec3 intersect = start + delta * ratio;
 
-  auto cell = this->poly_data_->GetCell(currentFace);
+  const auto& triangle = surface_->triangles[currentFace];
 
   vec3 inter(0, 0, 0);
   for (int q = 0; q < 3; q++) {
-    auto point = cell->GetPoints()->GetPoint(q);
+    double point[3];
+    triangle->GetPoints()->GetPoint(q, point);
     vec3 p(point[0], point[1], point[2]);
     inter += p * intersect[q];
   }
@@ -696,18 +857,18 @@ int VtkMeshWrapper::GetAcrossEdge(int face_id, int edge_id) const
   // get the neighbors of the cell
   auto neighbors = vtkSmartPointer<vtkIdList>::New();
 
-  int edge_p1 = this->triangles_[face_id]->GetPointId(1);
-  int edge_p2 = this->triangles_[face_id]->GetPointId(2);
+  int edge_p1 = surface_->triangles[face_id]->GetPointId(1);
+  int edge_p2 = surface_->triangles[face_id]->GetPointId(2);
   if (edge_id == 1) {
-    edge_p1 = this->triangles_[face_id]->GetPointId(2);
-    edge_p2 = this->triangles_[face_id]->GetPointId(0);
+    edge_p1 = surface_->triangles[face_id]->GetPointId(2);
+    edge_p2 = surface_->triangles[face_id]->GetPointId(0);
   }
   else if (edge_id == 2) {
-    edge_p1 = this->triangles_[face_id]->GetPointId(0);
-    edge_p2 = this->triangles_[face_id]->GetPointId(1);
+    edge_p1 = surface_->triangles[face_id]->GetPointId(0);
+    edge_p2 = surface_->triangles[face_id]->GetPointId(1);
   }
 
-  this->poly_data_->GetCellEdgeNeighbors(face_id, edge_p1, edge_p2, neighbors);
+  surface_->poly_data->GetCellEdgeNeighbors(face_id, edge_p1, edge_p2, neighbors);
 
   if (neighbors->GetNumberOfIds() == 0) {
     // This is the boundary edge of an open mesh
@@ -758,13 +919,14 @@ int VtkMeshWrapper::SlideAlongEdge(Eigen::Vector3d &point, Eigen::Vector3d &rema
 //---------------------------------------------------------------------------
 int VtkMeshWrapper::GetFacePointID(int face, int point_id) const
 {
-  return this->poly_data_->GetCell(face)->GetPointId(point_id);
+  return surface_->triangles[face]->GetPointId(point_id);
 }
 
 //---------------------------------------------------------------------------
 Eigen::Vector3d VtkMeshWrapper::GetVertexCoords(int vertex_id) const
 {
-  double* p = this->poly_data_->GetPoint(vertex_id);
+  double p[3];
+  surface_->poly_data->GetPoint(vertex_id, p);
   return Eigen::Vector3d(p[0], p[1], p[2]);
 }
 
@@ -794,8 +956,9 @@ NormalType VtkMeshWrapper::CalculateNormalAtPoint(PointType p, int idx) const
   NormalType weighted_normal(0, 0, 0);
 
   for (int i = 0; i < 3; i++) {
-    auto id = this->triangles_[face_index]->GetPointId(i);
-    double* normal = this->poly_data_->GetPointData()->GetNormals()->GetTuple(id);
+    auto id = surface_->triangles[face_index]->GetPointId(i);
+    double normal[3];
+    surface_->poly_data->GetPointData()->GetNormals()->GetTuple(id, normal);
     weighted_normal[0] = weighted_normal[0] + normal[0] * weights[i];
     weighted_normal[1] = weighted_normal[1] + normal[1] * weights[i];
     weighted_normal[2] = weighted_normal[2] + normal[2] * weights[i];
@@ -820,7 +983,7 @@ void VtkMeshWrapper::InvalidateParticle(int idx)
   if (idx >= particle_triangles_.size()) {
     particle_triangles_.resize(idx + 1, -1);
   }
-  this->particle_triangles_[idx] = -1;
+  SetParticleTriangle(idx, -1);
   this->geo_lq_cached_ = false;
 }
 
@@ -835,15 +998,15 @@ int VtkMeshWrapper::ComputeFaceAndWeights(const PointType& p, int idx, Eigen::Ve
 }
 
 //---------------------------------------------------------------------------
-void VtkMeshWrapper::GetIGLMesh(Eigen::MatrixXd& V, Eigen::MatrixXi& F) const
+void VtkMeshWrapper::GetIGLMesh(vtkPolyData* poly_data, Eigen::MatrixXd& V, Eigen::MatrixXi& F)
 {
-  const int n_verts = this->poly_data_->GetNumberOfPoints();
-  const int n_faces = this->poly_data_->GetNumberOfCells();
+  const int n_verts = poly_data->GetNumberOfPoints();
+  const int n_faces = poly_data->GetNumberOfCells();
 
   V.resize(n_verts, 3);
   F.resize(n_faces, 3);
 
-  auto points = this->poly_data_->GetPoints();
+  auto points = poly_data->GetPoints();
   for (int i = 0; i < n_verts; i++) {
     double p[3];
     points->GetPoint(i, p);
@@ -851,27 +1014,28 @@ void VtkMeshWrapper::GetIGLMesh(Eigen::MatrixXd& V, Eigen::MatrixXi& F) const
     V(i, 1) = p[1];
     V(i, 2) = p[2];
   }
+  auto ids = vtkSmartPointer<vtkIdList>::New();
   for (int i = 0; i < n_faces; i++) {
-    auto cell = this->poly_data_->GetCell(i);
-    assert (cell->GetNumberOfPoints() == 3);
-    F(i, 0) = cell->GetPointId(0);
-    F(i, 1) = cell->GetPointId(1);
-    F(i, 2) = cell->GetPointId(2);
+    poly_data->GetCellPoints(i, ids);
+    assert (ids->GetNumberOfIds() == 3);
+    F(i, 0) = ids->GetId(0);
+    F(i, 1) = ids->GetId(1);
+    F(i, 2) = ids->GetId(2);
   }
 }
 
 //---------------------------------------------------------------------------
-void VtkMeshWrapper::PrecomputeGeodesics(const Eigen::MatrixXd& V, const Eigen::MatrixXi& F)
+std::shared_ptr<const VtkMeshWrapper::GeodesicData>
+VtkMeshWrapper::CreateGeodesicData(const SurfaceData& surface, const Eigen::MatrixXd& V, const Eigen::MatrixXi& F)
 {
-  // Resize cache to correct size
-  geo_dist_cache_.resize(F.rows());
+  auto geodesics = std::make_shared<GeodesicData>();
 
   // Compute gradient operator
   Eigen::SparseMatrix<double> G;
   igl::grad(V, F, G);
 
   // Flatten the gradient operator so we can quickly compute the gradient at a given point
-  face_grad_.resize(F.rows());
+  geodesics->face_grad.resize(F.rows());
   size_t n_insertions = 0;
   for(int k=0; k<G.outerSize(); k++) {
     for(Eigen::SparseMatrix<double>::InnerIterator it(G, k); it; ++it) {
@@ -883,7 +1047,7 @@ void VtkMeshWrapper::PrecomputeGeodesics(const Eigen::MatrixXd& V, const Eigen::
       const auto axis = r / F.rows();
       for(int i=0; i<3; i++) {
         if(F(f, i) == c) {
-          face_grad_[f](axis, i) = val;
+          geodesics->face_grad[f](axis, i) = val;
           n_insertions++;
           break;
         }
@@ -896,49 +1060,46 @@ void VtkMeshWrapper::PrecomputeGeodesics(const Eigen::MatrixXd& V, const Eigen::
   // geometry central stuff
   {
     using namespace geometrycentral::surface;
-    std::tie(gc_mesh_, gc_geometry_) = makeSurfaceMeshAndGeometry(V, F);
-    gc_heatsolver_ = std::make_unique<HeatMethodDistanceSolver>(*gc_geometry_, 1.0, true);
+    std::tie(geodesics->gc_mesh, geodesics->gc_geometry) = makeSurfaceMeshAndGeometry(V, F);
   }
 
   // compute k-ring
-  face_kring_.resize(this->triangles_.size());
-  for(int f=0; f<this->triangles_.size(); f++) {
-    ComputeKRing(f, kring_, face_kring_[f]);
+  geodesics->face_kring.resize(surface.triangles.size());
+  for(int f=0; f<surface.triangles.size(); f++) {
+    ComputeKRing(surface, f, kring_, geodesics->face_kring[f]);
   }
+
+  return geodesics;
 }
 
 //---------------------------------------------------------------------------
 bool VtkMeshWrapper::AreFacesInKRing(int f_a, int f_b) const
 {
-  return face_kring_[f_a].find(f_b) != face_kring_[f_a].end();
+  const auto& ring = geodesics_->face_kring[f_a];
+  return ring.find(f_b) != ring.end();
 }
 
 //---------------------------------------------------------------------------
 const MeshGeoEntry& VtkMeshWrapper::GeodesicsFromTriangle(int f, double max_dist, int req_target_f) const
 {
-  if(geo_cache_size_ >= geo_max_cache_entries_) {
-    this->ClearGeodesicCache();
-  }
-
   auto& entry = geo_dist_cache_[f];
-  if(entry.is_full_mode()) {
-    return entry;
-  }
-
-  if(entry.max_dist >= max_dist) {
+  geo_referenced_[f] = 1;
+  if(entry.is_full_mode() || entry.max_dist >= max_dist) {
+    geo_stats_.hits++;
     return entry;
   }
+  geo_stats_.misses++;
 
-  geo_cache_size_ -= entry.data_partial.size();
+  const size_t old_bytes = entry.bytes();
   entry.data_partial.clear();
 
-  const auto n_verts = this->poly_data_->GetNumberOfPoints();
+  const auto n_verts = surface_->poly_data->GetNumberOfPoints();
 
   const auto which_vert_of_tri = [&](int tri, int v) {
-    if(triangles_[tri]->GetPointId(0) == v) {
+    if(surface_->triangles[tri]->GetPointId(0) == v) {
       return 0;
     }
-    if(triangles_[tri]->GetPointId(1) == v) {
+    if(surface_->triangles[tri]->GetPointId(1) == v) {
       return 1;
     }
     return 2;
@@ -952,8 +1113,8 @@ const MeshGeoEntry& VtkMeshWrapper::GeodesicsFromTriangle(int f, double max_dist
   // partial mode values, so we don't do that.
   auto incident_cells = vtkSmartPointer<vtkIdList>::New();
   for(int i=0; i<3; i++) {
-    const int v = this->triangles_[f]->GetPointId(i);
-    this->poly_data_->GetPointCells(v, incident_cells);
+    const int v = surface_->triangles[f]->GetPointId(i);
+    surface_->poly_data->GetPointCells(v, incident_cells);
     for(int j=0; j<incident_cells->GetNumberOfIds(); j++) {
       const int f_j = incident_cells->GetId(j);
       if(f_j == f) {
@@ -973,10 +1134,7 @@ const MeshGeoEntry& VtkMeshWrapper::GeodesicsFromTriangle(int f, double max_dist
       // we have already figured out these geodesics using a neighbor's
       continue;
     }
-    // todo switch to zero-copy API when that is available: https://github.com/nmwsharp/geometry-central/issues/77
-    const auto v = gc_mesh_->vertex(this->triangles_[f]->GetPointId(i));
-    const auto gc_dists = gc_heatsolver_->computeDistance(v);
-    dists[i] = std::move(gc_dists.raw());
+    dists[i] = GeodesicsFromVertex(surface_->triangles[f]->GetPointId(i));
   }
 
   if(max_dist == std::numeric_limits<double>::infinity()) {
@@ -985,13 +1143,13 @@ const MeshGeoEntry& VtkMeshWrapper::GeodesicsFromTriangle(int f, double max_dist
     entry.data_full[1] = std::move(dists[1]);
     entry.data_full[2] = std::move(dists[2]);
     entry.update_max_dist();
-    geo_cache_size_ += n_verts;
+    UpdateGeodesicCacheEntry(f, old_bytes);
     return entry;
   }
 
   if(req_target_f >= 0) {
     for(int i=0; i<3; i++) {
-      const int req_v = this->triangles_[req_target_f]->GetPointId(i);
+      const int req_v = surface_->triangles[req_target_f]->GetPointId(i);
       max_dist = std::max({
         max_dist,
         dists[0][req_v],
@@ -1013,9 +1171,9 @@ const MeshGeoEntry& VtkMeshWrapper::GeodesicsFromTriangle(int f, double max_dist
     const auto& d1 = dists[1][i];
     const auto& d2 = dists[2][i];
     if(d0 <= max_dist || d1 <= max_dist || d2 <= max_dist) {
-      this->poly_data_->GetPointCells(i, incident_cells);
+      surface_->poly_data->GetPointCells(i, incident_cells);
       for(int j=0; j<incident_cells->GetNumberOfIds(); j++) {
-        const auto& tri = this->triangles_[incident_cells->GetId(j)];
+        const auto& tri = surface_->triangles[incident_cells->GetId(j)];
         needed_points.insert(tri->GetPointId(0));
         needed_points.insert(tri->GetPointId(1));
         needed_points.insert(tri->GetPointId(2));
@@ -1036,7 +1194,7 @@ const MeshGeoEntry& VtkMeshWrapper::GeodesicsFromTriangle(int f, double max_dist
     entry.data_full[1] = std::move(dists[1]);
     entry.data_full[2] = std::move(dists[2]);
     entry.update_max_dist();
-    geo_cache_size_ += n_verts;
+    UpdateGeodesicCacheEntry(f, old_bytes);
     return entry;
   }
 
@@ -1048,18 +1206,45 @@ const MeshGeoEntry& VtkMeshWrapper::GeodesicsFromTriangle(int f, double max_dist
     entry.data_partial[v] = {d0, d1, d2};
   }
 
-  geo_cache_size_ += entry.data_partial.size();
   entry.max_dist = new_max_dist;
+  UpdateGeodesicCacheEntry(f, old_bytes);
   return entry;
 }
 
+//---------------------------------------------------------------------------
+Eigen::VectorXd VtkMeshWrapper::GeodesicsFromVertex(int v) const
+{
+  Eigen::VectorXd dists;
+  if(geo_file_cache_ && geo_file_cache_->Get(v, dists)) {
+    return dists;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(geodesics_->heat_solver_mutex);
+    if(!geodesics_->heat_solver) {
+      using namespace geometrycentral::surface;
+      geodesics_->heat_solver = std::make_unique<HeatMethodDistanceSolver>(*geodesics_->gc_geometry, 1.0, true);
+    }
+
+    // todo switch to zero-copy API when that is available: https://github.com/nmwsharp/geometry-central/issues/77
+    const auto gc_dists = geodesics_->heat_solver->computeDistance(geodesics_->gc_mesh->vertex(v));
+    dists = std::move(gc_dists.raw());
+  }
+
+  if(geo_file_cache_) {
+    geo_file_cache_->Put(v, dists);
+  }
+  return dists;
+}
+
 //---------------------------------------------------------------------------
 const Eigen::Matrix3d VtkMeshWrapper::GeodesicsFromTriangleToTriangle(int f_a, int f_b) const
 {
   auto& entry = geo_dist_cache_[f_a];
-  const int v0 = this->triangles_[f_b]->GetPointId(0);
-  const int v1 = this->triangles_[f_b]->GetPointId(1);
-  const int v2 = this->triangles_[f_b]->GetPointId(2);
+  geo_referenced_[f_a] = 1;
+  const int v0 = surface_->triangles[f_b]->GetPointId(0);
+  const int v1 = surface_->triangles[f_b]->GetPointId(1);
+  const int v2 = surface_->triangles[f_b]->GetPointId(2);
 
   if(entry.is_full_mode()) {
     Eigen::Matrix3d result;
@@ -1091,52 +1276,119 @@ const Eigen::Matrix3d VtkMeshWrapper::GeodesicsFromTriangleToTriangle(int f_a, i
 }
 
 //---------------------------------------------------------------------------
-void VtkMeshWrapper::ClearGeodesicCache() const {
-  const auto n_verts = this->poly_data_->GetNumberOfPoints();
+void VtkMeshWrapper::UpdateGeodesicCacheEntry(int f, size_t old_bytes) const {
+  const size_t new_bytes = geo_dist_cache_[f].bytes();
+  geo_cache_bytes_ = geo_cache_bytes_ + new_bytes - old_bytes;
+  auto& budget = GeodesicCacheBudget::Instance();
+  budget.Add(new_bytes);
+  budget.Remove(old_bytes);
+
+  if(IsGeodesicCacheOverBudget()) {
+    EvictGeodesics(f);
+  }
+}
+
+//---------------------------------------------------------------------------
+bool VtkMeshWrapper::IsGeodesicCacheOverBudget() const {
+  return geo_cache_bytes_ > geo_max_cache_bytes_ || GeodesicCacheBudget::Instance().IsExceeded();
+}
 
-  // figure out which triangle each particle is on
+//---------------------------------------------------------------------------
+void VtkMeshWrapper::SetParticleTriangle(int idx, int f) const {
+  if(particle_triangles_[idx] != f) {
+    particle_triangles_[idx] = f;
+    geo_pinned_version_++;
+  }
+}
+
+//---------------------------------------------------------------------------
+void VtkMeshWrapper::EvictGeodesics(int keep_f) const {
+  auto& budget = GeodesicCacheBudget::Instance();
+  const size_t limit = budget.GetBudget();
+
+  // the last eviction found everything left pinned, and another sweep can't free more until that changes
+  if(geo_evict_blocked_ && geo_evict_blocked_version_ == geo_pinned_version_ && geo_evict_blocked_budget_ == limit) {
+    return;
+  }
+  geo_evict_blocked_ = false;
+
+  // Evict down to this mesh's own limit and, if all meshes together are over the shared budget, by this mesh's share
+  // of the excess. The other meshes evict their share as they miss, so no mesh gives up entries for memory it doesn't
+  // hold.
+  size_t target = geo_max_cache_bytes_;
+  const size_t used = budget.GetUsed();
+  if(limit > 0 && used > limit) {
+    target = std::min(target, static_cast<size_t>(geo_cache_bytes_ * (static_cast<double>(limit) / used)));
+  }
+  if(geo_cache_bytes_ <= target) {
+    return;
+  }
+
+  // triangles holding particles will be needed again right away, so they are never evicted
   robin_hood::unordered_set<int> active_triangles(particle_triangles_.begin(), particle_triangles_.end());
-  size_t new_cache_size = 0;
 
-  // clear entries only if no particle is on that triangle. (this is significantly more performant than clearing everything)
-  for(int i=0; i<geo_dist_cache_.size(); i++) {
-    auto& entry = geo_dist_cache_[i];
-    if(active_triangles.find(i) == active_triangles.end()) {
+  // CLOCK: sweep the triangles, giving recently used entries a second chance. A turn of the hand that neither frees an
+  // entry nor clears a reference bit means everything left is pinned, so stop there.
+  const size_t n = geo_dist_cache_.size();
+  while(geo_cache_bytes_ > target) {
+    bool progress = false;
+    for(size_t steps = 0; steps < n && geo_cache_bytes_ > target; steps++) {
+      geo_clock_hand_ = (geo_clock_hand_ + 1) % n;
+      const int f = static_cast<int>(geo_clock_hand_);
+      auto& entry = geo_dist_cache_[f];
+      const size_t bytes = entry.bytes();
+      if(f == keep_f || bytes == 0 || active_triangles.find(f) != active_triangles.end()) {
+        continue;
+      }
+      progress = true;
+      if(geo_referenced_[f]) {
+        geo_referenced_[f] = 0;
+        continue;
+      }
       entry.clear();
-    } else {
-      new_cache_size += entry.is_full_mode() ? n_verts : entry.data_partial.size();
+      geo_cache_bytes_ -= bytes;
+      budget.Remove(bytes);
+      geo_stats_.evictions++;
+    }
+    if(!progress) {
+      break;
     }
   }
 
-  // the cache is not large enough to store the subset that we know is required. we are forced to clear everything
-  if(new_cache_size > geo_max_cache_entries_) {
-    std::cerr << "Warning: Cache entries too small, clearing everything. Consider increasing cache size if this happens repeatedly\n";
-    for(auto i : active_triangles) {
-      if(i >= 0) {
-        geo_dist_cache_[i].clear();
-      }
+  if(geo_cache_bytes_ > target) {
+    geo_evict_blocked_ = true;
+    geo_evict_blocked_version_ = geo_pinned_version_;
+    geo_evict_blocked_budget_ = limit;
+    if(!geo_budget_warned_) {
+      geo_budget_warned_ = true;
+      SW_WARN("Geodesic cache budget is smaller than the entries needed by the current particles ({} MB in use). "
+              "Consider increasing the cache size", geo_cache_bytes_ / (1024 * 1024));
     }
-    new_cache_size = 0;
   }
+}
 
-  geo_cache_size_ = new_cache_size;
+//---------------------------------------------------------------------------
+VtkMeshWrapper::GeodesicCacheStats VtkMeshWrapper::GetGeodesicCacheStats() const {
+  auto stats = geo_stats_;
+  stats.bytes = geo_cache_bytes_;
+  return stats;
 }
 
 //---------------------------------------------------------------------------
-void VtkMeshWrapper::ComputeKRing(int f, int k, std::unordered_set<int>& ring) const {
+void VtkMeshWrapper::ComputeKRing(const SurfaceData& surface, int f, int k, std::unordered_set<int>& ring) {
   if(k == 0) {
     return;
   }
 
   auto neighbors = vtkSmartPointer<vtkIdList>::New();
   for(int i=0; i<3; i++) {
-    const int v = this->triangles_[f]->GetPointId(i);
-    this->poly_data_->GetPointCells(v, neighbors);
+    const int v = surface.triangles[f]->GetPointId(i);
+    surface.poly_data->GetPointCells(v, neighbors);
     for(int j=0; j<neighbors->GetNumberOfIds(); j++) {
       const int f_j = neighbors->GetId(j);
       if(ring.find(f_j) == ring.end()) {
         ring.insert(f_j);
-        ComputeKRing(f_j, k-1, ring);
+        ComputeKRing(surface, f_j, k-1, ring);
       }
     }
   }
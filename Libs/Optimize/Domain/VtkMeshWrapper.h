@@ -6,10 +6,14 @@
 #include <vtkPolyData.h>
 #include <vtkSmartPointer.h>
 
+#include <functional>
+#include <mutex>
 #include <unordered_map>
 #include <unordered_set>
 
 #include "ExternalLibs/robin_hood/robin_hood.h"
+#include "GeodesicCacheBudget.h"
+#include "GeodesicCacheFile.h"
 #include "MeshGeoEntry.h"
 #include "MeshWrapper.h"
 
@@ -28,9 +32,21 @@ public:
 
   explicit VtkMeshWrapper(vtkSmartPointer<vtkPolyData> mesh,
                           bool geodesics_enabled=false,
-                          size_t geodesics_cache_multiplier_size=0); // 0 => VtkMeshWrapper will choose a heuristic
+                          size_t geodesics_cache_multiplier_size=0, // 0 => VtkMeshWrapper will choose a heuristic
+                          const std::string& geodesics_cache_directory="", // "" => no persistent cache
+                          size_t geodesics_cache_file_bytes=0); // 0 => VtkMeshWrapper will choose a default
 
-  ~VtkMeshWrapper() = default;
+  ~VtkMeshWrapper();
+
+  //! Counters of the in-memory geodesic cache
+  struct GeodesicCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t bytes = 0;
+  };
+
+  GeodesicCacheStats GetGeodesicCacheStats() const;
 
   double ComputeDistance(const PointType& pointa, int idxa,
                          const PointType& pointb, int idxb, VectorType* out_grad=nullptr) const override;
@@ -39,6 +55,12 @@ public:
                         const PointType& pointb, int idxb,
                         double test_dist, double& dist) const override;
 
+  //! Calls f(i, distances) with the distance from sources[i] to each of the targets, as ComputeDistance would return
+  //! it.  The faces of the targets are looked up once for all sources, and every source only costs the heat method
+  //! solves of the vertices of its face, which share one factorization of the mesh.
+  void ComputeDistancesToPoints(const std::vector<PointType>& sources, const std::vector<PointType>& targets,
+                                const std::function<void(size_t, const Eigen::VectorXd&)>& f) const;
+
   PointType GeodesicWalk(PointType p, int idx, VectorType vector) const override;
 
   VectorType ProjectVectorToSurfaceTangent(const PointType &pointa, int idx,
@@ -53,12 +75,12 @@ public:
 
   inline const PointType &GetMeshLowerBound() const override
   {
-    return mesh_lower_bound_;
+    return surface_->lower_bound;
   }
 
   inline const PointType &GetMeshUpperBound() const override
   {
-    return mesh_upper_bound_;
+    return surface_->upper_bound;
   }
 
   virtual void InvalidateParticle(int idx) override;
@@ -69,8 +91,46 @@ public:
 
 private:
 
-  void ComputeMeshBounds();
-  void ComputeGradN(const Eigen::MatrixXd& V, const Eigen::MatrixXi& F);
+  // Surface data that depends only on the input mesh. Wrappers of identical meshes share one copy
+  // through the DomainDataRegistry, so it must not be modified once built.
+  struct SurfaceData {
+    vtkSmartPointer<vtkPolyData> poly_data;
+
+    // cache of specialized cells for direct access
+    std::vector<vtkSmartPointer<vtkTriangle>> triangles;
+
+    std::vector<GradNType> grad_normals;
+
+    // bounds of the mesh plus some buffer
+    PointType lower_bound;
+    PointType upper_bound;
+  };
+
+  // Geodesic data that depends only on the input mesh, shared like SurfaceData
+  struct GeodesicData {
+    // Flattened version of libigl's gradient operator
+    std::vector<Eigen::Matrix3d> face_grad;
+
+    std::vector<std::unordered_set<int>> face_kring;
+
+    // Geometry Central data structures
+    std::unique_ptr<geometrycentral::surface::SurfaceMesh> gc_mesh;
+    std::unique_ptr<geometrycentral::surface::VertexPositionGeometry> gc_geometry;
+
+    // constructed on first use, so runs that find everything in the persistent cache skip the factorization.
+    // Geometry Central solvers are not safe to use from several threads, so creating the solver and solving
+    // hold heat_solver_mutex
+    mutable std::unique_ptr<geometrycentral::surface::HeatMethodDistanceSolver> heat_solver;
+    mutable std::mutex heat_solver_mutex;
+  };
+
+  static uint64_t HashPolyData(vtkPolyData* poly_data);
+  static std::shared_ptr<const SurfaceData> CreateSurfaceData(vtkSmartPointer<vtkPolyData> poly_data);
+  // Precompute heat data structures for faster geodesic lookups
+  static std::shared_ptr<const GeodesicData> CreateGeodesicData(const SurfaceData& surface, const Eigen::MatrixXd& V,
+                                                                const Eigen::MatrixXi& F);
+  static void ComputeMeshBounds(SurfaceData& surface);
+  static void ComputeGradN(SurfaceData& surface, const Eigen::MatrixXd& V, const Eigen::MatrixXi& F);
 
 
   int GetTriangleForPoint(const double pt[3], int idx, double closest_point[3]) const;
@@ -106,9 +166,13 @@ private:
   RotateVectorToFace(const Eigen::Vector3d &prev_normal, const Eigen::Vector3d &next_normal,
                      const Eigen::Vector3d &vector) const;
 
-  vtkSmartPointer<vtkPolyData> poly_data_;
+  std::shared_ptr<const SurfaceData> surface_;
   vtkSmartPointer<vtkPolyData> original_mesh_;
 
+  // cell locator to find closest point on mesh. Queries modify the locator's internal state, so every
+  // wrapper builds its own over the shared poly data
+  vtkSmartPointer<vtkCellLocator> cell_locator_;
+
   NormalType CalculateNormalAtPoint(VtkMeshWrapper::PointType p, int idx) const;
 
   // Caches of triangle, normal and position
@@ -118,18 +182,6 @@ private:
   mutable std::vector<PointType> particle_positions_;
   mutable std::vector<double> particle_neighboorhood_;
 
-  std::vector<GradNType> grad_normals_;
-
-  // cache of specialized cells for direct access
-  std::vector<vtkSmartPointer<vtkTriangle>> triangles_;
-
-  // bounds of the mesh plus some buffer
-  PointType mesh_lower_bound_;
-  PointType mesh_upper_bound_;
-
-  // cell locator to find closest point on mesh
-  vtkSmartPointer<vtkCellLocator> cell_locator_;
-
   /////////////////////////
   // Geodesic distances
 
@@ -140,38 +192,54 @@ private:
     return this->is_geodesics_enabled_;
   }
 
-  // Geometry Central data structures
-  std::unique_ptr<geometrycentral::surface::SurfaceMesh> gc_mesh_;
-  std::unique_ptr<geometrycentral::surface::VertexPositionGeometry> gc_geometry_;
-  std::unique_ptr<geometrycentral::surface::HeatMethodDistanceSolver> gc_heatsolver_;
+  std::shared_ptr<const GeodesicData> geodesics_;
+
+  // Persistent cache of heat method solutions, shared across runs on the same mesh
+  std::unique_ptr<GeodesicCacheFile> geo_file_cache_;
 
-  size_t geo_max_cache_entries_{0};
-  mutable size_t geo_cache_size_{0};
+  // byte limit of this mesh's cache. The limit of GeodesicCacheBudget applies to all meshes together
+  size_t geo_max_cache_bytes_{0};
+  mutable size_t geo_cache_bytes_{0};
+  mutable GeodesicCacheStats geo_stats_;
 
-  // Flattened version of libigl's gradient operator
-  std::vector<Eigen::Matrix3d> face_grad_;
+  // CLOCK eviction state: a reference bit per triangle and the position of the clock hand
+  mutable std::vector<uint8_t> geo_referenced_;
+  mutable size_t geo_clock_hand_{0};
+  mutable bool geo_budget_warned_{false};
 
-  std::vector<std::unordered_set<int>> face_kring_;
+  // bumped whenever a particle moves to another triangle, i.e. the set of triangles that can't be evicted changes
+  mutable size_t geo_pinned_version_{0};
+  // set when eviction couldn't get under budget, with the pinned set and budget it saw, to skip futile sweeps
+  mutable bool geo_evict_blocked_{false};
+  mutable size_t geo_evict_blocked_version_{0};
+  mutable size_t geo_evict_blocked_budget_{0};
 
   // Cache for geodesic distances from a triangle
   mutable std::vector<MeshGeoEntry> geo_dist_cache_;
 
   // Returns true if face f_a is in the K-ring of face f_b
   bool AreFacesInKRing(int f_a, int f_b) const;
-  const size_t kring_{1};
+  static constexpr size_t kring_{1};
 
   // Convert the mesh to libigl data structures
-  void GetIGLMesh(Eigen::MatrixXd& V, Eigen::MatrixXi& F) const;
+  static void GetIGLMesh(vtkPolyData* poly_data, Eigen::MatrixXd& V, Eigen::MatrixXi& F);
 
-  // Precompute heat data structures for faster geodesic lookups
-  void PrecomputeGeodesics(const Eigen::MatrixXd& V, const Eigen::MatrixXi& F);
+  static void ComputeKRing(const SurfaceData& surface, int f, int k, std::unordered_set<int>& ring);
 
-  void ComputeKRing(int f, int k, std::unordered_set<int>& ring) const;
+  // Geodesic distances from vertex v to every vertex, from the persistent cache or the heat method
+  Eigen::VectorXd GeodesicsFromVertex(int v) const;
 
   const MeshGeoEntry& GeodesicsFromTriangle(int f, double max_dist=std::numeric_limits<double>::max(),
                                             int req_target_f=-1) const;
   const Eigen::Matrix3d GeodesicsFromTriangleToTriangle(int f_a, int f_b) const;
-  void ClearGeodesicCache() const;
+
+  // Account for the new size of entry f and evict other entries while over budget
+  void UpdateGeodesicCacheEntry(int f, size_t old_bytes) const;
+  bool IsGeodesicCacheOverBudget() const;
+  void EvictGeodesics(int keep_f) const;
+
+  // Record the triangle of particle idx, which must already be in particle_triangles_
+  void SetParticleTriangle(int idx, int f) const;
 
   // Store some info about the last query. This accelerates the computation
   // because the optimizer generally asks for the distances _from_ the same
@@ -2,129 +2,165 @@
 #include "CorrespondenceFunction.h"
 
 #include <math.h>
+#include <tbb/parallel_for.h>
 
-#include "Libs/Utils/Utils.h"
-#include "vnl/algo/vnl_svd.h"
-#include "vnl/vnl_diag_matrix.h"
+#include <Eigen/Eigenvalues>
+#include <algorithm>
+#include <type_traits>
 
 namespace shapeworks {
 
+namespace {
+template <class Scalar>
+using ScalarMatrix = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>;
+
+//! Number of rows of a single precision operand that are converted to double at a time
+constexpr int DoubleBlockRows = 1024;
+
+//! result = a * b.  In single precision the product is computed in double, a block of rows of a at a time, and
+//! rounded once when it is stored.
+template <class Scalar, class Lhs>
+void MultiplyInDouble(const Lhs& a, const Eigen::MatrixXd& b, ScalarMatrix<Scalar>& result) {
+  if constexpr (std::is_same_v<Scalar, double>) {
+    result.noalias() = a * b;
+  } else {
+    result.resize(a.rows(), b.cols());
+    for (Eigen::Index r = 0; r < a.rows(); r += DoubleBlockRows) {
+      const Eigen::Index n = std::min<Eigen::Index>(DoubleBlockRows, a.rows() - r);
+      result.middleRows(r, n) = (a.middleRows(r, n).template cast<double>() * b).template cast<Scalar>();
+    }
+  }
+}
+}  // namespace
+
 void CorrespondenceFunction::ComputeUpdates(const ParticleSystem* c) {
+  if (m_SinglePrecision) {
+    ComputeUpdates<float>(c, *m_PointsUpdateFloat);
+    m_PointsUpdate->resize(0, 0);
+  } else {
+    ComputeUpdates<double>(c, *m_PointsUpdate);
+    m_PointsUpdateFloat->resize(0, 0);
+  }
+}
+
+template <class Scalar>
+void CorrespondenceFunction::ComputeUpdates(const ParticleSystem* c, ScalarMatrix<Scalar>& points_update) {
   num_dims = m_ShapeData->rows();
   num_samples = m_ShapeData->cols();
 
+  UpdateDomainOffsets(c);
+
   int rows = 0;
   for (int i = 0; i < m_DomainsPerShape; i++) rows += VDimension * c->GetNumberOfParticles(i);
 
-  // Do we need to resize the update matrix?
-  if (m_PointsUpdate->rows() != rows || m_PointsUpdate->cols() != num_samples) {
-    m_PointsUpdate->set_size(rows, num_samples);
-  }
+  // Column major, so the update of each particle of a sample is contiguous.  setZero only reallocates if the size
+  // changed.
+  points_update.setZero(rows, num_samples);
 
-  m_PointsUpdate->fill(0.0);
+  const auto& shape_data = m_ShapeData->template GetStorage<Scalar>();
+  const auto& shape_gradient = m_ShapeGradient->template GetStorage<Scalar>();
 
-  vnl_matrix_type points_minus_mean(num_dims, num_samples, 0.0);
+  // the mean is always accumulated in double
+  *m_points_mean = shape_data.template cast<double>().rowwise().mean();
+  const ScalarMatrix<Scalar> points_minus_mean =
+      (shape_data.template cast<double>().colwise() - *m_points_mean).template cast<Scalar>();
 
-  m_points_mean->clear();
-  m_points_mean->set_size(num_dims, 1);
-  m_points_mean->fill(0.0);
-
-  for (unsigned int i = 0; i < num_dims; i++) {
-    m_points_mean->put(i, 0, (m_ShapeData->get_n_rows(i, 1)).mean());
-    points_minus_mean.set_row(i, m_ShapeData->get_row(i) - m_points_mean->get(i, 0));
-  }
-
-  vnl_diag_matrix<double> W;
-
-  vnl_matrix_type gramMat(num_samples, num_samples, 0.0);
-  vnl_matrix_type pinvMat(num_samples, num_samples, 0.0);  // gramMat inverse
+  Eigen::VectorXd W;  // eigenvalues of the gram matrix
+  Eigen::MatrixXd pinvMat(num_samples, num_samples);  // gramMat inverse
 
   if (this->m_UseMeanEnergy) {
-    pinvMat.set_identity();
+    pinvMat.setIdentity();
 
-    m_InverseCovMatrix->setZero();
+    m_InverseCovBlocks->assign(m_DomainsPerShape, Eigen::Matrix3d::Zero());
 
   } else {
-    gramMat = points_minus_mean.transpose() * points_minus_mean;
-
-    vnl_svd<double> svd(gramMat);
+    // the gram matrix is symmetric, so only its lower triangle is computed and read by the eigensolver
+    Eigen::MatrixXd gramMat = Eigen::MatrixXd::Zero(num_samples, num_samples);
+    if constexpr (std::is_same_v<Scalar, double>) {
+      gramMat.selfadjointView<Eigen::Lower>().rankUpdate(points_minus_mean.transpose());
+    } else {
+      for (int r = 0; r < num_dims; r += DoubleBlockRows) {
+        const int n = std::min(DoubleBlockRows, num_dims - r);
+        gramMat.selfadjointView<Eigen::Lower>().rankUpdate(
+            points_minus_mean.middleRows(r, n).template cast<double>().transpose());
+      }
+    }
 
-    vnl_matrix_type UG = svd.U();
-    W = svd.W();
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eigen_solver(gramMat);
+    const Eigen::MatrixXd& UG = eigen_solver.eigenvectors();
 
-    vnl_diag_matrix<double> invLambda = svd.W();
-    invLambda.set_diagonal(invLambda.get_diagonal() / (double)(num_samples - 1) + m_MinimumVariance);
-    invLambda.invert_in_place();
+    // the gram matrix is positive semi-definite, so these are its singular values (up to round off)
+    W = eigen_solver.eigenvalues().cwiseAbs();
 
-    pinvMat = (UG * invLambda) * UG.transpose();
+    const Eigen::VectorXd invLambda =
+        (W.array() / (double)(num_samples - 1) + m_MinimumVariance).inverse().matrix();
 
-    vnl_matrix_type projMat = points_minus_mean * UG;
-    const auto lhs = projMat * invLambda;
-    const auto rhs =
-        invLambda * projMat.transpose();  // invLambda doesn't need to be transposed since its a diagonal matrix
+    pinvMat.noalias() = UG * invLambda.asDiagonal() * UG.transpose();
 
-    // resize the inverse covariance matrix if necessary
-    if (m_InverseCovMatrix->rows() != num_dims || m_InverseCovMatrix->cols() != num_dims) {
-      m_InverseCovMatrix->resize(num_dims, num_dims);
+    // The inverse covariance is (projMat * invLambda) * (invLambda * projMat^T), where projMat = points_minus_mean *
+    // UG.  Evaluate only reads one 3x3 diagonal block of it per domain, so only the rows of projMat * invLambda that form
+    // those blocks are computed instead of the dense num_dims x num_dims product.
+    const Eigen::MatrixXd factor = UG * invLambda.asDiagonal();
+    m_InverseCovBlocks->resize(m_DomainsPerShape);
+    for (int i = 0; i < m_DomainsPerShape; i++) {
+      const Eigen::Matrix<double, 3, Eigen::Dynamic> rows =
+          points_minus_mean.template middleRows<3>(m_AttributeSizes[i]).template cast<double>() * factor;
+      (*m_InverseCovBlocks)[i].noalias() = rows * rows.transpose();
     }
-    Utils::multiply_into(*m_InverseCovMatrix, lhs, rhs);
   }
 
-  vnl_matrix_type Q = points_minus_mean * pinvMat;
+  ScalarMatrix<Scalar> Q;
+  MultiplyInDouble<Scalar>(points_minus_mean, pinvMat, Q);
 
   // Compute the update matrix in coordinate space by multiplication with the
   // Jacobian.  Each shape gradient must be transformed by a different Jacobian
-  // so we have to do this individually for each shape (sample).
-
-  {
-    vnl_matrix_type Jmatrix;
-    vnl_matrix_type v;
-    for (int j = 0; j < num_samples; j++) {
-      int num = 0;
-      int num2 = 0;
-      for (unsigned int d = 0; d < m_DomainsPerShape; d++) {
-        int dom = d + j * m_DomainsPerShape;
-        if (c->GetDomainFlag(dom) == false) {
-          if (d > 0) {
-            num += m_AttributesPerDomain[d - 1] * c->GetNumberOfParticles(d - 1);
-            if (m_UseXYZ[d - 1]) num += 3 * c->GetNumberOfParticles(d - 1);
-            if (m_UseNormals[d - 1]) num += 3 * c->GetNumberOfParticles(d - 1);
-
-            num2 += c->GetNumberOfParticles(d - 1) * VDimension;
-          }
-
-          int num_attr = m_AttributesPerDomain[d];
-          if (m_UseXYZ[d]) {
-            num_attr += 3;
-          }
-          if (m_UseNormals[d]) {
-            num_attr += 3;
-          }
-
-          Jmatrix.clear();
-          Jmatrix.set_size(num_attr, VDimension);
-          Jmatrix.fill(0.0);
-          v.clear();
-          v.set_size(num_attr, 1);
-          v.fill(0.0);
-
-          for (unsigned int p = 0; p < c->GetNumberOfParticles(dom); p++) {
-            v = Q.extract(num_attr, 1, num + p * num_attr, j);
-            Jmatrix = m_ShapeGradient->extract(num_attr, 3, num + p * num_attr, 3 * j);
-
-            vnl_matrix_type dx = Jmatrix.transpose() * v;
-            for (unsigned int vd = 0; vd < VDimension; vd++) {
-              m_PointsUpdate->put(num2 + p * VDimension + vd, j, dx(vd, 0));
-            }
-          }
-        }
-      }
-    }
-  }
+  // so we have to do this individually for each shape (sample).  Samples write
+  // disjoint columns of the update matrix, so they are processed in parallel.
+  tbb::parallel_for(tbb::blocked_range<size_t>{0, static_cast<size_t>(num_samples)},
+                    [&](const tbb::blocked_range<size_t>& r) {
+                      for (size_t j = r.begin(); j < r.end(); j++) {
+                        int num = 0;
+                        int num2 = 0;
+                        for (unsigned int d = 0; d < m_DomainsPerShape; d++) {
+                          int dom = d + j * m_DomainsPerShape;
+                          if (c->GetDomainFlag(dom) == false) {
+                            if (d > 0) {
+                              num += m_AttributesPerDomain[d - 1] * c->GetNumberOfParticles(d - 1);
+                              if (m_UseXYZ[d - 1]) num += 3 * c->GetNumberOfParticles(d - 1);
+                              if (m_UseNormals[d - 1]) num += 3 * c->GetNumberOfParticles(d - 1);
+
+                              num2 += c->GetNumberOfParticles(d - 1) * VDimension;
+                            }
+
+                            int num_attr = m_AttributesPerDomain[d];
+                            if (m_UseXYZ[d]) {
+                              num_attr += 3;
+                            }
+                            if (m_UseNormals[d]) {
+                              num_attr += 3;
+                            }
+
+                            const auto q = Q.col(j);
+                            auto update = points_update.col(j);
+                            for (unsigned int p = 0; p < c->GetNumberOfParticles(dom); p++) {
+                              // dx = J^T * v
+                              // (both casts are no-ops in double precision)
+                              update.template segment<VDimension>(num2 + p * VDimension).noalias() =
+                                  (shape_gradient.block(num + p * num_attr, 3 * j, num_attr, VDimension)
+                                       .transpose()
+                                       .template cast<double>() *
+                                   q.segment(num + p * num_attr, num_attr).template cast<double>())
+                                      .template cast<Scalar>();
+                            }
+                          }
+                        }
+                      }
+                    });
+
   m_CurrentEnergy = 0.0;
 
   if (m_UseMeanEnergy) {
-    m_CurrentEnergy = points_minus_mean.frobenius_norm();
+    m_CurrentEnergy = points_minus_mean.template cast<double>().norm();
   } else {
     m_MinimumEigenValue = W(0) * W(0) + m_MinimumVariance;
     for (unsigned int i = 0; i < num_samples; i++) {
@@ -141,66 +177,62 @@ void CorrespondenceFunction::ComputeUpdates(const ParticleSystem* c) {
   }
 }
 
+void CorrespondenceFunction::UpdateDomainOffsets(const ParticleSystem* c) {
+  m_AttributeSizes.resize(m_DomainsPerShape);
+  m_AttributeOffsets.resize(m_DomainsPerShape);
+  m_PointOffsets.resize(m_DomainsPerShape);
+
+  int attribute_offset = 0;
+  int point_offset = 0;
+  for (int i = 0; i < m_DomainsPerShape; i++) {
+    int num1 = m_AttributesPerDomain[i];
+    if (m_UseXYZ[i]) num1 += 3;
+    if (m_UseNormals[i]) num1 += 3;
+
+    m_AttributeSizes[i] = num1;
+    m_AttributeOffsets[i] = attribute_offset;
+    m_PointOffsets[i] = point_offset;
+
+    attribute_offset += num1 * c->GetNumberOfParticles(i);
+    point_offset += c->GetNumberOfParticles(i) * VDimension;
+  }
+}
+
 CorrespondenceFunction::VectorType CorrespondenceFunction::Evaluate(unsigned int idx, unsigned int d,
                                                                      const ParticleSystem* system, double& maxdt,
                                                                      double& energy) const {
   int dom = d % m_DomainsPerShape;      // domain number within shape
   int sampNum = d / m_DomainsPerShape;  // shape number
 
-  int sz_Yidx = 0;
-  if (m_UseXYZ[dom]) {
-    sz_Yidx += 3;
-  }
-  if (m_UseNormals[dom]) {
-    sz_Yidx += 3;
-  }
-  sz_Yidx += m_AttributesPerDomain[dom];
-
-  int num = sz_Yidx * idx;
-
-  for (unsigned int i = 0; i < dom; i++) {
-    int num1 = 0;
-    if (m_UseXYZ[i]) num1 += 3;
-    if (m_UseNormals[i]) num1 += 3;
-    num1 += m_AttributesPerDomain[i];
-
-    num += num1 * system->GetNumberOfParticles(i);
-  }
+  // offsets are computed once per iteration in ComputeUpdates
+  const int sz_Yidx = m_AttributeSizes[dom];
+  const int num = m_AttributeOffsets[dom] + sz_Yidx * idx;
 
-  vnl_matrix_type tmp1(sz_Yidx, sz_Yidx, 0.0);
+  auto y = [&](int i) { return m_ShapeData->get(num + i, sampNum) - (*m_points_mean)(num + i); };
 
   if (this->m_UseMeanEnergy) {
-    tmp1.set_identity();
-  } else {
-    // extract 3x3 submatrix at k,k
-    Eigen::MatrixXd region = m_InverseCovMatrix->block(sz_Yidx, sz_Yidx, 3, 3);
-    // convert to vnl
-    for (unsigned int i = 0; i < 3; i++) {
-      for (unsigned int j = 0; j < 3; j++) {
-        tmp1(i, j) = region(i, j);
-      }
+    energy = 0.0;
+    for (int i = 0; i < sz_Yidx; i++) {
+      energy += y(i) * y(i);
     }
+  } else {
+    // only the 3x3 block of the inverse covariance at (sz_Yidx, sz_Yidx) enters the energy
+    const Eigen::Matrix3d& region = (*m_InverseCovBlocks)[dom];
+    const Eigen::Vector3d Y_dom_idx(y(0), y(1), y(2));
+    energy = Y_dom_idx.dot(region * Y_dom_idx);
   }
 
-  vnl_matrix_type Y_dom_idx(sz_Yidx, 1, 0.0);
-
-  Y_dom_idx = m_ShapeData->extract(sz_Yidx, 1, num, sampNum) - m_points_mean->extract(sz_Yidx, 1, num);
-
-  vnl_matrix_type tmp = Y_dom_idx.transpose() * tmp1;
-  tmp *= Y_dom_idx;
-
-  energy = tmp(0, 0);
-
   maxdt = m_MinimumEigenValue;
 
-  num = 0;
-  for (int i = 0; i < dom; i++) num += system->GetNumberOfParticles(i) * VDimension;
-
-  VectorType gradE;
-  unsigned int k = idx * VDimension + num;
-  for (unsigned int i = 0; i < VDimension; i++) {
-    gradE[i] = m_PointsUpdate->get(k + i, sampNum);
+  // the update of this particle is contiguous in the (column major) update matrix
+  const int k = m_PointOffsets[dom] + idx * VDimension;
+  Eigen::Vector3d update;
+  if (m_SinglePrecision) {
+    update = m_PointsUpdateFloat->col(sampNum).segment<VDimension>(k).cast<double>();
+  } else {
+    update = m_PointsUpdate->col(sampNum).segment<VDimension>(k);
   }
+  VectorType gradE(update(0), update(1), update(2));
 
   return system->TransformVector(gradE, system->GetInversePrefixTransform(d) * system->GetInverseTransform(d));
 }
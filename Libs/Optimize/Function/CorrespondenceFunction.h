@@ -104,6 +104,15 @@ class CorrespondenceFunction : public VectorFunction {
 
   void SetAttributesPerDomain(const std::vector<int>& i) { m_AttributesPerDomain = i; }
 
+  //! Store the shape matrices and the update in single precision.  The gram matrix, its eigendecomposition and the
+  //! products with large inner dimensions are still computed in double.
+  void SetSinglePrecision(bool single_precision) {
+    m_SinglePrecision = single_precision;
+    m_ShapeData->SetSinglePrecision(single_precision);
+    m_ShapeGradient->SetSinglePrecision(single_precision);
+  }
+  bool IsSinglePrecision() const { return m_SinglePrecision; }
+
   void UseMeanEnergy() { m_UseMeanEnergy = true; }
   void UseEntropy() { m_UseMeanEnergy = false; }
 
@@ -131,33 +140,40 @@ class CorrespondenceFunction : public VectorFunction {
 
   virtual VectorFunction::Pointer Clone() {
     auto copy = CorrespondenceFunction::New();
+    copy->ResetFrom(this);
+    return (VectorFunction::Pointer)copy;
+  }
 
+  virtual void ResetFrom(const VectorFunction* prototype) {
     // from itkParticleVectorFunction
-    copy->m_DomainNumber = this->m_DomainNumber;
-    copy->m_ParticleSystem = this->m_ParticleSystem;
+    Superclass::ResetFrom(prototype);
 
     // local
-    copy->m_AttributeScales = this->m_AttributeScales;
-    copy->m_Counter = this->m_Counter;
-    copy->m_CurrentEnergy = this->m_CurrentEnergy;
-    copy->m_HoldMinimumVariance = this->m_HoldMinimumVariance;
-    copy->m_MinimumEigenValue = this->m_MinimumEigenValue;
-    copy->m_MinimumVariance = this->m_MinimumVariance;
-    copy->m_MinimumVarianceDecayConstant = this->m_MinimumVarianceDecayConstant;
-    copy->m_PointsUpdate = this->m_PointsUpdate;
-    copy->m_RecomputeCovarianceInterval = this->m_RecomputeCovarianceInterval;
-    copy->m_AttributesPerDomain = this->m_AttributesPerDomain;
-    copy->m_DomainsPerShape = this->m_DomainsPerShape;
-    copy->m_UseMeanEnergy = this->m_UseMeanEnergy;
-    copy->m_points_mean = this->m_points_mean;
-    copy->m_UseNormals = this->m_UseNormals;
-    copy->m_UseXYZ = this->m_UseXYZ;
-    copy->m_InverseCovMatrix = this->m_InverseCovMatrix;
-
-    copy->m_ShapeData = this->m_ShapeData;
-    copy->m_ShapeGradient = this->m_ShapeGradient;
-
-    return (VectorFunction::Pointer)copy;
+    auto other = static_cast<const CorrespondenceFunction*>(prototype);
+    m_AttributeScales = other->m_AttributeScales;
+    m_Counter = other->m_Counter;
+    m_CurrentEnergy = other->m_CurrentEnergy;
+    m_HoldMinimumVariance = other->m_HoldMinimumVariance;
+    m_MinimumEigenValue = other->m_MinimumEigenValue;
+    m_MinimumVariance = other->m_MinimumVariance;
+    m_MinimumVarianceDecayConstant = other->m_MinimumVarianceDecayConstant;
+    m_PointsUpdate = other->m_PointsUpdate;
+    m_PointsUpdateFloat = other->m_PointsUpdateFloat;
+    m_RecomputeCovarianceInterval = other->m_RecomputeCovarianceInterval;
+    m_AttributesPerDomain = other->m_AttributesPerDomain;
+    m_DomainsPerShape = other->m_DomainsPerShape;
+    m_UseMeanEnergy = other->m_UseMeanEnergy;
+    m_points_mean = other->m_points_mean;
+    m_UseNormals = other->m_UseNormals;
+    m_UseXYZ = other->m_UseXYZ;
+    m_InverseCovBlocks = other->m_InverseCovBlocks;
+    m_SinglePrecision = other->m_SinglePrecision;
+    m_AttributeSizes = other->m_AttributeSizes;
+    m_AttributeOffsets = other->m_AttributeOffsets;
+    m_PointOffsets = other->m_PointOffsets;
+
+    m_ShapeData = other->m_ShapeData;
+    m_ShapeGradient = other->m_ShapeGradient;
   }
 
  protected:
@@ -170,13 +186,15 @@ class CorrespondenceFunction : public VectorFunction {
     m_RecomputeCovarianceInterval = 1;
     m_Counter = 0;
     m_UseMeanEnergy = true;
+    m_SinglePrecision = false;
     m_UseNormals.clear();
     m_UseXYZ.clear();
     num_dims = 0;
     num_samples = 0;
-    m_PointsUpdate = std::make_shared<vnl_matrix_type>(10, 10);
-    m_InverseCovMatrix = std::make_shared<Eigen::MatrixXd>(10, 10);
-    m_points_mean = std::make_shared<vnl_matrix_type>(10, 10);
+    m_PointsUpdate = std::make_shared<Eigen::MatrixXd>(10, 10);
+    m_PointsUpdateFloat = std::make_shared<Eigen::MatrixXf>();
+    m_InverseCovBlocks = std::make_shared<std::vector<Eigen::Matrix3d>>();
+    m_points_mean = std::make_shared<Eigen::VectorXd>(10);
   }
   virtual ~CorrespondenceFunction() {}
   void operator=(const CorrespondenceFunction&);
@@ -186,7 +204,18 @@ class CorrespondenceFunction : public VectorFunction {
   typename ShapeGradientType::Pointer m_ShapeGradient;
 
   virtual void ComputeUpdates(const ParticleSystem* c);
-  std::shared_ptr<vnl_matrix_type> m_PointsUpdate;
+
+  //! ComputeUpdates with the matrices stored as Scalar
+  template <class Scalar>
+  void ComputeUpdates(const ParticleSystem* c, Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>& points_update);
+
+  /** Recompute the per-domain offset tables used by Evaluate. */
+  void UpdateDomainOffsets(const ParticleSystem* c);
+  //! gradient of the energy for every particle coordinate (rows) of every sample (columns)
+  std::shared_ptr<Eigen::MatrixXd> m_PointsUpdate;
+  //! m_PointsUpdate in single precision, only one of the two is in use
+  std::shared_ptr<Eigen::MatrixXf> m_PointsUpdateFloat;
+  bool m_SinglePrecision;
 
   double m_MinimumVariance;
   double m_MinimumEigenValue;
@@ -202,8 +231,15 @@ class CorrespondenceFunction : public VectorFunction {
   bool m_UseMeanEnergy;
   std::vector<bool> m_UseXYZ;
   std::vector<bool> m_UseNormals;
-  std::shared_ptr<vnl_matrix_type> m_points_mean;
-  std::shared_ptr<Eigen::MatrixXd> m_InverseCovMatrix;
+  std::shared_ptr<Eigen::VectorXd> m_points_mean;
+  //! per domain (within a shape), the 3x3 block of the inverse covariance read by Evaluate
+  std::shared_ptr<std::vector<Eigen::Matrix3d>> m_InverseCovBlocks;
   int num_dims, num_samples;
+
+  // Per domain (within a shape): number of attributes per particle, first row of the domain in the shape data and
+  // first row of the domain in the update matrix
+  std::vector<int> m_AttributeSizes;
+  std::vector<int> m_AttributeOffsets;
+  std::vector<int> m_PointOffsets;
 };
 }  // namespace shapeworks
@@ -268,12 +268,11 @@ void CurvatureSamplingFunction::UpdateNeighborhood(const CurvatureSamplingFuncti
     // * Both domains are the same
     // * This is not a contour, but the other domain is a contour
 
-    std::vector<double> weights;
-    std::vector<double> distances;
-    std::vector<ParticlePointIndexPair> res;
+    // the span points into a thread-local arena owned by the neighborhood, valid until the next span query
+    ParticleNeighborhood::NeighborhoodSpan res;
     if (domain_t == d) {
       // same domain
-      res = neighborhood->FindNeighborhoodPoints(pos, idx, weights, distances, radius);
+      res = neighborhood->FindNeighborhoodSpan(pos, idx, radius);
     } else {
       // cross domain
 
@@ -282,18 +281,15 @@ void CurvatureSamplingFunction::UpdateNeighborhood(const CurvatureSamplingFuncti
       neighborhood->SetWeightingEnabled(false);
       neighborhood->SetForceEuclidean(true);
 
-      res = neighborhood->FindNeighborhoodPoints(pos, -1, weights, distances, radius);
+      res = neighborhood->FindNeighborhoodSpan(pos, -1, radius);
 
       neighborhood->SetForceEuclidean(false);
       neighborhood->SetWeightingEnabled(weighting_state);
     }
 
-    assert(weights.size() == distances.size() && res.size() == weights.size());
-
-    // todo should avoid this copy. requires changing way too many APIs
-    for (int i = 0; i < res.size(); i++) {
-      const double weight = domain_t == d ? weights[i] : m_SharedBoundaryWeight;
-      m_CurrentNeighborhood.emplace_back(res[i], weight, distances[i], domain_t);
+    for (size_t i = 0; i < res.size; i++) {
+      const double weight = domain_t == d ? res.weights[i] : m_SharedBoundaryWeight;
+      m_CurrentNeighborhood.emplace_back(res[i], weight, res.distances[i], domain_t);
     }
   }
 }
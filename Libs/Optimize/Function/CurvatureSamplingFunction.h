@@ -94,32 +94,28 @@ class CurvatureSamplingFunction : public SamplingFunction {
   bool GetSharedBoundaryEnabled() const { return m_IsSharedBoundaryEnabled; }
 
   virtual VectorFunction::Pointer Clone() {
-    // todo Do we really need to clone all of this?
-
     CurvatureSamplingFunction::Pointer copy = CurvatureSamplingFunction::New();
-    copy->SetParticleSystem(this->GetParticleSystem());
-    copy->m_Counter = this->m_Counter;
-    copy->m_Rho = this->m_Rho;
-    copy->m_avgKappa = this->m_avgKappa;
-    copy->m_IsSharedBoundaryEnabled = this->m_IsSharedBoundaryEnabled;
-    copy->m_SharedBoundaryWeight = this->m_SharedBoundaryWeight;
-    copy->m_CurrentSigma = this->m_CurrentSigma;
-    copy->m_CurrentNeighborhood = this->m_CurrentNeighborhood;
-
-    copy->m_MinimumNeighborhoodRadius = this->m_MinimumNeighborhoodRadius;
-    copy->m_MaximumNeighborhoodRadius = this->m_MaximumNeighborhoodRadius;
-    copy->m_FlatCutoff = this->m_FlatCutoff;
-    copy->m_NeighborhoodToSigmaRatio = this->m_NeighborhoodToSigmaRatio;
-
-    copy->m_SpatialSigmaCache = this->m_SpatialSigmaCache;
-    copy->m_MeanCurvatureCache = this->m_MeanCurvatureCache;
-
-    copy->m_DomainNumber = this->m_DomainNumber;
-    copy->m_ParticleSystem = this->m_ParticleSystem;
-
+    copy->ResetFrom(this);
     return (VectorFunction::Pointer)copy;
   }
 
+  virtual void ResetFrom(const VectorFunction* prototype) {
+    // todo Do we really need to copy all of this?
+    Superclass::ResetFrom(prototype);
+
+    auto other = static_cast<const CurvatureSamplingFunction*>(prototype);
+    m_Counter = other->m_Counter;
+    m_Rho = other->m_Rho;
+    m_avgKappa = other->m_avgKappa;
+    m_IsSharedBoundaryEnabled = other->m_IsSharedBoundaryEnabled;
+    m_SharedBoundaryWeight = other->m_SharedBoundaryWeight;
+    m_CurrentSigma = other->m_CurrentSigma;
+    // assignment reuses the existing capacity of a recycled clone
+    m_CurrentNeighborhood = other->m_CurrentNeighborhood;
+
+    m_MeanCurvatureCache = other->m_MeanCurvatureCache;
+  }
+
  protected:
   CurvatureSamplingFunction() : m_Counter(0), m_Rho(1.0) {}
   virtual ~CurvatureSamplingFunction() {}
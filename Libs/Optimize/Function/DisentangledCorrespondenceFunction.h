@@ -111,31 +111,33 @@ class DisentangledCorrespondenceFunction : public VectorFunction {
 
   virtual VectorFunction::Pointer Clone() {
     DisentangledCorrespondenceFunction::Pointer copy = DisentangledCorrespondenceFunction::New();
+    copy->ResetFrom(this);
+    return (VectorFunction::Pointer)copy;
+  }
 
-    copy->m_Shape_PointsUpdate = this->m_Shape_PointsUpdate;
-    copy->m_Time_PointsUpdate = this->m_Time_PointsUpdate;
-    copy->m_MinimumVariance = this->m_MinimumVariance;
-    copy->m_MinimumEigenValue_shape_cohort = this->m_MinimumEigenValue_shape_cohort;
-    copy->m_MinimumEigenValue_time_cohort = this->m_MinimumEigenValue_time_cohort;
-
-    copy->m_CurrentEnergy = this->m_CurrentEnergy;
-    copy->m_HoldMinimumVariance = this->m_HoldMinimumVariance;
-    copy->m_MinimumVarianceDecayConstant = this->m_MinimumVarianceDecayConstant;
-    copy->m_RecomputeCovarianceInterval = this->m_RecomputeCovarianceInterval;
-    copy->m_Counter = m_Counter;
+  virtual void ResetFrom(const VectorFunction* prototype) {
+    Superclass::ResetFrom(prototype);
 
-    copy->m_DomainNumber = this->m_DomainNumber;
-    copy->m_ParticleSystem = this->m_ParticleSystem;
-    copy->m_ShapeMatrix = this->m_ShapeMatrix;
+    auto other = static_cast<const DisentangledCorrespondenceFunction*>(prototype);
+    m_Shape_PointsUpdate = other->m_Shape_PointsUpdate;
+    m_Time_PointsUpdate = other->m_Time_PointsUpdate;
+    m_MinimumVariance = other->m_MinimumVariance;
+    m_MinimumEigenValue_shape_cohort = other->m_MinimumEigenValue_shape_cohort;
+    m_MinimumEigenValue_time_cohort = other->m_MinimumEigenValue_time_cohort;
 
+    m_CurrentEnergy = other->m_CurrentEnergy;
+    m_HoldMinimumVariance = other->m_HoldMinimumVariance;
+    m_MinimumVarianceDecayConstant = other->m_MinimumVarianceDecayConstant;
+    m_RecomputeCovarianceInterval = other->m_RecomputeCovarianceInterval;
+    m_Counter = other->m_Counter;
 
-    copy->m_InverseCovMatrices_time_cohort = this->m_InverseCovMatrices_time_cohort;
-    copy->m_InverseCovMatrices_shape_cohort = this->m_InverseCovMatrices_shape_cohort;
+    m_ShapeMatrix = other->m_ShapeMatrix;
 
-    copy->m_points_mean_time_cohort = this->m_points_mean_time_cohort;
-    copy->m_points_mean_shape_cohort = this->m_points_mean_shape_cohort;
+    m_InverseCovMatrices_time_cohort = other->m_InverseCovMatrices_time_cohort;
+    m_InverseCovMatrices_shape_cohort = other->m_InverseCovMatrices_shape_cohort;
 
-    return (VectorFunction::Pointer)copy;
+    m_points_mean_time_cohort = other->m_points_mean_time_cohort;
+    m_points_mean_shape_cohort = other->m_points_mean_shape_cohort;
   }
 
  protected:
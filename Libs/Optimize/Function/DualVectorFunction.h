@@ -142,6 +142,9 @@ class DualVectorFunction : public VectorFunction {
       ansB = 0.0;
     }
 
+    m_LastEnergyA = ansA;
+    m_LastEnergyB = m_RelativeEnergyScaling * ansB;
+
     // compute final energy for current configuration
     if (m_BOn == true) {
       if (m_AOn == true)  // both A and B are active
@@ -329,6 +332,12 @@ class DualVectorFunction : public VectorFunction {
       return 0.0;
   }
 
+  bool GetLastEnergyTerms(double& energy_a, double& energy_b) const override {
+    energy_a = m_LastEnergyA;
+    energy_b = m_LastEnergyB;
+    return true;
+  }
+
   double GetAverageEnergyA() const {
     if (m_Counter != 0.0)
       return m_AverageEnergyA / m_Counter;
@@ -344,29 +353,38 @@ class DualVectorFunction : public VectorFunction {
 
   virtual typename VectorFunction::Pointer Clone() {
     typename DualVectorFunction::Pointer copy = DualVectorFunction::New();
-    copy->m_AOn = this->m_AOn;
-    copy->m_BOn = this->m_BOn;
-
-    copy->m_RelativeGradientScaling = this->m_RelativeGradientScaling;
-    copy->m_RelativeEnergyScaling = this->m_RelativeEnergyScaling;
-    copy->m_AverageGradMagA = this->m_AverageGradMagA;
-    copy->m_AverageGradMagB = this->m_AverageGradMagB;
-    copy->m_AverageEnergyA = this->m_AverageEnergyA;
-    copy->m_AverageEnergyB = this->m_AverageEnergyB;
-    copy->m_Counter = this->m_Counter;
 
     if (this->m_FunctionA) copy->m_FunctionA = this->m_FunctionA->Clone();
     if (this->m_FunctionB) copy->m_FunctionB = this->m_FunctionB->Clone();
 
-    if (!copy->m_FunctionA) copy->m_AOn = false;
-    if (!copy->m_FunctionB) copy->m_BOn = false;
-
-    copy->m_DomainNumber = this->m_DomainNumber;
-    copy->m_ParticleSystem = this->m_ParticleSystem;
+    copy->ResetFrom(this);
 
     return (VectorFunction::Pointer)copy;
   }
 
+  virtual void ResetFrom(const VectorFunction* prototype) {
+    auto other = static_cast<const DualVectorFunction*>(prototype);
+    m_AOn = other->m_AOn;
+    m_BOn = other->m_BOn;
+
+    m_RelativeGradientScaling = other->m_RelativeGradientScaling;
+    m_RelativeEnergyScaling = other->m_RelativeEnergyScaling;
+    m_AverageGradMagA = other->m_AverageGradMagA;
+    m_AverageGradMagB = other->m_AverageGradMagB;
+    m_AverageEnergyA = other->m_AverageEnergyA;
+    m_AverageEnergyB = other->m_AverageEnergyB;
+    m_Counter = other->m_Counter;
+
+    if (m_FunctionA && other->m_FunctionA) m_FunctionA->ResetFrom(other->m_FunctionA);
+    if (m_FunctionB && other->m_FunctionB) m_FunctionB->ResetFrom(other->m_FunctionB);
+
+    if (!m_FunctionA) m_AOn = false;
+    if (!m_FunctionB) m_BOn = false;
+
+    m_DomainNumber = other->m_DomainNumber;
+    m_ParticleSystem = other->m_ParticleSystem;
+  }
+
  protected:
   DualVectorFunction()
       : m_AOn(true), m_BOn(false), m_RelativeGradientScaling(1.0), m_RelativeEnergyScaling(1.0) {}
@@ -385,6 +403,10 @@ class DualVectorFunction : public VectorFunction {
   double m_AverageEnergyB;
   double m_Counter;
 
+  //! terms of the last Energy() call, as EnergyA() and EnergyB() would report them
+  mutable double m_LastEnergyA = 0.0;
+  mutable double m_LastEnergyB = 0.0;
+
   VectorFunction::Pointer m_FunctionA;
   VectorFunction::Pointer m_FunctionB;
 };
@@ -2,12 +2,11 @@
 
 #include "LegacyCorrespondenceFunction.h"
 
+#include <Eigen/Eigenvalues>
 #include <string>
 
 #include "Libs/Optimize/Domain/ImageDomainWithGradients.h"
 #include "Libs/Optimize/Utils/ParticleGaussianModeWriter.h"
-#include "Libs/Utils/Utils.h"
-#include "vnl/algo/vnl_symmetric_eigensystem.h"
 
 namespace shapeworks {
 void LegacyCorrespondenceFunction ::WriteModes(const std::string& prefix, int n) const {
@@ -24,78 +23,56 @@ void LegacyCorrespondenceFunction ::ComputeCovarianceMatrix() {
   const unsigned int num_samples = m_ShapeMatrix->cols();
   const unsigned int num_dims = m_ShapeMatrix->rows();
 
-  // Do we need to resize the covariance matrix?
-  if (m_PointsUpdate->rows() != num_dims || m_PointsUpdate->cols() != num_samples) {
-    m_PointsUpdate->set_size(num_dims, num_samples);
-    m_PointsUpdate->fill(0.0);
-  }
-  vnl_matrix_type points_minus_mean;
-  points_minus_mean.clear();
-  points_minus_mean.set_size(num_dims, num_samples);
-  points_minus_mean.fill(0.0);
-
-  m_points_mean->clear();
-  m_points_mean->set_size(num_dims, 1);
+  // The shape matrix is vnl (row major).  Map it instead of copying.
+  using RowMajorMatrix = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+  const Eigen::Map<const RowMajorMatrix> shape_matrix(m_ShapeMatrix->data_block(), num_dims, num_samples);
 
   // Compute the covariance matrix.
   // (A is D' in Davies paper)
   // Compute the mean shape vector.
-  double _total = 0.0;
-  for (unsigned int j = 0; j < num_dims; j++) {
-    double total = 0.0;
-    for (unsigned int i = 0; i < num_samples; i++) {
-      total += m_ShapeMatrix->operator()(j, i);
-    }
-    m_points_mean->put(j, 0, total / (double)num_samples);
-    _total += total;
-  }
+  *m_points_mean = shape_matrix.rowwise().mean();
+  const Eigen::MatrixXd points_minus_mean = shape_matrix.colwise() - *m_points_mean;
 
-  for (unsigned int j = 0; j < num_dims; j++) {
-    for (unsigned int i = 0; i < num_samples; i++) {
-      points_minus_mean(j, i) = m_ShapeMatrix->operator()(j, i) - m_points_mean->get(j, 0);
-    }
-  }
-
-  vnl_diag_matrix<double> W;
-
-  vnl_matrix_type gramMat(num_samples, num_samples, 0.0);
-  vnl_matrix_type pinvMat(num_samples, num_samples, 0.0);  // gramMat inverse
+  Eigen::VectorXd W;  // eigenvalues of the gram matrix
+  Eigen::MatrixXd pinvMat(num_samples, num_samples);  // gramMat inverse
 
   if (this->m_UseMeanEnergy) {
-    pinvMat.set_identity();
-    m_InverseCovMatrix->setZero();
+    pinvMat.setIdentity();
+    m_InverseCovBlocks->setZero(VDimension, num_dims);
   } else {
-    gramMat = points_minus_mean.transpose() * points_minus_mean;
-
-    vnl_svd<double> svd(gramMat);
+    // the gram matrix is symmetric, so only its lower triangle is computed and read by the eigensolver
+    Eigen::MatrixXd gramMat = Eigen::MatrixXd::Zero(num_samples, num_samples);
+    gramMat.selfadjointView<Eigen::Lower>().rankUpdate(points_minus_mean.transpose());
 
-    vnl_matrix_type UG = svd.U();
-    W = svd.W();
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eigen_solver(gramMat);
+    const Eigen::MatrixXd& UG = eigen_solver.eigenvectors();
 
-    vnl_diag_matrix<double> invLambda = svd.W();
+    // the gram matrix is positive semi-definite, so these are its singular values (up to round off)
+    W = eigen_solver.eigenvalues().cwiseAbs();
 
-    invLambda.set_diagonal(invLambda.get_diagonal() / (double)(num_samples - 1) + m_MinimumVariance);
-    invLambda.invert_in_place();
+    const Eigen::VectorXd invLambda =
+        (W.array() / (double)(num_samples - 1) + m_MinimumVariance).inverse().matrix();
 
-    pinvMat = (UG * invLambda) * UG.transpose();
+    pinvMat.noalias() = UG * invLambda.asDiagonal() * UG.transpose();
 
-    vnl_matrix_type projMat = points_minus_mean * UG;
-    const auto lhs = projMat * invLambda;
-    const auto rhs =
-        invLambda * projMat.transpose();  // invLambda doesn't need to be transposed since its a diagonal matrix
-    if (m_InverseCovMatrix->rows() != num_dims || m_InverseCovMatrix->cols() != num_dims) {
-      m_InverseCovMatrix->resize(num_dims, num_dims);
+    // The inverse covariance is (projMat * invLambda) * (invLambda * projMat^T), where projMat = points_minus_mean * UG.
+    // Evaluate only reads its 3x3 diagonal blocks, so those are formed from the num_dims x num_samples factor instead
+    // of the dense num_dims x num_dims product.
+    const Eigen::MatrixXd lhs = (points_minus_mean * UG) * invLambda.asDiagonal();
+    m_InverseCovBlocks->resize(VDimension, num_dims);
+    for (unsigned int k = 0; k + VDimension <= num_dims; k += VDimension) {
+      const auto rows = lhs.middleRows<VDimension>(k);
+      m_InverseCovBlocks->middleCols<VDimension>(k).noalias() = rows * rows.transpose();
     }
-    Utils::multiply_into(*m_InverseCovMatrix, lhs, rhs);
   }
-  m_PointsUpdate->update(points_minus_mean * pinvMat);
 
-  //     std::cout << m_PointsUpdate.extract(num_dims, num_samples,0,0) << std::endl;
+  // column major, so the update of each particle of a sample is contiguous
+  m_PointsUpdate->noalias() = points_minus_mean * pinvMat;
 
   m_CurrentEnergy = 0.0;
 
   if (m_UseMeanEnergy)
-    m_CurrentEnergy = points_minus_mean.frobenius_norm();
+    m_CurrentEnergy = points_minus_mean.norm();
   else {
     m_MinimumEigenValue = W(0) * W(0) + m_MinimumVariance;
     for (unsigned int i = 0; i < num_samples; i++) {
@@ -109,50 +86,44 @@ void LegacyCorrespondenceFunction ::ComputeCovarianceMatrix() {
   if (m_UseMeanEnergy) m_MinimumEigenValue = m_CurrentEnergy / 2.0;
 }
 
+void LegacyCorrespondenceFunction ::UpdateDomainOffsets() {
+  const unsigned int DomainsPerShape = m_ShapeMatrix->GetDomainsPerShape();
+  m_PointOffsets.resize(DomainsPerShape);
+  int k = 0;
+  for (unsigned int i = 0; i < DomainsPerShape; i++) {
+    m_PointOffsets[i] = k;
+    k += this->m_ParticleSystem->GetNumberOfParticles(i) * VDimension;
+  }
+}
+
 LegacyCorrespondenceFunction::VectorType LegacyCorrespondenceFunction ::Evaluate(unsigned int idx, unsigned int d,
                                                                                  const ParticleSystem* system,
                                                                                  double& maxdt, double& energy) const {
   // NOTE: This code requires that indices be contiguous, i.e. it won't work if
   // you start deleting particles.
   const unsigned int DomainsPerShape = m_ShapeMatrix->GetDomainsPerShape();
+  const unsigned int sample = d / DomainsPerShape;
 
   maxdt = m_MinimumEigenValue;
 
-  VectorType gradE;
-  unsigned int k = 0;
-  int dom = d % DomainsPerShape;
-  for (int i = 0; i < dom; i++) k += system->GetNumberOfParticles(i) * VDimension;
-  k += idx * VDimension;
-
-  vnl_matrix_type Xi(3, 1, 0.0);
-  Xi(0, 0) = m_ShapeMatrix->operator()(k, d / DomainsPerShape) - m_points_mean->get(k, 0);
-  Xi(1, 0) = m_ShapeMatrix->operator()(k + 1, d / DomainsPerShape) - m_points_mean->get(k + 1, 0);
-  Xi(2, 0) = m_ShapeMatrix->operator()(k + 2, d / DomainsPerShape) - m_points_mean->get(k + 2, 0);
+  // offsets are computed once per iteration in BeforeIteration
+  const unsigned int k = m_PointOffsets[d % DomainsPerShape] + idx * VDimension;
 
-  vnl_matrix_type tmp1(3, 3, 0.0);
+  const Eigen::Vector3d Xi(m_ShapeMatrix->operator()(k, sample) - (*m_points_mean)(k),
+                           m_ShapeMatrix->operator()(k + 1, sample) - (*m_points_mean)(k + 1),
+                           m_ShapeMatrix->operator()(k + 2, sample) - (*m_points_mean)(k + 2));
 
   if (this->m_UseMeanEnergy) {
-    tmp1.set_identity();
+    energy = Xi.squaredNorm();
   } else {
-    // extract 3x3 submatrix at k,k
-    Eigen::MatrixXd region = m_InverseCovMatrix->block(k, k, 3, 3);
-    // convert to vnl
-    for (unsigned int i = 0; i < 3; i++) {
-      for (unsigned int j = 0; j < 3; j++) {
-        tmp1(i, j) = region(i, j);
-      }
-    }
+    // 3x3 submatrix of the inverse covariance at k,k
+    const Eigen::Matrix3d region = m_InverseCovBlocks->middleCols<3>(k);
+    energy = Xi.dot(region * Xi);
   }
 
-  vnl_matrix_type tmp = Xi.transpose() * tmp1;
-
-  tmp *= Xi;
-
-  energy = tmp(0, 0);
-
-  for (unsigned int i = 0; i < VDimension; i++) {
-    gradE[i] = m_PointsUpdate->get(k + i, d / DomainsPerShape);
-  }
+  // the update of this particle is contiguous in the (column major) update matrix
+  const Eigen::Vector3d update = m_PointsUpdate->col(sample).segment<VDimension>(k);
+  VectorType gradE(update(0), update(1), update(2));
 
   return system->TransformVector(gradE, system->GetInversePrefixTransform(d) * system->GetInverseTransform(d));
 }
@@ -68,6 +68,7 @@ class LegacyCorrespondenceFunction : public VectorFunction {
   /** Called before each iteration of a solver. */
   virtual void BeforeIteration() {
     m_ShapeMatrix->BeforeIteration();
+    this->UpdateDomainOffsets();
 
     if (m_Counter == 0) {
       this->ComputeCovarianceMatrix();
@@ -112,27 +113,31 @@ class LegacyCorrespondenceFunction : public VectorFunction {
 
   virtual VectorFunction::Pointer Clone() {
     LegacyCorrespondenceFunction::Pointer copy = LegacyCorrespondenceFunction::New();
-
-    copy->m_PointsUpdate = this->m_PointsUpdate;
-    copy->m_MinimumVariance = this->m_MinimumVariance;
-    copy->m_MinimumEigenValue = this->m_MinimumEigenValue;
-    copy->m_CurrentEnergy = this->m_CurrentEnergy;
-    copy->m_HoldMinimumVariance = this->m_HoldMinimumVariance;
-    copy->m_MinimumVarianceDecayConstant = this->m_MinimumVarianceDecayConstant;
-    copy->m_RecomputeCovarianceInterval = this->m_RecomputeCovarianceInterval;
-    copy->m_Counter = m_Counter;
-
-    copy->m_DomainNumber = this->m_DomainNumber;
-    copy->m_ParticleSystem = this->m_ParticleSystem;
-    copy->m_ShapeMatrix = this->m_ShapeMatrix;
-
-    copy->m_InverseCovMatrix = this->m_InverseCovMatrix;
-    copy->m_points_mean = this->m_points_mean;
-    copy->m_UseMeanEnergy = this->m_UseMeanEnergy;
-
+    copy->ResetFrom(this);
     return (VectorFunction::Pointer)copy;
   }
 
+  virtual void ResetFrom(const VectorFunction* prototype) {
+    Superclass::ResetFrom(prototype);
+
+    auto other = static_cast<const LegacyCorrespondenceFunction*>(prototype);
+    m_PointsUpdate = other->m_PointsUpdate;
+    m_MinimumVariance = other->m_MinimumVariance;
+    m_MinimumEigenValue = other->m_MinimumEigenValue;
+    m_CurrentEnergy = other->m_CurrentEnergy;
+    m_HoldMinimumVariance = other->m_HoldMinimumVariance;
+    m_MinimumVarianceDecayConstant = other->m_MinimumVarianceDecayConstant;
+    m_RecomputeCovarianceInterval = other->m_RecomputeCovarianceInterval;
+    m_Counter = other->m_Counter;
+
+    m_ShapeMatrix = other->m_ShapeMatrix;
+
+    m_InverseCovBlocks = other->m_InverseCovBlocks;
+    m_points_mean = other->m_points_mean;
+    m_UseMeanEnergy = other->m_UseMeanEnergy;
+    m_PointOffsets = other->m_PointOffsets;
+  }
+
  protected:
   LegacyCorrespondenceFunction() {
     // m_MinimumVarianceBase = 1.0;//exp(log(1.0e-5)/10000.0);
@@ -143,9 +148,9 @@ class LegacyCorrespondenceFunction : public VectorFunction {
     m_RecomputeCovarianceInterval = 1;
     m_Counter = 0;
     m_UseMeanEnergy = true;
-    m_PointsUpdate = std::make_shared<vnl_matrix_type>(10, 10);
-    m_InverseCovMatrix = std::make_shared<Eigen::MatrixXd>(10, 10);
-    m_points_mean = std::make_shared<vnl_matrix_type>(10, 10);
+    m_PointsUpdate = std::make_shared<Eigen::MatrixXd>(10, 10);
+    m_InverseCovBlocks = std::make_shared<Eigen::MatrixXd>();
+    m_points_mean = std::make_shared<Eigen::VectorXd>(10);
   }
   virtual ~LegacyCorrespondenceFunction() {}
   void operator=(const LegacyCorrespondenceFunction&);
@@ -153,7 +158,11 @@ class LegacyCorrespondenceFunction : public VectorFunction {
   typename ShapeMatrixType::Pointer m_ShapeMatrix;
 
   virtual void ComputeCovarianceMatrix();
-  std::shared_ptr<vnl_matrix_type> m_PointsUpdate;
+
+  /** Recompute the first row of each domain (within a shape) in the shape matrix, used by Evaluate. */
+  void UpdateDomainOffsets();
+  //! gradient of the energy for every particle coordinate (rows) of every sample (columns)
+  std::shared_ptr<Eigen::MatrixXd> m_PointsUpdate;
   double m_MinimumVariance;
   double m_MinimumEigenValue;
   double m_CurrentEnergy;
@@ -163,8 +172,10 @@ class LegacyCorrespondenceFunction : public VectorFunction {
   int m_Counter;
   bool m_UseMeanEnergy;
 
-  std::shared_ptr<vnl_matrix_type> m_points_mean;       // 3Nx3N - used for energy computation
-  std::shared_ptr<Eigen::MatrixXd> m_InverseCovMatrix;  // 3NxM - used for energy computation
+  std::shared_ptr<Eigen::VectorXd> m_points_mean;  // 3N - used for energy computation
+  //! the 3x3 diagonal blocks of the inverse covariance, the block of the particle at row k is in columns k to k + 2
+  std::shared_ptr<Eigen::MatrixXd> m_InverseCovBlocks;  // 3x3N - used for energy computation
+  std::vector<int> m_PointOffsets;
 };
 
 }  // namespace shapeworks
@@ -21,12 +21,12 @@ SamplingFunction::TGradientNumericType SamplingFunction::AngleCoefficient(
 }
 
 void SamplingFunction::ComputeAngularWeights(
-    const PointType& pos, int idx, const typename ParticleSystem::PointVectorType& neighborhood,
+    const PointType& pos, int idx, const ParticleNeighborhood::NeighborhoodSpan& neighborhood,
     const shapeworks::ParticleDomain* domain, std::vector<double>& weights) const {
   GradientVectorType posnormal = domain->SampleNormalAtPoint(pos, idx);
-  weights.resize(neighborhood.size());
+  weights.resize(neighborhood.size);
 
-  for (unsigned int i = 0; i < neighborhood.size(); i++) {
+  for (unsigned int i = 0; i < neighborhood.size; i++) {
     weights[i] =
         this->AngleCoefficient(posnormal, domain->SampleNormalAtPoint(neighborhood[i].Point, neighborhood[i].Index));
     if (weights[i] < 1.0e-5) {
@@ -36,7 +36,7 @@ void SamplingFunction::ComputeAngularWeights(
 }
 
 double SamplingFunction::EstimateSigma(unsigned int idx,
-                                                      const typename ParticleSystem::PointVectorType& neighborhood,
+                                                      const ParticleNeighborhood::NeighborhoodSpan& neighborhood,
                                                       const shapeworks::ParticleDomain* domain,
                                                       const std::vector<double>& weights, const PointType& pos,
                                                       double initial_sigma, double precision, int& err) const {
@@ -59,7 +59,7 @@ double SamplingFunction::EstimateSigma(unsigned int idx,
     double sigma2 = sigma * sigma;
     double sigma22 = sigma2 * 2.0;
 
-    for (unsigned int i = 0; i < neighborhood.size(); i++) {
+    for (unsigned int i = 0; i < neighborhood.size; i++) {
       if (weights[i] < epsilon) {
         continue;
       }
@@ -137,8 +137,11 @@ SamplingFunction::VectorType SamplingFunction::Evaluate(unsigned int idx, unsign
   // Get the position for which we are computing the gradient.
   PointType pos = system->GetPosition(idx, d);
 
-  // Get the neighborhood surrounding the point "pos".
-  ParticleSystem::PointVectorType neighborhood = system->FindNeighborhoodPoints(pos, idx, neighborhood_radius, d);
+  // Get the neighborhood surrounding the point "pos".  The span points into a thread-local arena owned by the
+  // neighborhood and is valid until the next span query on this thread.  It is unweighted, since
+  // ComputeAngularWeights samples the normals itself.
+  const auto particle_neighborhood = system->GetNeighborhood(d);
+  auto neighborhood = particle_neighborhood->FindUnweightedNeighborhoodSpan(pos, idx, neighborhood_radius);
 
   // Compute the weights based on angle between the neighbors and the center.
   std::vector<double> weights;
@@ -163,7 +166,7 @@ SamplingFunction::VectorType SamplingFunction::Evaluate(unsigned int idx, unsign
       sigma = neighborhood_radius / this->GetNeighborhoodToSigmaRatio();
     }
 
-    neighborhood = system->FindNeighborhoodPoints(pos, neighborhood_radius, d);
+    neighborhood = particle_neighborhood->FindUnweightedNeighborhoodSpan(pos, idx, neighborhood_radius);
     this->ComputeAngularWeights(pos, idx, neighborhood, domain, weights);
     sigma = this->EstimateSigma(idx, neighborhood, domain, weights, pos, sigma, epsilon, err);
   }  // done while err
@@ -173,7 +176,7 @@ SamplingFunction::VectorType SamplingFunction::Evaluate(unsigned int idx, unsign
   if (sigma > this->GetMaximumNeighborhoodRadius()) {
     sigma = this->GetMaximumNeighborhoodRadius() / this->GetNeighborhoodToSigmaRatio();
     neighborhood_radius = this->GetMaximumNeighborhoodRadius();
-    neighborhood = system->FindNeighborhoodPoints(pos, neighborhood_radius, d);
+    neighborhood = particle_neighborhood->FindUnweightedNeighborhoodSpan(pos, idx, neighborhood_radius);
     this->ComputeAngularWeights(pos, idx, neighborhood, domain, weights);
   }
 
@@ -197,7 +200,7 @@ SamplingFunction::VectorType SamplingFunction::Evaluate(unsigned int idx, unsign
   }
 
   double A = 0.0;
-  for (unsigned int i = 0; i < neighborhood.size(); i++) {
+  for (unsigned int i = 0; i < neighborhood.size; i++) {
     //    if ( neighborhood[i].Index == idx) continue;
     if (weights[i] < epsilon) continue;
 
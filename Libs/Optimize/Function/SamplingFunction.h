@@ -108,7 +108,7 @@ class SamplingFunction : public VectorFunction {
 
   /** Estimate the best sigma for Parzen windowing in a given neighborhood.
       The best sigma is the sigma that maximizes probability at the given point  */
-  virtual double EstimateSigma(unsigned int idx, const typename ParticleSystem::PointVectorType& neighborhood,
+  virtual double EstimateSigma(unsigned int idx, const ParticleNeighborhood::NeighborhoodSpan& neighborhood,
                                const shapeworks::ParticleDomain* domain, const std::vector<double>& weights,
                                const PointType& pos, double initial_sigma, double precision, int& err) const;
 
@@ -145,26 +145,28 @@ class SamplingFunction : public VectorFunction {
   /** Compute a set of weights based on the difference in the normals of a
       central point and each of its neighbors.  Difference of > 90 degrees
       results in a weight of 0. */
-  void ComputeAngularWeights(const PointType&, int, const typename ParticleSystem::PointVectorType&,
+  void ComputeAngularWeights(const PointType&, int, const ParticleNeighborhood::NeighborhoodSpan&,
                              const shapeworks::ParticleDomain*, std::vector<double>&) const;
 
   //  void ComputeNeighborho0d();
 
   virtual VectorFunction::Pointer Clone() {
     SamplingFunction::Pointer copy = SamplingFunction::New();
+    copy->ResetFrom(this);
+    return (typename VectorFunction::Pointer)copy;
+  }
 
+  virtual void ResetFrom(const VectorFunction* prototype) {
     // from itkParticleVectorFunction
-    copy->m_DomainNumber = this->m_DomainNumber;
-    copy->m_ParticleSystem = this->m_ParticleSystem;
+    Superclass::ResetFrom(prototype);
 
     // local
-    copy->m_FlatCutoff = this->m_FlatCutoff;
-    copy->m_MaximumNeighborhoodRadius = this->m_MaximumNeighborhoodRadius;
-    copy->m_MinimumNeighborhoodRadius = this->m_MinimumNeighborhoodRadius;
-    copy->m_NeighborhoodToSigmaRatio = this->m_NeighborhoodToSigmaRatio;
-    copy->m_SpatialSigmaCache = this->m_SpatialSigmaCache;
-
-    return (typename VectorFunction::Pointer)copy;
+    auto other = static_cast<const SamplingFunction*>(prototype);
+    m_FlatCutoff = other->m_FlatCutoff;
+    m_MaximumNeighborhoodRadius = other->m_MaximumNeighborhoodRadius;
+    m_MinimumNeighborhoodRadius = other->m_MinimumNeighborhoodRadius;
+    m_NeighborhoodToSigmaRatio = other->m_NeighborhoodToSigmaRatio;
+    m_SpatialSigmaCache = other->m_SpatialSigmaCache;
   }
 
  protected:
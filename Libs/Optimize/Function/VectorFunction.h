@@ -75,9 +75,23 @@ class VectorFunction : public itk::LightObject {
     return nullptr;
   }
 
+  /** Copies the state of the function this object was cloned from back into
+      this object without reallocating it.  This lets the optimizer keep one
+      clone per worker thread and refresh it, instead of cloning per domain.
+      Subclasses that override Clone must override this method as well. */
+  virtual void ResetFrom(const VectorFunction* prototype) {
+    m_ParticleSystem = prototype->m_ParticleSystem;
+    m_DomainNumber = prototype->m_DomainNumber;
+  }
+
   virtual double GetRelativeEnergyScaling() const { return 1.0; }
   virtual void SetRelativeEnergyScaling(double r) { return; }
 
+  /** Returns the sampling (A) and scaled correspondence (B) terms of the
+      energy computed by the last call to Energy(), for functions composed of
+      two terms.  Returns false if the function does not split its energy. */
+  virtual bool GetLastEnergyTerms(double& energy_a, double& energy_b) const { return false; }
+
  protected:
   VectorFunction() : m_ParticleSystem(0), m_DomainNumber(0) {}
   virtual ~VectorFunction() {}
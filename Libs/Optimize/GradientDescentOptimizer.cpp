@@ -4,6 +4,8 @@
 
 const int global_iteration = 1;
 
+#include <tbb/combinable.h>
+#include <tbb/enumerable_thread_specific.h>
 #include <tbb/parallel_for.h>
 #include <time.h>
 
@@ -28,6 +30,19 @@ GradientDescentOptimizer::GradientDescentOptimizer() {
 }
 
 void GradientDescentOptimizer::ResetTimeStepVectors() {
+  // time steps restored with SetTimeSteps are used once, if they still match the particle system
+  const bool keep = m_KeepTimeSteps;
+  m_KeepTimeSteps = false;
+  if (keep && m_TimeSteps.size() == m_ParticleSystem->GetNumberOfDomains()) {
+    bool match = true;
+    for (unsigned int i = 0; i < m_ParticleSystem->GetNumberOfDomains(); i++) {
+      match = match && m_TimeSteps[i].size() == m_ParticleSystem->GetPositions(i)->GetSize();
+    }
+    if (match) {
+      return;
+    }
+  }
+
   // Make sure the time step vector is the right size
   while (m_TimeSteps.size() != m_ParticleSystem->GetNumberOfDomains()) {
     std::vector<double> tmp;
@@ -74,6 +89,11 @@ void GradientDescentOptimizer::StartAdaptiveGaussSeidelOptimization() {
 
   unsigned int counter = 0;
 
+  // One clone of the gradient function per worker thread.  The gradient function is not thread-safe, so each
+  // thread needs its own copy, but cloning for every domain of every iteration is expensive.  The clones are created
+  // lazily and refreshed from m_GradientFunction (ResetFrom) before each domain is processed.
+  tbb::enumerable_thread_specific<typename GradientFunctionType::Pointer> local_gradient_functions;
+
   double maxchange = 0.0;
   while (m_StopOptimization == false)  // iterations loop
   {
@@ -91,9 +111,16 @@ void GradientDescentOptimizer::StartAdaptiveGaussSeidelOptimization() {
     m_GradientFunction->SetParticleSystem(m_ParticleSystem);
     if (counter % global_iteration == 0) m_GradientFunction->BeforeIteration();
     counter++;
+    const auto beforeIterationEnd = std::chrono::steady_clock::now();
+    const size_t clonesBefore = local_gradient_functions.size();
+
+    // per-domain energy terms of the particles at their updated positions, summed per thread
+    tbb::combinable<DomainEnergies> domain_energies([numdomains]() { return DomainEnergies(numdomains); });
 
     // Iterate over each domain
     const auto domains_per_shape = m_ParticleSystem->GetDomainsPerShape();
+    // observers that are only read before the next iteration are updated once per moved particle, per shape
+    m_ParticleSystem->BeginBatchedPositionNotifications();
     tbb::parallel_for(
         tbb::blocked_range<size_t>{0, numdomains / domains_per_shape}, [&](const tbb::blocked_range<size_t>& r) {
           for (size_t shape = r.begin(); shape < r.end(); ++shape) {
@@ -109,10 +136,13 @@ void GradientDescentOptimizer::StartAdaptiveGaussSeidelOptimization() {
 
               const shapeworks::ParticleDomain* domain = m_ParticleSystem->GetDomain(dom);
 
-              typename GradientFunctionType::Pointer localGradientFunction = m_GradientFunction;
-
-              // must clone this as we are in a thread and the gradient function is not thread-safe
-              localGradientFunction = m_GradientFunction->Clone();
+              // must use a clone as we are in a thread and the gradient function is not thread-safe
+              typename GradientFunctionType::Pointer& localGradientFunction = local_gradient_functions.local();
+              if (!localGradientFunction) {
+                localGradientFunction = m_GradientFunction->Clone();
+              } else {
+                localGradientFunction->ResetFrom(m_GradientFunction);
+              }
 
               // Tell function which domain we are working on.
               localGradientFunction->SetDomainNumber(dom);
@@ -185,19 +215,44 @@ void GradientDescentOptimizer::StartAdaptiveGaussSeidelOptimization() {
                     }
                   }
                 }  // end while(true)
+
+                // newenergy is the energy at the position the particle was left at
+                double energy_a, energy_b;
+                if (!localGradientFunction->GetLastEnergyTerms(energy_a, energy_b)) {
+                  energy_a = newenergy;
+                  energy_b = 0.0;
+                }
+                auto& energies = domain_energies.local();
+                energies.a[dom] += energy_a;
+                energies.b[dom] += energy_b;
               }    // for each particle
+              m_ParticleSystem->FlushPositionNotifications(dom);
             }
           }  // for each domain
         });
+    m_ParticleSystem->EndBatchedPositionNotifications();
+
+    m_DomainEnergies = DomainEnergies(numdomains);
+    domain_energies.combine_each([&](const DomainEnergies& energies) {
+      for (unsigned int d = 0; d < numdomains; d++) {
+        m_DomainEnergies.a[d] += energies.a[d];
+        m_DomainEnergies.b[d] += energies.b[d];
+      }
+    });
 
     m_NumberOfIterations++;
     m_GradientFunction->AfterIteration();
 
     const auto accTimerEnd = std::chrono::steady_clock::now();
     const auto msElapsed = std::chrono::duration_cast<std::chrono::milliseconds>(accTimerEnd - accTimerBegin).count();
+    const auto msBeforeIteration =
+        std::chrono::duration_cast<std::chrono::milliseconds>(beforeIterationEnd - accTimerBegin).count();
+    m_UpdateTime += std::chrono::duration<double>(accTimerEnd - beforeIterationEnd).count();
 
     if (m_verbosity > 2) {
-      std::cout << m_NumberOfIterations << ". " << msElapsed << "ms";
+      std::cout << m_NumberOfIterations << ". " << msElapsed << "ms (before iteration " << msBeforeIteration
+                << "ms, updates " << (msElapsed - msBeforeIteration) << "ms, total updates " << m_UpdateTime
+                << "s, new clones " << local_gradient_functions.size() - clonesBefore << ")";
 #ifdef LOG_MEMORY_USAGE
       double vmUsage, residentSet;
       process_mem_usage(vmUsage, residentSet);
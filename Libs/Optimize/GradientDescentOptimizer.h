@@ -114,6 +114,29 @@ class GradientDescentOptimizer : public itk::Object {
   /// Sets the scaling factor at the beginning of the initialization
   void SetInitializationStartScalingFactor(double si) { m_initialization_start_scaling_factor = si; }
 
+  /// Returns the accumulated wall time (seconds) spent in the particle update loop, excluding BeforeIteration
+  double GetUpdateTime() const { return m_UpdateTime; }
+
+  /// Per-domain sums of the particle energies of the last iteration, split into the sampling (a) and scaled
+  /// correspondence (b) terms.  Each particle contributes the energy computed at its updated position, so these
+  /// come for free with the update and need no extra pass over the particles.  Flagged domains are zero.
+  struct DomainEnergies {
+    DomainEnergies(size_t num_domains = 0) : a(num_domains, 0.0), b(num_domains, 0.0) {}
+    std::vector<double> a;
+    std::vector<double> b;
+  };
+  const DomainEnergies& GetDomainEnergies() const { return m_DomainEnergies; }
+
+  /// The adaptive time step of every particle of every domain
+  const std::vector<std::vector<double> >& GetTimeSteps() const { return m_TimeSteps; }
+
+  /// Restores time steps returned by GetTimeSteps.  The next StartOptimization continues with these instead of
+  /// resetting them to 1.0, so a checkpointed optimization can be resumed.
+  void SetTimeSteps(const std::vector<std::vector<double> >& time_steps) {
+    m_TimeSteps = time_steps;
+    m_KeepTimeSteps = true;
+  }
+
  protected:
   GradientDescentOptimizer();
   GradientDescentOptimizer(const GradientDescentOptimizer&);
@@ -131,6 +154,7 @@ class GradientDescentOptimizer : public itk::Object {
   double m_Tolerance;
   double m_TimeStep;
   std::vector<std::vector<double> > m_TimeSteps;
+  bool m_KeepTimeSteps = false;
   unsigned int m_verbosity;
 
   // Adaptive Initialization variables
@@ -138,6 +162,10 @@ class GradientDescentOptimizer : public itk::Object {
   size_t m_check_iterations = 50;
   double m_initialization_start_scaling_factor;
 
+  double m_UpdateTime = 0.0;
+
+  DomainEnergies m_DomainEnergies;
+
   void ResetTimeStepVectors();
 };
 
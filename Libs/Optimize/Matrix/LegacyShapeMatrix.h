@@ -79,12 +79,8 @@ class LegacyShapeMatrix : public vnl_matrix<double>, public Observer {
     for (unsigned int i = 0; i < VDimension; i++) this->operator()(i + k, d / m_DomainsPerShape) = pos[i];
   }
 
-  virtual void PositionSetEventCallback(Object* o, const itk::EventObject& e) {
+  void PositionSetCallback(const ParticleSystem* ps, unsigned int d, unsigned int idx) override {
     const int VDimension = 3;
-    const ParticlePositionSetEvent& event = dynamic_cast<const ParticlePositionSetEvent&>(e);
-    const ParticleSystem* ps = dynamic_cast<const ParticleSystem*>(o);
-    const int d = event.GetDomainIndex();
-    const unsigned int idx = event.GetPositionIndex();
     const typename ParticleSystem::PointType pos = ps->GetTransformedPosition(idx, d);
 
     unsigned int k = 0;
@@ -123,12 +123,7 @@ class LinearRegressionShapeMatrix : public LegacyShapeMatrix {
     //   std::cout << "Row " << k << " Col " << d / this->m_DomainsPerShape << " = " << pos << std::endl;
   }
 
-  virtual void PositionSetEventCallback(Object* o, const itk::EventObject& e) {
-    const ParticlePositionSetEvent& event = dynamic_cast<const ParticlePositionSetEvent&>(e);
-
-    const ParticleSystem* ps = dynamic_cast<const ParticleSystem*>(o);
-    const int d = event.GetDomainIndex();
-    const unsigned int idx = event.GetPositionIndex();
+  void PositionSetCallback(const ParticleSystem* ps, unsigned int d, unsigned int idx) override {
     const typename ParticleSystem::PointType pos = ps->GetTransformedPosition(idx, d);
     const unsigned int PointsPerDomain = ps->GetNumberOfParticles(d);
 
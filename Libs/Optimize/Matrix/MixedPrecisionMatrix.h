@@ -0,0 +1,99 @@
+#pragma once
+
+#include <Eigen/Core>
+
+#include "vnl/vnl_matrix.h"
+
+namespace shapeworks {
+
+/** \class MixedPrecisionMatrix
+ *
+ * \brief A dense, row major matrix that stores its elements in double or,
+ * optionally, in single precision.
+ *
+ * Elements are read and written as doubles, and the consumers of the matrix
+ * accumulate in double regardless of the storage, so single precision only
+ * rounds the stored values.  It halves the memory and bandwidth of the shape
+ * and shape gradient matrices, which dominate on large cohorts.
+ */
+class MixedPrecisionMatrix {
+ public:
+  template <class Scalar>
+  using StorageType = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+  //! Switch between single and double precision storage, converting the current values
+  void SetSinglePrecision(bool single_precision) {
+    if (single_precision == m_SinglePrecision) {
+      return;
+    }
+    if (single_precision) {
+      m_Float = m_Double.cast<float>();
+      m_Double.resize(0, 0);
+    } else {
+      m_Double = m_Float.cast<double>();
+      m_Float.resize(0, 0);
+    }
+    m_SinglePrecision = single_precision;
+  }
+  bool IsSinglePrecision() const { return m_SinglePrecision; }
+
+  unsigned int rows() const { return m_SinglePrecision ? m_Float.rows() : m_Double.rows(); }
+  unsigned int cols() const { return m_SinglePrecision ? m_Float.cols() : m_Double.cols(); }
+
+  double get(unsigned int r, unsigned int c) const { return m_SinglePrecision ? m_Float(r, c) : m_Double(r, c); }
+
+  void put(unsigned int r, unsigned int c, double value) {
+    if (m_SinglePrecision) {
+      m_Float(r, c) = static_cast<float>(value);
+    } else {
+      m_Double(r, c) = value;
+    }
+  }
+
+  //! Resize, keeping the elements that are within both the old and the new size.  New elements are uninitialized.
+  void ResizeMatrix(int rs, int cs) {
+    if (m_SinglePrecision) {
+      m_Float.conservativeResize(rs, cs);
+    } else {
+      m_Double.conservativeResize(rs, cs);
+    }
+  }
+
+  virtual void SetMatrix(const vnl_matrix<double>& m) {
+    StorageType<double> values(m.rows(), m.cols());
+    for (unsigned int r = 0; r < m.rows(); r++) {
+      for (unsigned int c = 0; c < m.cols(); c++) {
+        values(r, c) = m(r, c);
+      }
+    }
+    if (m_SinglePrecision) {
+      m_Float = values.cast<float>();
+    } else {
+      m_Double = std::move(values);
+    }
+  }
+
+  //! The elements in the storage precision, Scalar must match IsSinglePrecision()
+  template <class Scalar>
+  const StorageType<Scalar>& GetStorage() const;
+
+ protected:
+  virtual ~MixedPrecisionMatrix() = default;
+
+ private:
+  bool m_SinglePrecision = false;
+  StorageType<double> m_Double;
+  StorageType<float> m_Float;
+};
+
+template <>
+inline const MixedPrecisionMatrix::StorageType<double>& MixedPrecisionMatrix::GetStorage<double>() const {
+  return m_Double;
+}
+
+template <>
+inline const MixedPrecisionMatrix::StorageType<float>& MixedPrecisionMatrix::GetStorage<float>() const {
+  return m_Float;
+}
+
+}  // namespace shapeworks
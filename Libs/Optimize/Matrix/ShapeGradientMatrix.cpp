@@ -46,9 +46,9 @@ void ShapeGradientMatrix::SetValues(const ParticleSystemType* ps, int idx, int d
     for (unsigned int i = 0; i < 3; i++) {
       for (unsigned int j = 0; j < 3; j++) {
         if (i == j) {
-          this->operator()(i + k, j + 3 * (d / m_DomainsPerShape)) = 1.0 * m_AttributeScales[num + i];
+          this->put(i + k, j + 3 * (d / m_DomainsPerShape), 1.0 * m_AttributeScales[num + i]);
         } else {
-          this->operator()(i + k, j + 3 * (d / m_DomainsPerShape)) = 0.0;
+          this->put(i + k, j + 3 * (d / m_DomainsPerShape), 0.0);
         }
       }
     }
@@ -59,7 +59,7 @@ void ShapeGradientMatrix::SetValues(const ParticleSystemType* ps, int idx, int d
     if (ps->GetDomainFlag(d)) {
       for (unsigned int c = s; c < s + 3; c++) {
         for (unsigned int vd = 0; vd < 3; vd++) {
-          this->operator()(c - s + k, vd + 3 * (d / m_DomainsPerShape)) = 0.0 * m_AttributeScales[num + c];
+          this->put(c - s + k, vd + 3 * (d / m_DomainsPerShape), 0.0 * m_AttributeScales[num + c]);
         }
       }
       s += 3;
@@ -102,7 +102,7 @@ void ShapeGradientMatrix::SetValues(const ParticleSystemType* ps, int idx, int d
 
       for (unsigned int c = s; c < s + 3; c++) {
         for (unsigned int vd = 0; vd < 3; vd++) {
-          this->operator()(c - s + k, vd + 3 * (d / m_DomainsPerShape)) = tmp(c - s, vd) * m_AttributeScales[num + c];
+          this->put(c - s + k, vd + 3 * (d / m_DomainsPerShape), tmp(c - s, vd) * m_AttributeScales[num + c]);
         }
       }
       s += 3;
@@ -114,7 +114,7 @@ void ShapeGradientMatrix::SetValues(const ParticleSystemType* ps, int idx, int d
     if (ps->GetDomainFlag(d)) {
       for (int aa = 0; aa < m_AttributesPerDomain[dom]; aa++) {
         for (unsigned int vd = 0; vd < 3; vd++) {
-          this->operator()(aa + k, vd + 3 * (d / m_DomainsPerShape)) = 0.0 * m_AttributeScales[num + aa + s];
+          this->put(aa + k, vd + 3 * (d / m_DomainsPerShape), 0.0 * m_AttributeScales[num + aa + s]);
         }
       }
     } else {
@@ -137,7 +137,7 @@ void ShapeGradientMatrix::SetValues(const ParticleSystemType* ps, int idx, int d
         Eigen::Vector3d gradient = mesh->computeFieldGradientAtPoint(field_attributes[aa], point);
 
         for (int vd = 0; vd < 3; vd++) {
-          this->operator()(aa + k, vd + 3 * (d / m_DomainsPerShape)) = gradient[vd] * m_AttributeScales[num + aa + s];
+          this->put(aa + k, vd + 3 * (d / m_DomainsPerShape), gradient[vd] * m_AttributeScales[num + aa + s]);
         }
       }
     }
@@ -4,6 +4,7 @@
 #include "Libs/Optimize/Domain/ImageDomainWithGradN.h"
 #include "Libs/Optimize/Domain/ImageDomainWithGradients.h"
 #include "Libs/Optimize/Domain/ImplicitSurfaceDomain.h"
+#include "MixedPrecisionMatrix.h"
 #include "Observer.h"
 #include "ParticleSystem.h"
 #include "itkDataObject.h"
@@ -18,9 +19,10 @@ namespace shapeworks {
  * SAME NUMBER OF PARTICLES!
  *
  *
- * Each column represents a single shape.
+ * Each column represents a single shape.  The matrix may be stored in single
+ * precision, see MixedPrecisionMatrix.
  */
-class ShapeGradientMatrix : public vnl_matrix<double>, public Observer {
+class ShapeGradientMatrix : public MixedPrecisionMatrix, public Observer {
  public:
   /** Standard class typedefs */
   typedef double DataType;
@@ -60,22 +62,6 @@ class ShapeGradientMatrix : public vnl_matrix<double>, public Observer {
     m_use_normals[i] = val;
   }
 
-  virtual void SetMatrix(const vnl_matrix<double>& m) { vnl_matrix<double>::operator=(m); }
-
-  virtual void ResizeMatrix(int rs, int cs) {
-    vnl_matrix<double> tmp(*this);  // copy existing  matrix
-
-    // Create new column (shape)
-    this->set_size(rs, cs);
-
-    // Copy old data into new matrix.
-    for (unsigned int c = 0; c < tmp.cols(); c++) {
-      for (unsigned int r = 0; r < tmp.rows(); r++) {
-        this->operator()(r, c) = tmp(r, c);
-      }
-    }
-  }
-
   void SetValues(const ParticleSystemType* ps, int idx, int d);
 
   virtual void DomainAddEventCallback(Object*, const itk::EventObject& e) {
@@ -112,13 +98,8 @@ class ShapeGradientMatrix : public vnl_matrix<double>, public Observer {
     this->SetValues(ps, idx, d);
   }
 
-  virtual void PositionSetEventCallback(Object* o, const itk::EventObject& e) {
+  void PositionSetCallback(const ParticleSystem* ps, unsigned int d, unsigned int idx) override {
     // update xyz, normals and number of attributes being used
-    const ParticlePositionSetEvent& event = dynamic_cast<const ParticlePositionSetEvent&>(e);
-    const ParticleSystem* ps = dynamic_cast<const ParticleSystem*>(o);
-    const int d = event.GetDomainIndex();
-    const unsigned int idx = event.GetPositionIndex();
-
     this->SetValues(ps, idx, d);
   }
 
@@ -132,7 +113,8 @@ class ShapeGradientMatrix : public vnl_matrix<double>, public Observer {
 
     this->m_DefinedCallbacks.DomainAddEvent = true;
     this->m_DefinedCallbacks.PositionAddEvent = true;
-    this->m_DefinedCallbacks.PositionSetEvent = true;
+    // only read when the correspondence updates are computed before each iteration
+    this->m_DefinedCallbacks.BatchedPositionSetEvent = true;
     this->m_DefinedCallbacks.PositionRemoveEvent = true;
   }
   virtual ~ShapeGradientMatrix() {}
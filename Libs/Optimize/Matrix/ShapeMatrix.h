@@ -6,6 +6,7 @@
 #include "Libs/Optimize/Container/GenericContainer.h"
 #include "Libs/Optimize/Domain/ImageDomainWithGradients.h"
 #include "Libs/Optimize/Domain/ImplicitSurfaceDomain.h"
+#include "MixedPrecisionMatrix.h"
 #include "Observer.h"
 #include "ParticleSystem.h"
 #include "itkDataObject.h"
@@ -20,9 +21,10 @@ namespace shapeworks {
  * SAME NUMBER OF PARTICLES!
  *
  *
- * Each column represents a single shape.
+ * Each column represents a single shape.  The matrix may be stored in single
+ * precision, see MixedPrecisionMatrix.
  */
-class ShapeMatrix : public vnl_matrix<double>, public Observer {
+class ShapeMatrix : public MixedPrecisionMatrix, public Observer {
  public:
   /** Standard class typedefs */
   typedef double DataType;
@@ -59,20 +61,6 @@ class ShapeMatrix : public vnl_matrix<double>, public Observer {
     m_use_normals[i] = val;
   }
 
-  virtual void SetMatrix(const vnl_matrix<double>& m) { vnl_matrix<double>::operator=(m); }
-
-  virtual void ResizeMatrix(int rs, int cs) {
-    vnl_matrix<double> tmp(*this);  // copy existing  matrix
-
-    // Create new column (shape)
-    this->set_size(rs, cs);
-
-    // Copy old data into new matrix.
-    for (unsigned int c = 0; c < tmp.cols(); c++) {
-      for (unsigned int r = 0; r < tmp.rows(); r++) this->operator()(r, c) = tmp(r, c);
-    }
-  }
-
   virtual void DomainAddEventCallback(Object*, const itk::EventObject& e) {
     const ParticleDomainAddEvent& event = dynamic_cast<const ParticleDomainAddEvent&>(e);
     unsigned int d = event.GetDomainIndex();
@@ -107,7 +95,7 @@ class ShapeMatrix : public vnl_matrix<double>, public Observer {
     int s = 0;
     if (m_use_xyz[dom]) {
       for (unsigned int i = 0; i < VDimension; i++) {
-        this->operator()(i + k, d / m_DomainsPerShape) = pos[i] * m_AttributeScales[num + i + s];
+        this->put(i + k, d / m_DomainsPerShape, pos[i] * m_AttributeScales[num + i + s]);
       }
       k += VDimension;
       s += VDimension;
@@ -124,7 +112,7 @@ class ShapeMatrix : public vnl_matrix<double>, public Observer {
       pN[2] = tmp[2];
       pN = pN.normalize();  // contains scaling
       for (unsigned int i = 0; i < VDimension; i++) {
-        this->operator()(i + k, d / m_DomainsPerShape) = pN[i] * m_AttributeScales[num + i + s];
+        this->put(i + k, d / m_DomainsPerShape, pN[i] * m_AttributeScales[num + i + s]);
       }
       k += VDimension;
       s += VDimension;
@@ -148,7 +136,7 @@ class ShapeMatrix : public vnl_matrix<double>, public Observer {
       }
 
       for (int aa = 0; aa < m_AttributesPerDomain[dom]; aa++) {
-        this->operator()(aa + k, d / m_DomainsPerShape) = feature_values[aa] * m_AttributeScales[aa + num + s];
+        this->put(aa + k, d / m_DomainsPerShape, feature_values[aa] * m_AttributeScales[aa + num + s]);
       }
     }
   }
@@ -174,13 +162,8 @@ class ShapeMatrix : public vnl_matrix<double>, public Observer {
     this->SetValues(ps, idx, d);
   }
 
-  virtual void PositionSetEventCallback(Object* o, const itk::EventObject& e) {
+  void PositionSetCallback(const ParticleSystem* ps, unsigned int d, unsigned int idx) override {
     // update xyz, normals and number of attributes being used
-    const ParticlePositionSetEvent& event = dynamic_cast<const ParticlePositionSetEvent&>(e);
-    const ParticleSystem* ps = dynamic_cast<const ParticleSystem*>(o);
-    const int d = event.GetDomainIndex();
-    const unsigned int idx = event.GetPositionIndex();
-
     this->SetValues(ps, idx, d);
   }
 
@@ -192,7 +175,7 @@ class ShapeMatrix : public vnl_matrix<double>, public Observer {
     std::cout << std::endl;
     for (unsigned int r = 0; r < this->rows(); r++) {
       for (unsigned int c = 0; c < this->cols(); c++) {
-        std::cout << this->operator()(r, c) << "  ";
+        std::cout << this->get(r, c) << "  ";
       }
       std::cout << std::endl;
     }
@@ -202,7 +185,7 @@ class ShapeMatrix : public vnl_matrix<double>, public Observer {
     bool flag = false;
     for (unsigned int r = 0; r < this->rows(); r++) {
       for (unsigned int c = 0; c < this->cols(); c++) {
-        if (std::isnan(this->operator()(r, c))) {
+        if (std::isnan(this->get(r, c))) {
           flag = true;
           break;
         }
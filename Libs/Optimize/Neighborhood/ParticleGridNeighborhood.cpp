@@ -0,0 +1,215 @@
+
+#include "ParticleGridNeighborhood.h"
+
+#include <algorithm>
+
+namespace shapeworks {
+
+void ParticleGridNeighborhood::SetDomain(ParticleDomain::Pointer d) {
+  // skip ParticleRegionNeighborhood::SetDomain, we don't use the tree
+  ParticleNeighborhood::SetDomain(d);
+  Rebuild();
+}
+
+void ParticleGridNeighborhood::SetCellSize(double cell_size) {
+  m_RequestedCellSize = cell_size;
+  if (this->GetDomain()) {
+    Rebuild();
+  }
+}
+
+void ParticleGridNeighborhood::Rebuild() {
+  const auto domain = this->GetDomain();
+  const PointType& lower = domain->GetLowerBound();
+  const PointType& upper = domain->GetUpperBound();
+
+  double max_extent = 0.0;
+  for (unsigned int i = 0; i < VDimension; i++) {
+    max_extent = std::max(max_extent, upper[i] - lower[i]);
+  }
+  if (max_extent <= 0.0) {
+    max_extent = 1.0;
+  }
+
+  if (m_RequestedCellSize > 0.0) {
+    m_CellSize = m_RequestedCellSize;
+  } else {
+    // Roughly cbrt(N) cells along the longest axis.  This keeps the number of cells on the order of the number of
+    // particles, and since particles live on a surface, the occupied cells hold a handful of particles each.
+    const int cells_per_axis = std::clamp(static_cast<int>(std::ceil(std::cbrt(double(m_NumberOfPoints)))), 1, 128);
+    m_CellSize = max_extent / cells_per_axis;
+  }
+
+  // guard against a requested cell size that is tiny compared to the domain
+  const size_t max_cells = size_t(1) << 24;
+  while (true) {
+    size_t num_cells = 1;
+    for (unsigned int i = 0; i < VDimension; i++) {
+      m_Origin[i] = lower[i];
+      m_Dims[i] = std::max(1, static_cast<int>(std::ceil((upper[i] - lower[i]) / m_CellSize)));
+      num_cells *= m_Dims[i];
+    }
+    if (num_cells <= max_cells) {
+      break;
+    }
+    m_CellSize *= 2.0;
+  }
+
+  m_Cells.clear();
+  m_Cells.resize(static_cast<size_t>(m_Dims[0]) * m_Dims[1] * m_Dims[2]);
+
+  for (unsigned int idx = 0; idx < m_PointCell.size(); idx++) {
+    if (m_PointCell[idx] >= 0) {
+      InsertIntoCell(idx, CellIndex(m_Points[idx].Point));
+    }
+  }
+
+  m_NumberOfPointsAtRebuild = m_NumberOfPoints;
+}
+
+void ParticleGridNeighborhood::InsertIntoCell(unsigned int idx, int cell) {
+  auto& list = m_Cells[cell];
+  m_PointCell[idx] = cell;
+  m_PointSlot[idx] = list.size();
+  list.push_back(idx);
+}
+
+void ParticleGridNeighborhood::RemoveFromCell(unsigned int idx) {
+  // swap the last entry of the cell into the removed slot
+  auto& list = m_Cells[m_PointCell[idx]];
+  const unsigned int slot = m_PointSlot[idx];
+  const unsigned int moved = list.back();
+  list[slot] = moved;
+  m_PointSlot[moved] = slot;
+  list.pop_back();
+  m_PointCell[idx] = -1;
+}
+
+void ParticleGridNeighborhood::AddPosition(const PointType& p, unsigned int idx, int) {
+  if (idx >= m_Points.size()) {
+    m_Points.resize(idx + 1);
+    m_PointCell.resize(idx + 1, -1);
+    m_PointSlot.resize(idx + 1, 0);
+  }
+
+  if (m_PointCell[idx] >= 0) {
+    RemoveFromCell(idx);
+  } else {
+    m_NumberOfPoints++;
+  }
+
+  m_Points[idx] = ParticlePointIndexPair(p, idx);
+  InsertIntoCell(idx, CellIndex(p));
+
+  if (m_RequestedCellSize <= 0.0 && m_NumberOfPoints > 2 * m_NumberOfPointsAtRebuild) {
+    Rebuild();
+  }
+}
+
+void ParticleGridNeighborhood::AddPositions(const std::vector<PointType>& points, unsigned int first_idx) {
+  const size_t end = first_idx + points.size();
+  if (end > m_Points.size()) {
+    m_Points.resize(end);
+    m_PointCell.resize(end, -1);
+    m_PointSlot.resize(end, 0);
+  }
+
+  for (size_t i = 0; i < points.size(); i++) {
+    const unsigned int idx = first_idx + i;
+    if (m_PointCell[idx] >= 0) {
+      RemoveFromCell(idx);
+    } else {
+      m_NumberOfPoints++;
+    }
+    m_Points[idx] = ParticlePointIndexPair(points[i], idx);
+    InsertIntoCell(idx, CellIndex(points[i]));
+  }
+
+  if (m_RequestedCellSize <= 0.0 && m_NumberOfPoints > 2 * m_NumberOfPointsAtRebuild) {
+    Rebuild();
+  }
+}
+
+void ParticleGridNeighborhood::SetPosition(const PointType& p, unsigned int idx, int threadId) {
+  if (idx >= m_PointCell.size() || m_PointCell[idx] < 0) {
+    this->AddPosition(p, idx, threadId);
+    return;
+  }
+
+  m_Points[idx].Point = p;
+
+  // only move between cells if the particle has left its current cell
+  const int cell = CellIndex(p);
+  if (cell != m_PointCell[idx]) {
+    RemoveFromCell(idx);
+    InsertIntoCell(idx, cell);
+  }
+}
+
+void ParticleGridNeighborhood::RemovePosition(unsigned int idx, int) {
+  if (idx >= m_PointCell.size() || m_PointCell[idx] < 0) {
+    return;
+  }
+  RemoveFromCell(idx);
+  m_NumberOfPoints--;
+}
+
+ParticleGridNeighborhood::PointVectorType ParticleGridNeighborhood::FindNeighborhoodPoints(const PointType& center,
+                                                                                           int idx,
+                                                                                           double radius) const {
+  PointVectorType ret;
+  std::vector<double> distances;
+  this->FindNeighborhoodPoints(center, idx, ret, distances, radius);
+  return ret;
+}
+
+void ParticleGridNeighborhood::FindNeighborhoodPoints(const PointType& center, int idx, PointVectorType& neighbors,
+                                                      std::vector<double>& distances, double radius) const {
+  const auto domain = this->GetDomain();
+
+  neighbors.clear();
+  distances.clear();
+
+  ForEachCandidate(center, radius, [&](const ParticlePointIndexPair& candidate) {
+    double distance = domain->Distance(center, idx, candidate.Point, candidate.Index);
+    if (distance < radius && distance > 0) {
+      neighbors.push_back(candidate);
+      distances.push_back(distance);
+    }
+  });
+}
+
+void ParticleGridNeighborhood::FindNeighborhoodPoints(const PointType& center, int idx, PointVectorType& neighbors,
+                                                      std::vector<double>& weights, std::vector<double>& distances,
+                                                      double radius) const {
+  const auto domain = this->GetDomain();
+
+  GradientVectorType posnormal;
+  if (m_WeightingEnabled) {  // uninitialized otherwise, but we're trying to avoid looking up the normal if we can
+    posnormal = domain->SampleNormalAtPoint(center, idx);
+  }
+
+  neighbors.clear();
+  weights.clear();
+  distances.clear();
+
+  ForEachCandidate(center, radius, [&](const ParticlePointIndexPair& candidate) {
+    AddIfNeighbor(domain.get(), center, idx, posnormal, candidate, radius, neighbors, weights, distances);
+  });
+}
+
+ParticleGridNeighborhood::PointVectorType ParticleGridNeighborhood::FindNeighborhoodPoints(
+    const PointType& center, int idx, std::vector<double>& weights, std::vector<double>& distances,
+    double radius) const {
+  PointVectorType ret;
+  this->FindNeighborhoodPoints(center, idx, ret, weights, distances, radius);
+  return ret;
+}
+
+ParticleGridNeighborhood::PointVectorType ParticleGridNeighborhood::FindNeighborhoodPoints(
+    const PointType& center, int idx, std::vector<double>& weights, double radius) const {
+  std::vector<double> distances;
+  return this->FindNeighborhoodPoints(center, idx, weights, distances, radius);
+}
+
+}  // namespace shapeworks
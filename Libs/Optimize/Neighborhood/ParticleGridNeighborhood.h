@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "ParticleSurfaceNeighborhood.h"
+
+namespace shapeworks {
+/** \class ParticleGridNeighborhood
+ *
+ * ParticleGridNeighborhood computes the same neighborhoods as
+ * ParticleSurfaceNeighborhood, but bins the particles into a flat uniform grid
+ * of cells instead of a PowerOfTwoPointTree.  Each cell stores the indices of
+ * its particles in a contiguous array and the particle positions are stored in
+ * a single array indexed by particle index, so a query touches only a few
+ * small arrays and does not allocate when the caller-provided buffer variant
+ * of FindNeighborhoodPoints is used.
+ *
+ * The grid is updated incrementally as particles move.  Unless a cell size is
+ * given, it is derived from the domain bounds and the number of particles, and
+ * the grid is rebuilt whenever the number of particles doubles (e.g. after a
+ * particle split).
+ */
+class ParticleGridNeighborhood : public ParticleSurfaceNeighborhood {
+ public:
+  /** Standard class typedefs */
+  typedef ParticleGridNeighborhood Self;
+  typedef ParticleSurfaceNeighborhood Superclass;
+  typedef itk::SmartPointer<Self> Pointer;
+  typedef itk::SmartPointer<const Self> ConstPointer;
+  typedef itk::WeakPointer<const Self> ConstWeakPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ParticleGridNeighborhood, ParticleSurfaceNeighborhood);
+
+  /** Inherited typedefs from parent class. */
+  typedef typename Superclass::PointType PointType;
+  typedef typename Superclass::PointVectorType PointVectorType;
+  typedef typename Superclass::GradientVectorType GradientVectorType;
+
+  using Superclass::FindNeighborhoodPoints;
+
+  PointVectorType FindNeighborhoodPoints(const PointType&, int idx, double) const override;
+  void FindNeighborhoodPoints(const PointType&, int idx, PointVectorType& neighbors, std::vector<double>& distances,
+                              double radius) const override;
+  PointVectorType FindNeighborhoodPoints(const PointType&, int idx, std::vector<double>&, std::vector<double>&,
+                                         double) const override;
+  PointVectorType FindNeighborhoodPoints(const PointType&, int idx, std::vector<double>&, double) const override;
+  void FindNeighborhoodPoints(const PointType&, int idx, PointVectorType& neighbors, std::vector<double>& weights,
+                              std::vector<double>& distances, double radius) const override;
+
+  /** Override SetDomain so that we can grab the region extent info and
+      construct our grid. */
+  void SetDomain(ParticleDomain::Pointer p) override;
+
+  void AddPosition(const PointType& p, unsigned int idx, int threadId = 0) override;
+  void SetPosition(const PointType& p, unsigned int idx, int threadId = 0) override;
+  void RemovePosition(unsigned int idx, int threadId = 0) override;
+
+  /** Adds a block of particles, growing the arrays and checking whether the
+      grid needs to be rebuilt only once. */
+  void AddPositions(const std::vector<PointType>& points, unsigned int first_idx) override;
+
+  /** Set/Get the edge length of the grid cells.  A value of 0 (the default)
+      chooses the cell size automatically from the domain bounds and the number
+      of particles. */
+  void SetCellSize(double cell_size);
+  double GetCellSize() const { return m_CellSize; }
+
+  void PrintSelf(std::ostream& os, itk::Indent indent) const {
+    os << indent << "m_CellSize = " << m_CellSize << std::endl;
+    os << indent << "m_Dims = " << m_Dims[0] << " x " << m_Dims[1] << " x " << m_Dims[2] << std::endl;
+    os << indent << "m_NumberOfPoints = " << m_NumberOfPoints << std::endl;
+    ParticleNeighborhood::PrintSelf(os, indent);
+  }
+
+ protected:
+  ParticleGridNeighborhood() {}
+  virtual ~ParticleGridNeighborhood(){};
+
+  /** Recompute the grid dimensions and re-bin all particles. */
+  void Rebuild();
+
+  /** Returns the (clamped) cell coordinate of a position along one axis. */
+  inline int CellCoordinate(double x, unsigned int axis) const {
+    // clamp in floating point so that far away (or NaN) positions can't overflow the int conversion
+    const double c = std::floor((x - m_Origin[axis]) / m_CellSize);
+    if (!(c > 0.0)) {
+      return 0;
+    }
+    return c >= m_Dims[axis] ? m_Dims[axis] - 1 : static_cast<int>(c);
+  }
+
+  inline int CellIndex(const PointType& p) const {
+    return (CellCoordinate(p[2], 2) * m_Dims[1] + CellCoordinate(p[1], 1)) * m_Dims[0] + CellCoordinate(p[0], 0);
+  }
+
+  void InsertIntoCell(unsigned int idx, int cell);
+  void RemoveFromCell(unsigned int idx);
+
+  /** Calls f(pair) for every particle in the cells overlapping the bounding
+      box of the sphere (center, radius). */
+  template <typename Function>
+  void ForEachCandidate(const PointType& center, double radius, Function f) const {
+    int lo[3], hi[3];
+    for (unsigned int i = 0; i < 3; i++) {
+      lo[i] = CellCoordinate(center[i] - radius, i);
+      hi[i] = CellCoordinate(center[i] + radius, i);
+    }
+    for (int k = lo[2]; k <= hi[2]; k++) {
+      for (int j = lo[1]; j <= hi[1]; j++) {
+        for (int i = lo[0]; i <= hi[0]; i++) {
+          const auto& cell = m_Cells[(k * m_Dims[1] + j) * m_Dims[0] + i];
+          for (unsigned int idx : cell) {
+            f(m_Points[idx]);
+          }
+        }
+      }
+    }
+  }
+
+  //! particle positions and indices, indexed by particle index
+  std::vector<ParticlePointIndexPair> m_Points;
+  //! cell of each particle, -1 if the particle is not present
+  std::vector<int> m_PointCell;
+  //! position of each particle within its cell's index array
+  std::vector<unsigned int> m_PointSlot;
+  //! particle indices binned by cell
+  std::vector<std::vector<unsigned int>> m_Cells;
+
+  PointType m_Origin;
+  int m_Dims[3] = {1, 1, 1};
+  double m_CellSize = 1.0;
+  double m_RequestedCellSize = 0.0;
+  size_t m_NumberOfPoints = 0;
+  size_t m_NumberOfPointsAtRebuild = 0;
+
+ private:
+  ParticleGridNeighborhood(const Self&);  // purposely not implemented
+  void operator=(const Self&);            // purposely not implemented
+};
+
+}  // end namespace shapeworks
@@ -53,6 +53,29 @@ class ParticleNeighborhood : public itk::DataObject {
   /** Point list (vector) type.  This is the type of list returned by FindNeighborhoodPoints. */
   typedef std::vector<ParticlePointIndexPair> PointVectorType;
 
+  /** A non-owning view of the neighbors of one particle, along with their
+      weights and distances. */
+  struct NeighborhoodSpan {
+    const ParticlePointIndexPair* points = nullptr;
+    const double* weights = nullptr;
+    const double* distances = nullptr;
+    size_t size = 0;
+
+    const ParticlePointIndexPair& operator[](size_t i) const { return points[i]; }
+    const ParticlePointIndexPair* begin() const { return points; }
+    const ParticlePointIndexPair* end() const { return points + size; }
+  };
+
+  /** Scratch buffers that a neighborhood query writes into.  Reusing one
+      across queries avoids allocating on every query. */
+  struct NeighborhoodArena {
+    PointVectorType points;
+    std::vector<double> weights;
+    std::vector<double> distances;
+
+    NeighborhoodSpan Span() const { return {points.data(), weights.data(), distances.data(), points.size()}; }
+  };
+
   /** Set/Get the point container.  These are the points parsed by the
       Neighborhood class when FindNeighborhoodPoints is called. */
   itkSetObjectMacro(PointContainer, PointContainerType);
@@ -78,6 +101,48 @@ class ParticleNeighborhood : public itk::DataObject {
     itkExceptionMacro("No algorithm for finding neighbors has been specified.");
     return 0;
   }
+  /** This method finds neighborhood points, weights and distances as above,
+      but writes them into caller-provided buffers, which are cleared first.
+      Subclasses should override this to avoid allocating. */
+  virtual void FindNeighborhoodPoints(const PointType& center, int idx, PointVectorType& neighbors,
+                                      std::vector<double>& weights, std::vector<double>& distances,
+                                      double radius) const {
+    neighbors = this->FindNeighborhoodPoints(center, idx, weights, distances, radius);
+  }
+  /** This method finds the same neighborhood points as the first method, i.e.
+      the points whose domain distance from center is below radius and above
+      zero, and writes them and their distances into caller-provided buffers,
+      which are cleared first.  No weights are computed.  Subclasses should
+      override this to avoid allocating. */
+  virtual void FindNeighborhoodPoints(const PointType& center, int idx, PointVectorType& neighbors,
+                                      std::vector<double>& distances, double radius) const {
+    neighbors = this->FindNeighborhoodPoints(center, idx, radius);
+    distances.clear();
+    for (const auto& neighbor : neighbors) {
+      distances.push_back(m_Domain->Distance(center, idx, neighbor.Point, neighbor.Index));
+    }
+  }
+
+  /** Finds the neighborhood of a point and returns a view of the result.  The
+      result lives in a thread-local arena and is only valid until the next
+      call to this method on the same thread, so copy out anything that must
+      outlive it. */
+  NeighborhoodSpan FindNeighborhoodSpan(const PointType& center, int idx, double radius) const {
+    auto& arena = ThreadArena();
+    this->FindNeighborhoodPoints(center, idx, arena.points, arena.weights, arena.distances, radius);
+    return arena.Span();
+  }
+
+  /** Same as FindNeighborhoodSpan, but finds the neighborhood of the first
+      FindNeighborhoodPoints method, without weighting it.  All weights of the
+      result are 1.  Callers that compute their own weights use this to avoid
+      sampling the normals of the neighbors twice. */
+  NeighborhoodSpan FindUnweightedNeighborhoodSpan(const PointType& center, int idx, double radius) const {
+    auto& arena = ThreadArena();
+    this->FindNeighborhoodPoints(center, idx, arena.points, arena.distances, radius);
+    arena.weights.assign(arena.points.size(), 1.0);
+    return arena.Span();
+  }
 
   /** Set the Domain that this neighborhood will use.  The Domain object is
       important because it defines bounds and distance measures. */
@@ -98,8 +163,24 @@ class ParticleNeighborhood : public itk::DataObject {
   virtual void SetPosition(const PointType& p, unsigned int idx, int threadId = 0) {}
   virtual void RemovePosition(unsigned int idx, int threadId = 0) {}
 
+  /** Adds a block of particles with consecutive indices starting at
+      first_idx, as when particles are split.  Subclasses may override this to
+      update their structures once for the whole block. */
+  virtual void AddPositions(const std::vector<PointType>& points, unsigned int first_idx) {
+    for (size_t i = 0; i < points.size(); i++) {
+      this->AddPosition(points[i], first_idx + i);
+    }
+  }
+
  protected:
   ParticleNeighborhood() {}
+
+  /** Per-thread scratch buffers backing FindNeighborhoodSpan. */
+  static NeighborhoodArena& ThreadArena() {
+    static thread_local NeighborhoodArena arena;
+    return arena;
+  }
+
   void PrintSelf(std::ostream& os, itk::Indent indent) const { Superclass::PrintSelf(os, indent); }
   virtual ~ParticleNeighborhood(){};
 
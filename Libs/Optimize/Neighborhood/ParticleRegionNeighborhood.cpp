@@ -11,6 +11,17 @@ void ParticleRegionNeighborhood::SetDomain(DomainType::Pointer d) {
 ParticleRegionNeighborhood::PointVectorType ParticleRegionNeighborhood::FindNeighborhoodPoints(const PointType& center,
                                                                                                int idx,
                                                                                                double radius) const {
+  PointVectorType ret;
+  std::vector<double> distances;
+  this->FindNeighborhoodPoints(center, idx, ret, distances, radius);
+  return ret;
+}
+
+void ParticleRegionNeighborhood::FindNeighborhoodPoints(const PointType& center, int idx, PointVectorType& neighbors,
+                                                        std::vector<double>& distances, double radius) const {
+  neighbors.clear();
+  distances.clear();
+
   // Compute bounding box of the given hypersphere.
   PointType l, u;
   for (unsigned int i = 0; i < VDimension; i++) {
@@ -21,9 +32,9 @@ ParticleRegionNeighborhood::PointVectorType ParticleRegionNeighborhood::FindNeig
   // Grab the list of points in this bounding box.
   typename PointTreeType::PointIteratorListType pointlist = m_Tree->FindPointsInRegion(l, u);
 
-  // Allocate return vector.  Reserve ensures no extra copies occur.
-  PointVectorType ret;
-  ret.reserve(pointlist.size());
+  // Reserve ensures no extra copies occur.
+  neighbors.reserve(pointlist.size());
+  distances.reserve(pointlist.size());
 
   // Add any point whose distance from center is less than radius to the return
   // list.
@@ -31,11 +42,10 @@ ParticleRegionNeighborhood::PointVectorType ParticleRegionNeighborhood::FindNeig
        it++) {
     double distance = this->GetDomain()->Distance(center, idx, (*it)->Point, (*it)->Index);
     if (distance < radius && distance > 0) {
-      ret.push_back(**it);
+      neighbors.push_back(**it);
+      distances.push_back(distance);
     }
   }
-
-  return ret;
 }
 
 void ParticleRegionNeighborhood::AddPosition(const PointType& p, unsigned int idx, int) {
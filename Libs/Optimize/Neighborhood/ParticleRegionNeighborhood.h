@@ -47,6 +47,8 @@ class ParticleRegionNeighborhood : public ParticleNeighborhood {
       point.  This implementation uses a PowerOfTwoTree to sort points
       according to location. */
   virtual PointVectorType FindNeighborhoodPoints(const PointType&, int idx, double) const;
+  virtual void FindNeighborhoodPoints(const PointType&, int idx, PointVectorType& neighbors,
+                                      std::vector<double>& distances, double radius) const override;
   //  virtual unsigned int  FindNeighborhoodPoints(const PointType &, double, PointVectorType &) const;
 
   /** Override SetDomain so that we can grab the region extent info and
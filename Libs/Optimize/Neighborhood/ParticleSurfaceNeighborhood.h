@@ -51,6 +51,14 @@ class ParticleSurfaceNeighborhood : public ParticleRegionNeighborhood {
                                                  double) const override;
   virtual PointVectorType FindNeighborhoodPoints(const PointType&, int idx, std::vector<double>&,
                                                  double) const override;
+
+  /** Same as above, but writes the neighbors, weights and distances into
+      caller-provided buffers, which are cleared first.  Reusing the buffers
+      across calls avoids allocating on every query. */
+  virtual void FindNeighborhoodPoints(const PointType&, int idx, PointVectorType& neighbors,
+                                      std::vector<double>& weights, std::vector<double>& distances,
+                                      double radius) const override;
+
   //  virtual unsigned int  FindNeighborhoodPoints(const PointType &, double, PointVectorType &) const;
 
   void SetWeightingEnabled(bool is_enabled) { m_WeightingEnabled = is_enabled; }
@@ -67,12 +75,69 @@ class ParticleSurfaceNeighborhood : public ParticleRegionNeighborhood {
   ParticleSurfaceNeighborhood() : m_FlatCutoff(0.30) {}
   virtual ~ParticleSurfaceNeighborhood(){};
 
- private:
-  ParticleSurfaceNeighborhood(const Self&);  // purposely not implemented
-  void operator=(const Self&);               // purposely not implemented
+  /** Tests whether a candidate point lies within radius of center and, if so,
+      appends it along with its distance and cosine-falloff weight. */
+  inline void AddIfNeighbor(const ParticleDomain* domain, const PointType& center, int idx,
+                            const GradientVectorType& posnormal, const ParticlePointIndexPair& candidate,
+                            double radius, PointVectorType& neighbors, std::vector<double>& weights,
+                            std::vector<double>& distances) const;
+
   double m_FlatCutoff;
   bool m_WeightingEnabled{true};
   bool m_ForceEuclidean{false};
+
+ private:
+  ParticleSurfaceNeighborhood(const Self&);  // purposely not implemented
+  void operator=(const Self&);               // purposely not implemented
 };
 
+inline void ParticleSurfaceNeighborhood::AddIfNeighbor(const ParticleDomain* domain, const PointType& center, int idx,
+                                                       const GradientVectorType& posnormal,
+                                                       const ParticlePointIndexPair& candidate, double radius,
+                                                       PointVectorType& neighbors, std::vector<double>& weights,
+                                                       std::vector<double>& distances) const {
+  const auto& pt_b = candidate.Point;
+  const auto& idx_b = candidate.Index;
+
+  // we are not a neighbor of ourself.
+  if (idx_b == idx) {
+    return;
+  }
+
+  double distance;
+  bool is_within_distance;
+
+  if (m_ForceEuclidean) {
+    distance = center.EuclideanDistanceTo(pt_b);
+    is_within_distance = distance < radius;
+  } else {
+    is_within_distance = domain->IsWithinDistance(center, idx, pt_b, idx_b, radius, distance);
+  }
+
+  if (!is_within_distance) {
+    return;
+  }
+
+  neighbors.push_back(candidate);
+  distances.push_back(distance);
+
+  // todo change the APIs so don't have to pass a std::vector<double> of 1s whenever weighting is disabled
+  if (!m_WeightingEnabled) {
+    weights.push_back(1.0);
+    return;
+  }
+
+  const GradientVectorType pn = domain->SampleNormalAtPoint(pt_b, idx_b);
+  const double cosine = dot_product(posnormal, pn);  // normals already normalized
+  if (cosine >= m_FlatCutoff) {
+    weights.push_back(1.0);
+  } else {
+    // Drop to zero influence over 90 degrees.
+    weights.push_back(cos((m_FlatCutoff - cosine) / (1.0 + m_FlatCutoff) * 1.5708));
+
+    // More quickly drop to zero influence
+    // weights.push_back( exp((cosine - m_FlatCutoff) / (1.0 + m_FlatCutoff) * 4.0) );
+  }
+}
+
 }  // end namespace shapeworks
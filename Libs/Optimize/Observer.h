@@ -6,6 +6,8 @@
 
 namespace shapeworks {
 
+class ParticleSystem;
+
 /*!
  * @class Observer
  * @brief This class is an observer interface for classes to monitor for
@@ -37,7 +39,8 @@ class Observer : public itk::DataObject {
           NeighborhoodSetEvent(false),
           PositionSetEvent(false),
           PositionAddEvent(false),
-          PositionRemoveEvent(false) {}
+          PositionRemoveEvent(false),
+          BatchedPositionSetEvent(false) {}
     bool DomainAddEvent;
     bool TransformSetEvent;
     bool PrefixTransformSetEvent;
@@ -45,6 +48,8 @@ class Observer : public itk::DataObject {
     bool PositionSetEvent;
     bool PositionAddEvent;
     bool PositionRemoveEvent;
+    //! PositionSetCallback may be deferred until the ParticleSystem flushes its batched notifications
+    bool BatchedPositionSetEvent;
   };
 
   DefinedCallbacksStruct m_DefinedCallbacks;
@@ -58,10 +63,18 @@ class Observer : public itk::DataObject {
   virtual void TransformSetEventCallback(Object*, const itk::EventObject&) {}
   virtual void PrefixTransformSetEventCallback(Object*, const itk::EventObject&) {}
   virtual void NeighborhoodSetEventCallback(Object*, const itk::EventObject&) {}
-  virtual void PositionSetEventCallback(Object*, const itk::EventObject&) {}
   virtual void PositionAddEventCallback(Object*, const itk::EventObject&) {}
   virtual void PositionRemoveEventCallback(Object*, const itk::EventObject&) {}
 
+  /** Called when particle idx of domain d is set.  Positions are set from many
+      threads in the gradient loop, so rather than going through an ITK event
+      (an event object, a walk of the observer list and a dynamic_cast per
+      observer), the ParticleSystem calls this directly on the observers that
+      set PositionSetEvent.  Observers that set BatchedPositionSetEvent instead
+      are only told about the particles that changed when the ParticleSystem
+      flushes its batched notifications, at most once per particle. */
+  virtual void PositionSetCallback(const ParticleSystem*, unsigned int d, unsigned int idx) {}
+
  protected:
   Observer() {}
   virtual ~Observer(){};
@@ -29,6 +29,7 @@
 #include <Libs/Particles/ParticleFile.h>
 
 #include "Libs/Optimize/Domain/VtkMeshWrapper.h"
+#include "Libs/Optimize/Utils/NearestNeighborStatistics.h"
 #include "Libs/Optimize/Utils/ObjectReader.h"
 #include "Libs/Optimize/Utils/ObjectWriter.h"
 #include "Libs/Optimize/Utils/ParticleGoodBadAssessment.h"
@@ -130,52 +131,64 @@ bool Optimize::Run() {
     }
   }
 
-  // Initialize
-  if (m_processing_mode >= 0) {
-    Initialize();
-  }
-  // Introduce adaptivity
-  if (m_processing_mode >= 1 || m_processing_mode == -1) {
-    AddAdaptivity();
+  if (!m_resume_directory.empty() && !LoadResumeState()) {
+    return false;
   }
-  // Optimize
-  if (m_processing_mode >= 2 || m_processing_mode == -2) {
-    RunOptimize();
+  // a multiscale run resumed after its first round continues in the loop below
+  const bool resume_in_round = m_resume_state && m_resume_state->multiscale_round;
+
+  if (!resume_in_round) {
+    // Initialize
+    if (m_processing_mode >= 0 && !SkipPhase(OptimizerState::Phase::Initialize)) {
+      Initialize();
+    }
+    // Introduce adaptivity
+    if ((m_processing_mode >= 1 || m_processing_mode == -1) && !SkipPhase(OptimizerState::Phase::Adaptivity)) {
+      AddAdaptivity();
+    }
+    // Optimize
+    if (m_processing_mode >= 2 || m_processing_mode == -2) {
+      RunOptimize();
+    }
   }
 
   if (this->m_use_shape_statistics_after > 0) {
     // First phase is done now run iteratively until we reach the final particle counts
 
-    // save the particles for this split if requested
-    if (m_save_init_splits == true) {
-      WriteSplitFiles("pts_w_opt");
-    }
+    if (!resume_in_round) {
+      // save the particles for this split if requested
+      if (m_save_init_splits == true) {
+        WriteSplitFiles("pts_w_opt");
+      }
 
-    // set to use shape statistics now for the Initialize mode
-    m_use_shape_statistics_in_init = true;
+      // set to use shape statistics now for the Initialize mode
+      m_use_shape_statistics_in_init = true;
 
-    // reset the number of iterations completed
-    m_optimization_iterations_completed = 0;
+      // reset the number of iterations completed
+      m_optimization_iterations_completed = 0;
+    }
 
     bool finished = false;
 
     while (!finished) {
       m_sampler->ReInitialize();
 
-      // determine if we have reached the final particle counts
-      finished = true;
-      for (int i = 0; i < m_number_of_particles.size(); i++) {
-        if (m_number_of_particles[i] < final_number_of_particles[i]) {
-          m_number_of_particles[i] *= 2;
-          finished = false;
+      // determine if we have reached the final particle counts (a resumed round already has its counts)
+      if (!m_resume_state) {
+        finished = true;
+        for (int i = 0; i < m_number_of_particles.size(); i++) {
+          if (m_number_of_particles[i] < final_number_of_particles[i]) {
+            m_number_of_particles[i] *= 2;
+            finished = false;
+          }
         }
       }
 
       if (!finished) {
-        if (m_processing_mode >= 0) {
+        if (m_processing_mode >= 0 && !SkipPhase(OptimizerState::Phase::Initialize)) {
           Initialize();
         }
-        if (m_processing_mode >= 1 || m_processing_mode == -1) {
+        if ((m_processing_mode >= 1 || m_processing_mode == -1) && !SkipPhase(OptimizerState::Phase::Adaptivity)) {
           AddAdaptivity();
         }
         if (m_processing_mode >= 2 || m_processing_mode == -2) {
@@ -185,6 +198,9 @@ bool Optimize::Run() {
     }
   }
 
+  // the run is only complete once its last checkpoint is on disk
+  FlushCheckpoints();
+
   UpdateExportablePoints();
 
   if (m_python_filename != "") {
@@ -498,14 +514,10 @@ void Optimize::InitializeSampler() {
 
 //---------------------------------------------------------------------------
 double Optimize::GetMinNeighborhoodRadius() {
+  // the smallest radius within which every particle of every domain has a neighbor
   double rad = 0.0;
-  typename itk::ImageToVTKImageFilter<ImageType>::Pointer itk2vtkConnector;
-  for (unsigned int i = 0; i < m_sampler->GetParticleSystem()->GetNumberOfDomains(); i++) {
-    double area = m_sampler->GetParticleSystem()->GetDomain(i)->GetSurfaceArea();
-    double sigma = std::sqrt(area / (m_sampler->GetParticleSystem()->GetNumberOfParticles(i) * M_PI));
-    if (rad < sigma) {
-      rad = sigma;
-    }
+  for (const auto& stats : NearestNeighborStatistics::ComputeForDomains(*m_sampler->GetParticleSystem())) {
+    rad = std::max(rad, stats.max);
   }
   return rad;
 }
@@ -536,8 +548,10 @@ void Optimize::Initialize() {
     SW_LOG("*** Initialize Step ***");
     SW_LOG("------------------------------");
   }
+  m_phase = OptimizerState::Phase::Initialize;
 
-  if (m_procrustes_interval != 0) {  // Initial registration
+  // a resumed run restored the transforms of its registrations
+  if (m_procrustes_interval != 0 && !m_resume_state) {  // Initial registration
     for (int i = 0; i < this->m_domains_per_shape; i++) {
       if (m_sampler->GetParticleSystem()->GetNumberOfParticles(i) > 10) {
         m_procrustes->RunRegistration(i);
@@ -613,7 +627,8 @@ void Optimize::Initialize() {
   */
 
   double epsilon = this->m_spacing;
-  bool flag_split = false;
+  // a run resumed during initialization continues the split it was checkpointed in
+  bool flag_split = m_resume_state != nullptr;
 
   for (int i = 0; i < n; i++) {
     int d = i % m_domains_per_shape;
@@ -650,14 +665,17 @@ void Optimize::Initialize() {
     //      go in a random direction with magnitude epsilon/5. Then the shifted particles
     //      in each domain are tested so that no particle will violate any inequality constraints
     //      after its split.
-    for (int i = 0; i < m_domains_per_shape; i++) {
-      if (m_sampler->GetParticleSystem()->GetNumberOfParticles(i) < m_number_of_particles[i]) {
-        m_sampler->GetParticleSystem()->AdvancedAllParticleSplitting(epsilon, m_domains_per_shape, i);
+    const bool resuming_split = m_resume_state != nullptr;
+    if (!resuming_split) {
+      for (int i = 0; i < m_domains_per_shape; i++) {
+        if (m_sampler->GetParticleSystem()->GetNumberOfParticles(i) < m_number_of_particles[i]) {
+          m_sampler->GetParticleSystem()->AdvancedAllParticleSplitting(epsilon, m_domains_per_shape, i);
+        }
       }
-    }
-    m_sampler->GetParticleSystem()->SynchronizePositions();
+      m_sampler->GetParticleSystem()->SynchronizePositions();
 
-    this->m_split_number++;
+      this->m_split_number++;
+    }
 
     if (m_verbosity_level > 0) {
       std::cout << "split number = " << this->m_split_number << std::endl;
@@ -669,7 +687,7 @@ void Optimize::Initialize() {
       std::cout << std::endl;
     }
 
-    if (m_save_init_splits == true) {
+    if (m_save_init_splits == true && !resuming_split) {
       WriteSplitFiles("pts_wo_init");
     }
 
@@ -696,6 +714,7 @@ void Optimize::Initialize() {
         m_sampler->GetParticleSystem()->GetNumberOfParticles(0) >= particles_before_adaptive_initialization) {
       m_sampler->GetOptimizer()->SetInitializationMode(true);
     }
+    this->RestoreOptimizerState();
     m_sampler->Execute();
     m_sampler->GetOptimizer()->SetInitializationMode(false);
 
@@ -738,6 +757,7 @@ void Optimize::AddAdaptivity() {
   if (m_adaptivity_strength == 0.0) {
     return;
   }
+  m_phase = OptimizerState::Phase::Adaptivity;
 
   double minRad = 3.0 * this->GetMinNeighborhoodRadius();
 
@@ -747,6 +767,7 @@ void Optimize::AddAdaptivity() {
 
   m_sampler->GetOptimizer()->SetMaximumNumberOfIterations(m_iterations_per_split);
   m_sampler->GetOptimizer()->SetNumberOfIterations(0);
+  this->RestoreOptimizerState();
   m_sampler->Execute();
 
   this->WritePointFiles();
@@ -769,11 +790,12 @@ void Optimize::RunOptimize() {
   }
 
   m_optimizing = true;
+  m_phase = OptimizerState::Phase::Optimize;
   m_sampler->GetCurvatureGradientFunction()->SetRho(m_adaptivity_strength);
   m_sampler->GetLinkingFunction()->SetRelativeGradientScaling(m_relative_weighting);
   m_sampler->GetLinkingFunction()->SetRelativeEnergyScaling(m_relative_weighting);
 
-  if (m_procrustes_interval != 0) {  // Initial registration
+  if (m_procrustes_interval != 0 && !m_resume_state) {  // Initial registration
     m_procrustes->RunRegistration();
     this->WritePointFiles();
     this->WriteTransformFile();
@@ -854,6 +876,7 @@ void Optimize::RunOptimize() {
 
   m_sampler->GetOptimizer()->SetNumberOfIterations(0);
   m_sampler->GetOptimizer()->SetTolerance(0.0);
+  this->RestoreOptimizerState();
   m_sampler->Execute();
 
   this->WritePointFiles();
@@ -865,6 +888,7 @@ void Optimize::RunOptimize() {
   this->WriteCuttingPlanePoints();
   this->WriteParameters();
   if (m_verbosity_level > 0) {
+    this->PrintGeodesicCacheStats();
     std::cout << "Finished optimization!!!" << std::endl;
   }
 }
@@ -939,22 +963,7 @@ void Optimize::IterateCallback(itk::Object*, const itk::EventObject&) {
     m_checkpoint_counter++;
     if (m_checkpoint_counter == (int)m_checkpointing_interval) {
       m_checkpoint_counter = 0;
-
-      this->WritePointFiles();
-      this->WriteTransformFile();
-      this->WriteTransformFiles();
-      this->WritePointFilesWithFeatures();
-      this->WriteModes();
-      this->WriteParameters();
-      this->WriteEnergyFiles();
-
-      if (m_keep_checkpoints) {
-        this->WritePointFiles(this->GetCheckpointDir());
-        this->WritePointFilesWithFeatures(this->GetCheckpointDir());
-        this->WriteTransformFile(this->GetCheckpointDir() + "/transform");
-        this->WriteTransformFiles(this->GetCheckpointDir());
-        this->WriteParameters(this->GetCheckpointDir());
-      }
+      this->WriteCheckpoint();
     }
   }
   UpdateProgress();
@@ -969,25 +978,17 @@ void Optimize::ComputeEnergyAfterIteration() {
   if (!this->m_log_energy) {
     return;
   }
-  int numShapes = m_sampler->GetParticleSystem()->GetNumberOfDomains();
-  double corrEnergy = 0.0;
-
-  double sampEnergy = 0.0;
-  for (int i = 0; i < numShapes; i++) {
-    m_sampler->GetLinkingFunction()->SetDomainNumber(i);
-    for (int j = 0; j < m_sampler->GetParticleSystem()->GetNumberOfParticles(i); j++) {
-      if (m_sampler->GetParticleSystem()->GetDomainFlag(i)) {
-        sampEnergy += 0.0;
-      } else {
-        sampEnergy += m_sampler->GetLinkingFunction()->EnergyA(j, i, m_sampler->GetParticleSystem());
-      }
-      if (m_sampler->GetCorrespondenceMode() == shapeworks::CorrespondenceMode::MeanEnergy) {
-        corrEnergy += m_sampler->GetLinkingFunction()->EnergyB(j, i, m_sampler->GetParticleSystem());
-      }
-    }
-  }
+  // the optimizer sums the energy terms of every particle as it updates it, so no extra pass is needed here
+  const auto& energies = m_sampler->GetOptimizer()->GetDomainEnergies();
+  m_domain_energy_a = energies.a;
+  m_domain_energy_b = energies.b;
 
-  if (m_sampler->GetCorrespondenceMode() != shapeworks::CorrespondenceMode::MeanEnergy) {
+  const double sampEnergy = std::accumulate(energies.a.begin(), energies.a.end(), 0.0);
+  double corrEnergy = 0.0;
+  if (m_sampler->GetCorrespondenceMode() == shapeworks::CorrespondenceMode::MeanEnergy) {
+    corrEnergy = std::accumulate(energies.b.begin(), energies.b.end(), 0.0);
+  } else {
+    // ensemble energies are a property of the whole shape model
     corrEnergy = m_sampler->GetLinkingFunction()->EnergyB(0, 0, m_sampler->GetParticleSystem());
   }
 
@@ -1157,18 +1158,12 @@ void Optimize::WriteTransformFile(std::string iter_prefix) const {
 
   std::string output_file = iter_prefix;
 
-  std::vector<ParticleSystem::TransformType> tlist;
-
-  for (unsigned int i = 0; i < m_sampler->GetParticleSystem()->GetNumberOfDomains(); i++) {
-    tlist.push_back(m_sampler->GetParticleSystem()->GetTransform(i));
-  }
+  // a queued checkpoint may still be writing the same file
+  FlushCheckpoints();
 
   std::string str = "writing " + output_file + " ...";
   PrintStartMessage(str);
-  ObjectWriter<ParticleSystem::TransformType> writer;
-  writer.SetFileName(output_file);
-  writer.SetInput(tlist);
-  writer.Update();
+  CheckpointWriter::WriteTransformFile(*SnapshotParticleSystem(false, false), output_file);
   PrintDoneMessage();
 }
 
@@ -1195,36 +1190,10 @@ void Optimize::WriteTransformFiles(std::string iter_prefix) const {
     return;
   }
 
-  this->PrintStartMessage("Writing transform files...\n");
-
-  const int n = m_sampler->GetParticleSystem()->GetNumberOfDomains();
-
-  int counter;
-  for (int i = 0; i < n; i++) {
-    counter = 0;
-
-    std::string transform_file = iter_prefix + "/" + m_filenames[i] + ".transform";
-
-    std::ofstream out(transform_file.c_str());
-
-    std::string str = "Writing " + transform_file + "...";
-    this->PrintStartMessage(str, 1);
-    if (!out) {
-      std::cerr << "Error opening output file: " << transform_file << std::endl;
-      throw 1;
-    }
-
-    auto transform = m_sampler->GetParticleSystem()->GetTransform(i);
-
-    for (int i = 0; i < transform.cols(); i++) {
-      for (int j = 0; j < transform.rows(); j++) {
-        out << transform(i, j) << " ";
-      }
-    }
-    out << std::endl;
+  FlushCheckpoints();
 
-    out.close();
-  }
+  this->PrintStartMessage("Writing transform files...\n");
+  CheckpointWriter::WriteTransformFiles(*SnapshotParticleSystem(false, false), iter_prefix);
   this->PrintDoneMessage();
 }
 
@@ -1260,45 +1229,8 @@ void Optimize::WritePointFiles(std::string iter_prefix) {
   mkdir(iter_prefix.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
 #endif
 
-  const int n = m_sampler->GetParticleSystem()->GetNumberOfDomains();
-
-  int counter;
-  for (int i = 0; i < n; i++) {
-    counter = 0;
-
-    std::string local_file = iter_prefix + "/" + m_filenames[i] + "_local." + particle_format_;
-    std::string world_file = iter_prefix + "/" + m_filenames[i] + "_world." + particle_format_;
-
-    std::string str = "Writing " + world_file + " and " + local_file + " files...";
-    this->PrintStartMessage(str, 1);
-
-    auto ps = m_sampler->GetParticleSystem();
-
-    Eigen::VectorXd local_particles;
-    Eigen::VectorXd world_particles;
-    int idx = 0;
-    local_particles.resize(ps->GetNumberOfParticles(i) * 3);
-    world_particles.resize(ps->GetNumberOfParticles(i) * 3);
-
-    for (unsigned int j = 0; j < ps->GetNumberOfParticles(i); j++) {
-      auto pos = ps->GetPosition(j, i);
-      for (unsigned int k = 0; k < 3; k++) {
-        local_particles(idx) = pos[k];
-        world_particles(idx) = ps->GetTransformedPosition(j, i)[k];
-        idx++;
-      }
-    }
-
-    particles::write_particles(local_file, local_particles);
-    particles::write_particles(world_file, world_particles);
-
-    std::stringstream st;
-    st << counter;
-    str = "with " + st.str() + "points...";
-    this->PrintStartMessage(str, 1);
-    this->PrintDoneMessage(1);
-
-  }  // end for files
+  FlushCheckpoints();
+  CheckpointWriter::WritePointFiles(*SnapshotParticleSystem(true, false), iter_prefix, particle_format_);
   this->PrintDoneMessage();
 }
 
@@ -1330,88 +1262,315 @@ void Optimize::WritePointFilesWithFeatures(std::string iter_prefix) {
     return;
   }
 
+  FlushCheckpoints();
+
   this->PrintStartMessage("Writing point with attributes files...\n");
+  CheckpointWriter::WriteFeatureFiles(*SnapshotParticleSystem(false, true), iter_prefix);
+  this->PrintDoneMessage();
+}
+
+//---------------------------------------------------------------------------
+std::shared_ptr<CheckpointWriter::Snapshot> Optimize::SnapshotParticleSystem(bool points, bool features) const {
   typedef Sampler::PointType PointType;
-  const int n = m_sampler->GetParticleSystem()->GetNumberOfDomains();
+  auto ps = m_sampler->GetParticleSystem();
+  const int n = ps->GetNumberOfDomains();
 
-  int counter;
+  auto snapshot = std::make_shared<CheckpointWriter::Snapshot>();
+  snapshot->names.assign(m_filenames.begin(), m_filenames.begin() + n);
   for (int i = 0; i < n; i++) {
-    counter = 0;
+    snapshot->transforms.push_back(ps->GetTransform(i));
+  }
 
-    std::string world_file = iter_prefix + "/" + m_filenames[i] + "_wptsFeatures.particles";
+  if (points) {
+    snapshot->local.resize(n);
+    snapshot->world.resize(n);
+    for (int i = 0; i < n; i++) {
+      auto& local_particles = snapshot->local[i];
+      auto& world_particles = snapshot->world[i];
+      local_particles.resize(ps->GetNumberOfParticles(i) * 3);
+      world_particles.resize(ps->GetNumberOfParticles(i) * 3);
+      for (unsigned int j = 0; j < ps->GetNumberOfParticles(i); j++) {
+        PointType pos = ps->GetPosition(j, i);
+        PointType wpos = ps->GetTransformedPosition(j, i);
+        for (unsigned int k = 0; k < 3; k++) {
+          local_particles(j * 3 + k) = pos[k];
+          world_particles(j * 3 + k) = wpos[k];
+        }
+      }
+    }
+  }
 
-    std::ofstream outw(world_file.c_str());
+  if (features) {
+    // TODO: mesh based attribute values (m_attributes_per_domain) need a rewrite and are not written
+    snapshot->features.resize(n);
+    for (int i = 0; i < n; i++) {
+      const bool use_normals = m_use_normals[i % m_domains_per_shape];
+      auto& values = snapshot->features[i];
+      values.resize(ps->GetNumberOfParticles(i), use_normals ? 6 : 3);
+      for (unsigned int j = 0; j < ps->GetNumberOfParticles(i); j++) {
+        PointType pos = ps->GetPosition(j, i);
+        PointType wpos = ps->GetTransformedPosition(j, i);
+        for (unsigned int k = 0; k < 3; k++) {
+          values(j, k) = wpos[k];
+        }
 
-    std::string str = "Writing " + world_file + "...";
-    int attrNum = 3 * int(m_use_xyz[i % m_domains_per_shape]) + 3 * int(m_use_normals[i % m_domains_per_shape]);
-    if (m_attributes_per_domain.size() > 0) {
-      attrNum += m_attributes_per_domain[i % m_domains_per_shape];
+        if (use_normals) {
+          vnl_vector_fixed<float, DIMENSION> pG = ps->GetDomain(i)->SampleNormalAtPoint(pos, j);
+          VectorType pN;
+          pN[0] = pG[0];
+          pN[1] = pG[1];
+          pN[2] = pG[2];
+          pN = ps->TransformVector(pN, ps->GetTransform(i) * ps->GetPrefixTransform(i));
+          for (unsigned int k = 0; k < 3; k++) {
+            values(j, 3 + k) = pN[k];
+          }
+        }
+      }
     }
-    std::stringstream st;
-    st << attrNum;
-    str += "with " + st.str() + " attributes per point...";
-    this->PrintStartMessage(str, 1);
+  }
 
-    if (!outw) {
-      std::cerr << "Error opening output file: " << world_file << std::endl;
-      throw 1;
-    }
+  return snapshot;
+}
+
+//---------------------------------------------------------------------------
+void Optimize::WriteCheckpoint() {
+  if (!this->m_file_output_enabled) {
+    return;
+  }
+
+  if (!m_checkpoint_writer) {
+    m_checkpoint_writer = std::make_unique<CheckpointWriter>();
+  }
 
-    std::vector<float> fVals;
+  // the particle system is copied here, the files are written while the optimization continues
+  auto snapshot = SnapshotParticleSystem(true, m_mesh_based_attributes);
+  snapshot->state = CaptureOptimizerState();
 
-    for (unsigned int j = 0; j < m_sampler->GetParticleSystem()->GetNumberOfParticles(i); j++) {
-      PointType pos = m_sampler->GetParticleSystem()->GetPosition(j, i);
-      PointType wpos = m_sampler->GetParticleSystem()->GetTransformedPosition(j, i);
+  CheckpointWriter::Target output;
+  output.directory = m_output_dir;
+  output.transform_file = m_output_transform_file;
+  output.particle_format = particle_format_;
+  output.transform_files = m_output_transform_files;
+  output.features = m_mesh_based_attributes;
+  std::vector<CheckpointWriter::Target> targets{output};
 
+  std::string checkpoint_dir;
+  if (m_keep_checkpoints) {
+    checkpoint_dir = GetCheckpointDir();
+    CheckpointWriter::Target checkpoint = output;
+    checkpoint.directory = checkpoint_dir;
+    checkpoint.transform_file = "transform";
+    checkpoint.packed = m_packed_checkpoints;
+    checkpoint.atomic_directory = true;
+    targets.push_back(checkpoint);
+  }
+
+  m_checkpoint_writer->Enqueue(std::move(snapshot), std::move(targets));
+
+  // these are small (or only written when requested), so they are written right away
+  this->WriteModes();
+  this->WriteParameters();
+  this->WriteEnergyFiles();
+  if (m_keep_checkpoints) {
+    this->WriteParameters(checkpoint_dir);
+  }
+}
+
+//---------------------------------------------------------------------------
+void Optimize::FlushCheckpoints() const {
+  if (m_checkpoint_writer) {
+    m_checkpoint_writer->Flush();
+  }
+}
+
+//---------------------------------------------------------------------------
+std::shared_ptr<OptimizerState> Optimize::CaptureOptimizerState() const {
+  auto ps = m_sampler->GetParticleSystem();
+  auto optimizer = m_sampler->GetOptimizer();
+
+  auto state = std::make_shared<OptimizerState>();
+  state->phase = m_phase;
+  state->multiscale_round = m_use_shape_statistics_after > 0 && m_use_shape_statistics_in_init;
+  state->number_of_particles = m_number_of_particles;
+  state->split_number = m_split_number;
+  state->iteration_count = m_iteration_count;
+  state->optimization_iterations_completed = m_optimization_iterations_completed;
+  state->optimizer_iterations = optimizer->GetNumberOfIterations();
+  state->procrustes_counter = m_procrustes_counter;
+  state->checkpoint_counter = m_checkpoint_counter;
+  state->particle_iterations = current_particle_iterations_;
+  state->random_state = ps->GetRandomState();
+  state->minimum_variances = {m_sampler->GetEnsembleEntropyFunction()->GetMinimumVariance(),
+                              m_sampler->GetDisentangledEnsembleEntropyFunction()->GetMinimumVariance(),
+                              m_sampler->GetMeshBasedGeneralEntropyGradientFunction()->GetMinimumVariance(),
+                              m_sampler->GetEnsembleRegressionEntropyFunction()->GetMinimumVariance(),
+                              m_sampler->GetEnsembleMixedEffectsEntropyFunction()->GetMinimumVariance()};
+  state->energy_name = m_str_energy;
+  state->energy_a = m_energy_a;
+  state->energy_b = m_energy_b;
+  state->total_energy = m_total_energy;
+
+  const auto& time_steps = optimizer->GetTimeSteps();
+  auto sigmas = m_sampler->GetGradientFunction()->GetSpatialSigmaCache();
+
+  state->domains.resize(ps->GetNumberOfDomains());
+  for (unsigned int i = 0; i < ps->GetNumberOfDomains(); i++) {
+    auto& domain = state->domains[i];
+    domain.positions.resize(ps->GetNumberOfParticles(i) * 3);
+    for (unsigned int j = 0; j < ps->GetNumberOfParticles(i); j++) {
+      auto pos = ps->GetPosition(j, i);
       for (unsigned int k = 0; k < 3; k++) {
-        outw << wpos[k] << " ";
+        domain.positions(j * 3 + k) = pos[k];
+      }
+    }
+    domain.transform = ps->GetTransform(i);
+    if (i < time_steps.size()) {
+      domain.time_steps = time_steps[i];
+    }
+    if (i < sigmas->size()) {
+      const auto& cache = sigmas->operator[](i);
+      for (unsigned int j = 0; j < cache->GetSize(); j++) {
+        domain.sigmas.push_back(cache->operator[](j));
       }
+    }
 
-      if (m_use_normals[i % m_domains_per_shape]) {
-        vnl_vector_fixed<float, DIMENSION> pG =
-            m_sampler->GetParticleSystem()->GetDomain(i)->SampleNormalAtPoint(pos, j);
-        VectorType pN;
-        pN[0] = pG[0];
-        pN[1] = pG[1];
-        pN[2] = pG[2];
-        pN = m_sampler->GetParticleSystem()->TransformVector(
-            pN,
-            m_sampler->GetParticleSystem()->GetTransform(i) * m_sampler->GetParticleSystem()->GetPrefixTransform(i));
-        outw << pN[0] << " " << pN[1] << " " << pN[2] << " ";
+    auto constraints = ps->GetDomain(i)->GetConstraints();
+    domain.constraint_mus = constraints->GetLagrangianParameters();
+    for (auto& plane : constraints->getPlaneConstraints()) {
+      const Eigen::Vector3d normal = plane.getPlaneNormal();
+      const Eigen::Vector3d point = plane.getPlanePoint();
+      domain.planes.insert(domain.planes.end(), normal.data(), normal.data() + 3);
+      domain.planes.insert(domain.planes.end(), point.data(), point.data() + 3);
+    }
+  }
+  return state;
+}
+
+//---------------------------------------------------------------------------
+bool Optimize::LoadResumeState() {
+  const std::string filename = OptimizerState::FindLatest(m_resume_directory);
+  if (filename.empty()) {
+    SW_ERROR("No optimizer state ({}) found in {}", OptimizerState::FILENAME, m_resume_directory);
+    return false;
+  }
+
+  OptimizerState state;
+  try {
+    state = OptimizerState::Read(filename);
+  } catch (std::exception& e) {
+    SW_ERROR("Unable to resume: {}", e.what());
+    return false;
+  }
+
+  auto ps = m_sampler->GetParticleSystem();
+  if (state.domains.size() != ps->GetNumberOfDomains()) {
+    SW_ERROR("Unable to resume: {} has {} domains, the project has {}", filename, state.domains.size(),
+             ps->GetNumberOfDomains());
+    return false;
+  }
+
+  for (unsigned int i = 0; i < ps->GetNumberOfDomains(); i++) {
+    const auto& domain = state.domains[i];
+    const size_t count = domain.positions.size() / 3;
+    if (ps->GetNumberOfParticles(i) != 0 && ps->GetNumberOfParticles(i) != count) {
+      SW_ERROR("Unable to resume: domain {} has {} particles in {}, but starts with {}", i, count, filename,
+               ps->GetNumberOfParticles(i));
+      return false;
+    }
+  }
+
+  SW_LOG("Resuming from {}", filename);
+
+  for (unsigned int i = 0; i < ps->GetNumberOfDomains(); i++) {
+    const auto& domain = state.domains[i];
+    ps->SetTransform(i, domain.transform);
+
+    std::vector<ParticleSystem::PointType> points(domain.positions.size() / 3);
+    for (size_t j = 0; j < points.size(); j++) {
+      for (unsigned int k = 0; k < 3; k++) {
+        points[j][k] = domain.positions(j * 3 + k);
+      }
+    }
+    if (ps->GetNumberOfParticles(i) == 0) {
+      ps->AddPositionList(points, i);
+    } else {
+      for (size_t j = 0; j < points.size(); j++) {
+        ps->SetPosition(points[j], j, i);
       }
+    }
 
-      // TODO: Needs rewrite:
-      /*
-      // Only run the following code if we are dealing with ImplicitSurfaceDomains
-      const ImplicitSurfaceDomain<float>* domain =
-          dynamic_cast<const ImplicitSurfaceDomain<float>*>(m_sampler->GetParticleSystem()->GetDomain(i));
-      if (domain && m_attributes_per_domain.size() > 0) {
-        if (m_attributes_per_domain[i % m_domains_per_shape] > 0) {
-          point pt;
-          pt.clear();
-          pt[0] = pos[0];
-          pt[1] = pos[1];
-          pt[2] = pos[2];
-          fVals.clear();
-          if (m_mesh_based_attributes) {
-            domain->GetMesh()->GetFeatureValues(pt, fVals);
-          }
-          for (unsigned int k = 0; k < m_attributes_per_domain[i % m_domains_per_shape]; k++) {
-            outw << fVals[k] << " ";
-          }
-        }
+    // cutting planes follow the shapes through each Procrustes registration
+    auto& planes = ps->GetDomain(i)->GetConstraints()->getPlaneConstraints();
+    for (size_t p = 0; p < planes.size() && p * 6 + 6 <= domain.planes.size(); p++) {
+      const double* plane = &domain.planes[p * 6];
+      planes[p].setPlaneNormal(Eigen::Vector3d(plane[0], plane[1], plane[2]));
+      planes[p].setPlanePoint(Eigen::Vector3d(plane[3], plane[4], plane[5]));
+    }
+  }
+  ps->SynchronizePositions();
+  ps->SetRandomState(state.random_state);
+
+  if (!state.number_of_particles.empty()) {
+    m_number_of_particles = state.number_of_particles;
+  }
+  m_use_shape_statistics_in_init = m_use_shape_statistics_in_init || state.multiscale_round;
+  // the optimize step of a multiscale run's first round has already set this
+  m_optimizing = state.phase == OptimizerState::Phase::Optimize || state.multiscale_round;
+  m_split_number = state.split_number;
+  m_iteration_count = state.iteration_count;
+  m_optimization_iterations_completed = state.optimization_iterations_completed;
+  m_procrustes_counter = state.procrustes_counter;
+  m_checkpoint_counter = state.checkpoint_counter;
+  current_particle_iterations_ = state.particle_iterations;
+
+  m_resume_state = std::make_unique<OptimizerState>(std::move(state));
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void Optimize::RestoreOptimizerState() {
+  if (!m_resume_state) {
+    return;
+  }
+  const auto& state = *m_resume_state;
+  auto ps = m_sampler->GetParticleSystem();
+
+  // the per-particle state is restored last, as setting up a phase resets it
+  std::vector<std::vector<double>> time_steps;
+  auto sigmas = m_sampler->GetGradientFunction()->GetSpatialSigmaCache();
+  for (unsigned int i = 0; i < ps->GetNumberOfDomains(); i++) {
+    const auto& domain = state.domains[i];
+    time_steps.push_back(domain.time_steps);
+    if (i < sigmas->size()) {
+      auto& cache = sigmas->operator[](i);
+      for (unsigned int j = 0; j < cache->GetSize() && j < domain.sigmas.size(); j++) {
+        cache->operator[](j) = domain.sigmas[j];
       }
-      */
+    }
+    ps->GetDomain(i)->GetConstraints()->SetLagrangianParameters(domain.constraint_mus);
+  }
+  m_sampler->GetOptimizer()->SetTimeSteps(time_steps);
+  m_sampler->GetOptimizer()->SetNumberOfIterations(state.optimizer_iterations);
 
-      outw << std::endl;
+  if (state.minimum_variances.size() == 5) {
+    m_sampler->GetEnsembleEntropyFunction()->SetMinimumVariance(state.minimum_variances[0]);
+    m_sampler->GetDisentangledEnsembleEntropyFunction()->SetMinimumVariance(state.minimum_variances[1]);
+    m_sampler->GetMeshBasedGeneralEntropyGradientFunction()->SetMinimumVariance(state.minimum_variances[2]);
+    m_sampler->GetEnsembleRegressionEntropyFunction()->SetMinimumVariance(state.minimum_variances[3]);
+    m_sampler->GetEnsembleMixedEffectsEntropyFunction()->SetMinimumVariance(state.minimum_variances[4]);
+  }
 
-      counter++;
-    }  // end for points
+  m_str_energy = state.energy_name;
+  m_energy_a = state.energy_a;
+  m_energy_b = state.energy_b;
+  m_total_energy = state.total_energy;
 
-    outw.close();
-    this->PrintDoneMessage(1);
-  }  // end for files
-  this->PrintDoneMessage();
+  m_resume_state.reset();
+}
+
+//---------------------------------------------------------------------------
+bool Optimize::SkipPhase(OptimizerState::Phase phase) const {
+  return m_resume_state && phase < m_resume_state->phase;
 }
 
 //---------------------------------------------------------------------------
@@ -1465,6 +1624,25 @@ void Optimize::WriteEnergyFiles() {
   outTotal.close();
   this->PrintDoneMessage(1);
 
+  // per-domain breakdown, one line per logged iteration with one column per domain
+  auto append_domain_energies = [&](const std::string& filename, const std::vector<double>& energies) {
+    std::ofstream out(filename.c_str(), std::ofstream::app);
+    if (!out) {
+      std::cerr << "Error opening output energy file: " << filename << std::endl;
+      throw 1;
+    }
+    for (size_t d = 0; d < energies.size(); d++) {
+      out << (d > 0 ? " " : "") << energies[d];
+    }
+    out << std::endl;
+  };
+  if (!m_domain_energy_a.empty()) {
+    append_domain_energies(m_output_dir + "/" + this->m_str_energy + "_samplingEnergyPerDomain.txt",
+                           m_domain_energy_a);
+    append_domain_energies(m_output_dir + "/" + this->m_str_energy + "_correspondenceEnergyPerDomain.txt",
+                           m_domain_energy_b);
+  }
+
   this->PrintDoneMessage();
 }
 
@@ -1841,6 +2019,12 @@ void Optimize::SetCheckpointingInterval(int checkpointing_interval) {
 //---------------------------------------------------------------------------
 void Optimize::SetKeepCheckpoints(int keep_checkpoints) { this->m_keep_checkpoints = keep_checkpoints; }
 
+//---------------------------------------------------------------------------
+void Optimize::SetPackedCheckpoints(bool packed_checkpoints) { this->m_packed_checkpoints = packed_checkpoints; }
+
+//---------------------------------------------------------------------------
+void Optimize::SetResumeDirectory(std::string resume_directory) { this->m_resume_directory = resume_directory; }
+
 //---------------------------------------------------------------------------
 void Optimize::SetUseRegression(bool use_regression) { this->m_use_regression = use_regression; }
 
@@ -1880,7 +2064,9 @@ void Optimize::AddMesh(vtkSmartPointer<vtkPolyData> poly_data) {
     m_sampler->AddMesh(nullptr);
   } else {
     const auto mesh =
-        std::make_shared<shapeworks::VtkMeshWrapper>(poly_data, m_geodesics_enabled, m_geodesic_cache_size_multiplier);
+        std::make_shared<shapeworks::VtkMeshWrapper>(poly_data, m_geodesics_enabled, m_geodesic_cache_size_multiplier,
+                                                     m_geodesic_cache_directory, m_geodesic_cache_file_size);
+    m_mesh_wrappers.push_back(mesh);
     m_sampler->AddMesh(mesh);
   }
   this->m_num_shapes++;
@@ -2085,6 +2271,29 @@ void Optimize::SetGeodesicsEnabled(bool is_enabled) { this->m_geodesics_enabled
 //---------------------------------------------------------------------------
 void Optimize::SetGeodesicsCacheSizeMultiplier(size_t n) { this->m_geodesic_cache_size_multiplier = n; }
 
+//---------------------------------------------------------------------------
+void Optimize::SetGeodesicsCacheDirectory(std::string directory) { this->m_geodesic_cache_directory = directory; }
+
+//---------------------------------------------------------------------------
+void Optimize::SetGeodesicsCacheFileSize(size_t bytes) { this->m_geodesic_cache_file_size = bytes; }
+
+//---------------------------------------------------------------------------
+void Optimize::SetGeodesicsCacheBudget(size_t bytes) { GeodesicCacheBudget::Instance().SetBudget(bytes); }
+
+//---------------------------------------------------------------------------
+void Optimize::PrintGeodesicCacheStats() {
+  if (!m_geodesics_enabled || m_mesh_wrappers.empty()) {
+    return;
+  }
+  std::cout << "Geodesic cache (hits / misses / evictions / MB):\n";
+  for (int i = 0; i < m_mesh_wrappers.size(); i++) {
+    const auto stats = m_mesh_wrappers[i]->GetGeodesicCacheStats();
+    std::cout << "  mesh " << i << ": " << stats.hits << " / " << stats.misses << " / " << stats.evictions << " / "
+              << stats.bytes / (1024.0 * 1024.0) << "\n";
+  }
+  std::cout << "  total: " << GeodesicCacheBudget::Instance().GetUsed() / (1024.0 * 1024.0) << " MB\n";
+}
+
 //---------------------------------------------------------------------------
 vnl_vector_fixed<double, 3> Optimize::TransformPoint(int domain, vnl_vector_fixed<double, 3> input) {
   // If initial transform provided, transform cutting plane points
@@ -2116,6 +2325,12 @@ void Optimize::SetSharedBoundaryEnabled(bool enabled) { m_sampler->SetSharedBoun
 //---------------------------------------------------------------------------
 void Optimize::SetSharedBoundaryWeight(double weight) { m_sampler->SetSharedBoundaryWeight(weight); }
 
+//---------------------------------------------------------------------------
+void Optimize::SetUseGridNeighborhood(bool enabled) { m_sampler->SetUseGridNeighborhood(enabled); }
+
+//---------------------------------------------------------------------------
+void Optimize::SetUseSinglePrecision(bool enabled) { m_sampler->SetUseSinglePrecision(enabled); }
+
 //---------------------------------------------------------------------------
 void Optimize::ComputeTotalIterations() {
   total_particle_iterations_ = 0;
@@ -21,7 +21,9 @@
 #include "Libs/Optimize/Domain/DomainType.h"
 #include "Libs/Optimize/Domain/MeshWrapper.h"
 #include "Libs/Optimize/Function/VectorFunction.h"
+#include "Libs/Optimize/Utils/CheckpointWriter.h"
 #include "Libs/Optimize/Utils/OptimizationVisualizer.h"
+#include "Libs/Optimize/Utils/OptimizerState.h"
 #include "ParticleSystem.h"
 #include "ProcrustesRegistration.h"
 #include "Sampler.h"
@@ -30,6 +32,7 @@ namespace shapeworks {
 
 class Project;
 class ParticleGoodBadAssessment;
+class VtkMeshWrapper;
 
 class MatrixContainer {
  public:
@@ -198,6 +201,11 @@ class Optimize {
   void SetCheckpointingInterval(int checkpointing_interval);
   //! Set if checkpoints should be kept (0=disable, 1=enable)
   void SetKeepCheckpoints(int keep_checkpoints);
+  //! Set if kept checkpoints should hold a single packed particle file instead of per-domain point files
+  void SetPackedCheckpoints(bool packed_checkpoints);
+  //! Set a checkpoint (or output) directory to resume the optimization from, continuing where its latest
+  //! optimizer state left off instead of starting over
+  void SetResumeDirectory(std::string resume_directory);
 
   //! Set if regression should be used (TODO: details)
   void SetUseRegression(bool use_regression);
@@ -245,6 +253,12 @@ class Optimize {
   void SetSharedBoundaryEnabled(bool enabled);
   void SetSharedBoundaryWeight(double weight);
 
+  //! Use a flat uniform grid instead of a tree for particle neighborhood queries
+  void SetUseGridNeighborhood(bool enabled);
+
+  //! Store the shape matrices of the correspondence term in single precision (halves their memory)
+  void SetUseSinglePrecision(bool enabled);
+
   const std::vector<int>& GetDomainFlags();
 
   //! Set if file output is enabled
@@ -287,6 +301,16 @@ class Optimize {
   //! n * number_of_triangles
   void SetGeodesicsCacheSizeMultiplier(size_t n);
 
+  //! Set the directory of the persistent geodesic cache, shared across runs. Empty to disable
+  void SetGeodesicsCacheDirectory(std::string directory);
+
+  //! Set the maximum size in bytes of each mesh's persistent geodesic cache file. 0 => VtkMeshWrapper
+  //! will use the size of its in-memory cache
+  void SetGeodesicsCacheFileSize(size_t bytes);
+
+  //! Set the limit in bytes on the total memory of the geodesic caches of all meshes. 0 for no limit
+  void SetGeodesicsCacheBudget(size_t bytes);
+
   OptimizationVisualizer& GetVisualizer();
   void SetShowVisualizer(bool show);
   bool GetShowVisualizer();
@@ -338,8 +362,26 @@ class Optimize {
   void WriteParameters(std::string output_dir = "");
   void ReportBadParticles();
 
+  //! Copies the transforms and, if requested, the particle positions and features out of the particle system
+  std::shared_ptr<CheckpointWriter::Snapshot> SnapshotParticleSystem(bool points, bool features) const;
+
+  //! Queues the checkpoint files of the current iteration for writing on the checkpoint writer's thread
+  void WriteCheckpoint();
+  //! Waits for queued checkpoints to be written
+  void FlushCheckpoints() const;
+
+  //! Captures everything needed to resume from the current iteration
+  std::shared_ptr<OptimizerState> CaptureOptimizerState() const;
+  //! Reads the state to resume from and restores the particles, transforms and run progress
+  bool LoadResumeState();
+  //! Restores the per-particle optimizer state right before the resumed phase continues
+  void RestoreOptimizerState();
+  //! Returns true if a phase was already completed by the run being resumed
+  bool SkipPhase(OptimizerState::Phase phase) const;
+
   int SetParameters();
   void WriteModes();
+  void PrintGeodesicCacheStats();
 
   void PrintStartMessage(std::string str, unsigned int vlevel = 0) const;
 
@@ -409,6 +451,13 @@ class Optimize {
   bool m_save_init_splits = false;
   unsigned int m_checkpointing_interval = 50;
   int m_keep_checkpoints = 0;
+  bool m_packed_checkpoints = false;
+  //! background writer of checkpoints, flushed before any other output is written
+  std::unique_ptr<CheckpointWriter> m_checkpoint_writer;
+  std::string m_resume_directory;
+  //! state being resumed from, cleared once it has been restored
+  std::unique_ptr<OptimizerState> m_resume_state;
+  OptimizerState::Phase m_phase = OptimizerState::Phase::Initialize;
   double m_cotan_sigma_factor = 5.0;
   std::vector<int> m_particle_flags;
   std::vector<int> m_domain_flags;
@@ -419,6 +468,9 @@ class Optimize {
   std::string m_python_filename;
   bool m_geodesics_enabled = false;             // geodesics disabled by default
   size_t m_geodesic_cache_size_multiplier = 0;  // 0 => VtkMeshWrapper will use a heuristic to determine cache size
+  std::string m_geodesic_cache_directory;       // empty => no persistent geodesic cache
+  size_t m_geodesic_cache_file_size = 0;
+  std::vector<std::shared_ptr<VtkMeshWrapper>> m_mesh_wrappers;  // for geodesic cache statistics
 
   // m_spacing is used to scale the random update vector for particle splitting.
   double m_spacing = 0;
@@ -429,6 +481,9 @@ class Optimize {
   std::vector<double> m_energy_a;
   std::vector<double> m_energy_b;
   std::vector<double> m_total_energy;
+  //! per-domain sampling and correspondence energies of the last logged iteration
+  std::vector<double> m_domain_energy_a;
+  std::vector<double> m_domain_energy_b;
   bool m_log_energy = false;
   std::string m_str_energy;
 
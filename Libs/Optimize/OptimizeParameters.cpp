@@ -24,6 +24,9 @@ const std::string iterations_per_split = "iterations_per_split";
 const std::string optimization_iterations = "optimization_iterations";
 const std::string use_geodesic_distance = "use_geodesic_distance";
 const std::string geodesic_cache_multiplier = "geodesic_cache_multiplier";
+const std::string geodesic_cache_directory = "geodesic_cache_directory";
+const std::string geodesic_cache_file_size = "geodesic_cache_file_size";
+const std::string geodesic_cache_budget = "geodesic_cache_budget";
 const std::string use_normals = "use_normals";
 const std::string normals_strength = "normals_strength";
 const std::string procrustes = "procrustes";
@@ -43,12 +46,15 @@ const std::string fixed_subjects_choice = "fixed_subjects_choice";
 const std::string checkpointing_interval = "checkpointing_interval";
 const std::string save_init_splits = "save_init_splits";
 const std::string keep_checkpoints = "keep_checkpoints";
+const std::string packed_checkpoints = "packed_checkpoints";
 const std::string use_disentangled_ssm = "use_disentangled_ssm";
 const std::string field_attributes = "field_attributes";
 const std::string field_attribute_weights = "field_attribute_weights";
 const std::string use_geodesics_to_landmarks = "use_geodesics_to_landmarks";
 const std::string geodesics_to_landmarks_weight = "geodesics_to_landmarks_weight";
 const std::string particle_format = "particle_format";
+const std::string use_grid_neighborhood = "use_grid_neighborhood";
+const std::string use_single_precision = "use_single_precision";
 }  // namespace Keys
 
 //---------------------------------------------------------------------------
@@ -64,6 +70,9 @@ OptimizeParameters::OptimizeParameters(ProjectHandle project) {
                                          Keys::optimization_iterations,
                                          Keys::use_geodesic_distance,
                                          Keys::geodesic_cache_multiplier,
+                                         Keys::geodesic_cache_directory,
+                                         Keys::geodesic_cache_file_size,
+                                         Keys::geodesic_cache_budget,
                                          Keys::use_normals,
                                          Keys::normals_strength,
                                          Keys::procrustes,
@@ -89,7 +98,10 @@ OptimizeParameters::OptimizeParameters(ProjectHandle project) {
                                          Keys::geodesics_to_landmarks_weight,
                                          Keys::keep_checkpoints,
                                          Keys::use_disentangled_ssm,
-                                         Keys::particle_format};
+                                         Keys::particle_format,
+                                         Keys::use_grid_neighborhood,
+                                         Keys::packed_checkpoints,
+                                         Keys::use_single_precision};
 
   // check if params_ has any unknown keys
   for (auto& param : params_.get_map()) {
@@ -283,6 +295,30 @@ void OptimizeParameters::set_geodesic_cache_multiplier(int value) {
   params_.set(Keys::geodesic_cache_multiplier, value);
 }
 
+//---------------------------------------------------------------------------
+std::string OptimizeParameters::get_geodesic_cache_directory() {
+  return params_.get(Keys::geodesic_cache_directory, "");
+}
+
+//---------------------------------------------------------------------------
+void OptimizeParameters::set_geodesic_cache_directory(std::string value) {
+  params_.set(Keys::geodesic_cache_directory, value);
+}
+
+//---------------------------------------------------------------------------
+int OptimizeParameters::get_geodesic_cache_file_size() { return params_.get(Keys::geodesic_cache_file_size, 0); }
+
+//---------------------------------------------------------------------------
+void OptimizeParameters::set_geodesic_cache_file_size(int value) {
+  params_.set(Keys::geodesic_cache_file_size, value);
+}
+
+//---------------------------------------------------------------------------
+int OptimizeParameters::get_geodesic_cache_budget() { return params_.get(Keys::geodesic_cache_budget, 0); }
+
+//---------------------------------------------------------------------------
+void OptimizeParameters::set_geodesic_cache_budget(int value) { params_.set(Keys::geodesic_cache_budget, value); }
+
 //---------------------------------------------------------------------------
 double OptimizeParameters::get_narrow_band() { return params_.get(Keys::narrow_band, 4.0); }
 
@@ -344,11 +380,24 @@ bool OptimizeParameters::set_up_optimize(Optimize* optimize) {
   optimize->SetOptimizationIterations(get_optimization_iterations());
   optimize->SetGeodesicsEnabled(get_use_geodesic_distance());
   optimize->SetGeodesicsCacheSizeMultiplier(get_geodesic_cache_multiplier());
+  auto geodesic_cache_directory = get_geodesic_cache_directory();
+  if (geodesic_cache_directory != "" && boost::filesystem::path(geodesic_cache_directory).is_relative()) {
+    // relative to the project file
+    auto base = StringUtils::getPath(project_->get_filename());
+    if (base != project_->get_filename() && base != "") {
+      geodesic_cache_directory = base + "/" + geodesic_cache_directory;
+    }
+  }
+  optimize->SetGeodesicsCacheDirectory(geodesic_cache_directory);
+  optimize->SetGeodesicsCacheFileSize(static_cast<size_t>(get_geodesic_cache_file_size()) * 1024 * 1024);
+  optimize->SetGeodesicsCacheBudget(static_cast<size_t>(get_geodesic_cache_budget()) * 1024 * 1024);
   optimize->SetNarrowBand(get_narrow_band());
   optimize->SetOutputDir(get_output_prefix());
   optimize->SetMeshFFCMode(get_mesh_ffc_mode());
   optimize->SetUseDisentangledSpatiotemporalSSM(get_use_disentangled_ssm());
   optimize->set_particle_format(get_particle_format());
+  optimize->SetUseGridNeighborhood(get_use_grid_neighborhood());
+  optimize->SetUseSinglePrecision(get_use_single_precision());
 
   // TODO Remove this once Studio has controls for shared boundary
   optimize->SetSharedBoundaryEnabled(true);
@@ -634,6 +683,7 @@ bool OptimizeParameters::set_up_optimize(Optimize* optimize) {
   optimize->SetCheckpointingInterval(get_checkpoint_interval());
   optimize->SetSaveInitSplits(get_save_init_splits());
   optimize->SetKeepCheckpoints(get_keep_checkpoints() ? 1 : 0);
+  optimize->SetPackedCheckpoints(get_packed_checkpoints());
 
   optimize->SetFilenames(StringUtils::getFileNamesFromPaths(filenames));
   optimize->SetOutputTransformFile("transform");
@@ -673,6 +723,12 @@ bool OptimizeParameters::get_keep_checkpoints() { return params_.get(Keys::keep_
 //---------------------------------------------------------------------------
 void OptimizeParameters::set_keep_checkpoints(bool enabled) { params_.set(Keys::keep_checkpoints, enabled); }
 
+//---------------------------------------------------------------------------
+bool OptimizeParameters::get_packed_checkpoints() { return params_.get(Keys::packed_checkpoints, false); }
+
+//---------------------------------------------------------------------------
+void OptimizeParameters::set_packed_checkpoints(bool enabled) { params_.set(Keys::packed_checkpoints, enabled); }
+
 //---------------------------------------------------------------------------
 std::vector<std::string> OptimizeParameters::get_field_attributes() {
   return params_.get(Keys::field_attributes, std::vector<std::string>());
@@ -718,3 +774,15 @@ std::string OptimizeParameters::get_particle_format() { return params_.get(Keys:
 
 //---------------------------------------------------------------------------
 void OptimizeParameters::set_particle_format(std::string format) { params_.set(Keys::particle_format, format); }
+
+//---------------------------------------------------------------------------
+bool OptimizeParameters::get_use_grid_neighborhood() { return params_.get(Keys::use_grid_neighborhood, false); }
+
+//---------------------------------------------------------------------------
+void OptimizeParameters::set_use_grid_neighborhood(bool value) { params_.set(Keys::use_grid_neighborhood, value); }
+
+//---------------------------------------------------------------------------
+bool OptimizeParameters::get_use_single_precision() { return params_.get(Keys::use_single_precision, false); }
+
+//---------------------------------------------------------------------------
+void OptimizeParameters::set_use_single_precision(bool value) { params_.set(Keys::use_single_precision, value); }
@@ -49,6 +49,18 @@ class OptimizeParameters {
   int get_geodesic_cache_multiplier();
   void set_geodesic_cache_multiplier(int value);
 
+  //! Directory for the persistent geodesic cache, "" disables it
+  std::string get_geodesic_cache_directory();
+  void set_geodesic_cache_directory(std::string value);
+
+  //! Maximum size of each mesh's persistent geodesic cache file in MB, 0 chooses a default
+  int get_geodesic_cache_file_size();
+  void set_geodesic_cache_file_size(int value);
+
+  //! Limit in MB on the in-memory geodesic caches of all meshes together, 0 for no limit
+  int get_geodesic_cache_budget();
+  void set_geodesic_cache_budget(int value);
+
   std::vector<bool> get_use_normals();
   void set_use_normals(std::vector<bool> use_normals);
 
@@ -112,6 +124,9 @@ class OptimizeParameters {
   bool get_keep_checkpoints();
   void set_keep_checkpoints(bool enabled);
 
+  bool get_packed_checkpoints();
+  void set_packed_checkpoints(bool enabled);
+
   std::vector<std::string> get_field_attributes();
   void set_field_attributes(std::vector<std::string> attributes);
 
@@ -127,6 +142,12 @@ class OptimizeParameters {
   std::string get_particle_format();
   void set_particle_format(std::string format);
 
+  bool get_use_grid_neighborhood();
+  void set_use_grid_neighborhood(bool value);
+
+  bool get_use_single_precision();
+  void set_use_single_precision(bool value);
+
 
  private:
   std::string get_output_prefix();
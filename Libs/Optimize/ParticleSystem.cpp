@@ -1,5 +1,11 @@
 #include "ParticleSystem.h"
 
+#include <tbb/parallel_for.h>
+
+#include <sstream>
+
+#include "Libs/Optimize/Utils/NearestNeighborStatistics.h"
+
 namespace shapeworks {
 
 ParticleSystem::PointType ParticleSystem::TransformPoint(const PointType& p, const TransformType& T) const {
@@ -179,22 +185,64 @@ const typename ParticleSystem::PointType& ParticleSystem::SetPosition(const Poin
   }
 
   // Notify any observers.
-  ParticlePositionSetEvent e;
-  e.SetDomainIndex(d);
-  e.SetPositionIndex(k);
-
-  this->InvokeEvent(e);
+  for (auto observer : m_PositionSetObservers) {
+    observer->PositionSetCallback(this, d, k);
+  }
+  if (m_BatchingPositionNotifications) {
+    m_DirtyPositions[d]->Mark(k);
+  } else {
+    for (auto observer : m_BatchedPositionSetObservers) {
+      observer->PositionSetCallback(this, d, k);
+    }
+  }
 
   return m_Positions[d]->operator[](k);
 }
 
 void ParticleSystem::AddPositionList(const std::vector<PointType>& p, unsigned int d) {
-  // Traverse the list and add each point to the domain.
-  for (typename std::vector<PointType>::const_iterator it = p.begin(); it != p.end(); it++) {
-    this->AddPosition(*it, d);
+  this->AddPositions(p, d);
+}
+
+void ParticleSystem::AddPositions(const std::vector<PointType>& p, unsigned int d) {
+  this->InsertPositions(p, d);
+  this->NotifyPositionsAdded(p.size(), d);
+}
+
+void ParticleSystem::InsertPositions(const std::vector<PointType>& p, unsigned int d) {
+  const auto first = m_IndexCounters[d];
+  for (size_t i = 0; i < p.size(); i++) {
+    m_Positions[d]->operator[](first + i) = p[i];
+  }
+
+  // Potentially modifies positions!
+  if (m_DomainFlags[d] == false) {
+    std::vector<PointType> constrained(p.size());
+    for (size_t i = 0; i < p.size(); i++) {
+      auto& pos = m_Positions[d]->operator[](first + i);
+      m_Domains[d]->ApplyConstraints(pos, first + i);
+      constrained[i] = pos;
+    }
+    m_Neighborhoods[d]->AddPositions(constrained, first);
   }
 }
 
+void ParticleSystem::NotifyPositionsAdded(size_t count, unsigned int d) {
+  // Increase the FixedParticleFlag list size if necessary.
+  auto& fixed = m_FixedParticleFlags[d % m_DomainsPerShape];
+  if (m_IndexCounters[d] + count > fixed.size()) {
+    fixed.resize(m_IndexCounters[d] + count, false);
+  }
+
+  // Notify any observers.
+  ParticlePositionAddEvent e;
+  e.SetDomainIndex(d);
+  for (size_t i = 0; i < count; i++) {
+    e.SetPositionIndex(m_IndexCounters[d] + i);
+    this->InvokeEvent(e);
+  }
+  m_IndexCounters[d] += count;
+}
+
 void ParticleSystem::PrintParticleSystem() {
   for (unsigned int d = 0; d < this->GetNumberOfDomains(); d++) {
     std::vector<PointType> list;
@@ -223,6 +271,17 @@ void ParticleSystem::PrintParticleSystem() {
   */
 }
 
+std::string ParticleSystem::GetRandomState() const {
+  std::stringstream ss;
+  ss << m_rand;
+  return ss.str();
+}
+
+void ParticleSystem::SetRandomState(const std::string& state) {
+  std::stringstream ss(state);
+  ss >> m_rand;
+}
+
 void ParticleSystem::AdvancedAllParticleSplitting(double epsilon, unsigned int domains_per_shape,
                                                   unsigned int dom_to_process) {
   size_t num_doms = this->GetNumberOfDomains();
@@ -249,35 +308,32 @@ void ParticleSystem::AdvancedAllParticleSplitting(double epsilon, unsigned int d
       this->GetDomain(domain)->GetConstraints()->InitializeLagrangianParameters(zeros);
     }
 
-    // For each shape, split particle i in all shapes in direction random and -random to obtain split particles
-    // Check if new particles violate constraint (disabled)
-    for (size_t i = 0; i < lists[0].size(); i++) {
-      // While the random vector updated violates plane constraints
-      // Breaks when it doesn't violate for any domain
-      std::vector<PointType> newposs_good;
-
-      while (true) {
-        // Generate random unit vector
-        std::uniform_real_distribution<double> distribution(-1000., 1000.);
-
-        vnl_vector_fixed<double, 3> random;
+    // Draw the split direction of every particle up front, in particle order, so the splits don't depend on how
+    // the shapes are scheduled below.  Particle i is split in the same direction in all shapes.
+    const size_t num_particles = lists[0].size();
+    std::uniform_real_distribution<double> distribution(-1000., 1000.);
+    std::vector<vnl_vector_fixed<double, 3>> directions(num_particles);
+    for (auto& random : directions) {
+      for (int i = 0; i < 3; i++) {
+        random[i] = distribution(this->m_rand);
+      }
+      random /= random.magnitude();
+    }
 
-        for (int i = 0; i < 3; i++) {
-          random[i] = distribution(this->m_rand);
-        }
-        double norm = random.magnitude();
-        random /= norm;
+    // For each shape, split particle i in direction random to obtain the new particles, then add them to the
+    // domain in one bulk insert.  Each shape only touches its own domain, so the shapes are split in parallel.
+    tbb::parallel_for(tbb::blocked_range<size_t>{0, lists.size()}, [&](const tbb::blocked_range<size_t>& r) {
+      for (size_t j = r.begin(); j < r.end(); j++) {
+        const int local_domain = dom_to_process + j * domains_per_shape;
+        const TransformType inverse =
+            GetInversePrefixTransform(local_domain) * GetInverseTransform(local_domain);
 
-        // Check where the update will take us after applying it to the point and the constraints.
-        newposs_good.clear();
-        bool good = true;  // flag to check if the new update violates in any domain
-        for (size_t j = 0; j < lists.size(); j++) {
+        std::vector<PointType> newposs(num_particles);
+        for (size_t i = 0; i < num_particles; i++) {
           // Add epsilon times random direction to existing point and apply domain
           // constraints to generate a new particle position.
-
-          int local_domain = dom_to_process + j * domains_per_shape;
-          auto transformed_vector =
-              TransformVector(random, GetInversePrefixTransform(local_domain) * GetInverseTransform(local_domain));
+          const auto& random = directions[i];
+          auto transformed_vector = TransformVector(random, inverse);
           PointType newpos =
               GetDomain(local_domain)->GetPositionAfterSplit(lists[j][i], transformed_vector, random, epsilon);
 
@@ -286,56 +342,21 @@ void ParticleSystem::AdvancedAllParticleSplitting(double epsilon, unsigned int d
               !this->GetDomain(local_domain)->GetConstraints()->isAnyViolated(newpos)) {
             this->GetDomain(local_domain)->ApplyConstraints(newpos, -1);
           }
-          newposs_good.push_back(newpos);
-          // Check for plane constraint violations
-
-          /*if (this->GetDomain(dom_to_process+j*domains_per_shape)->GetConstraints()->IsAnyViolated(newpos)) {
-            good = false;
-            //std::cout << "violation " << lists[j][i] << " new point " << std::endl;
-            break;
-          }*/
-        }
-
-        if (good) {
-          for (size_t j = 0; j < lists.size(); j++) {
-            int local_domain = dom_to_process + j * domains_per_shape;
-            this->AddPosition(newposs_good[j], local_domain);
-            // Debuggg
-            // std::cout << "Domain " << j << " Curr Pos " << lists[j][i] << " random "
-            // << random  << " epsilon " << epsilon << " picked " << newposs_good[j] << std::endl;
-          }
-          break;
+          newposs[i] = newpos;
         }
+        InsertPositions(newposs, local_domain);
+      }
+    });
 
-      }  // while end
-    }    // for end
-  }      // if end
+    // observers are not thread safe
+    for (size_t j = 0; j < lists.size(); j++) {
+      NotifyPositionsAdded(num_particles, dom_to_process + j * domains_per_shape);
+    }
+  }  // if end
 }
 
 double ParticleSystem::ComputeMaxDistNearestNeighbors(size_t dom) {
-  std::vector<PointType> list;
-  for (auto k = 0; k < GetPositions(dom)->GetSize(); k++) {
-    list.push_back(GetPositions(dom)->Get(k));
-  }
-
-  double maxDistNN = 0;
-
-  for (size_t i = 0; i < list.size(); i++) {
-    size_t closest_particle = 0;
-    double closest_particle_distance = (list[i] - list[0]).GetNorm();
-    for (size_t j = 1; j < list.size(); j++) {
-      double dist = (list[i] - list[j]).GetNorm();
-      if (dist < closest_particle_distance) {
-        closest_particle_distance = dist;
-        closest_particle = j;
-      }
-    }
-    if (closest_particle_distance > maxDistNN) {
-      maxDistNN = closest_particle_distance;
-    }
-  }
-
-  return maxDistNN;
+  return NearestNeighborStatistics::Compute(*this, dom).max;
 }
 
 void ParticleSystem::RegisterObserver(Observer* attr) {
@@ -361,10 +382,11 @@ void ParticleSystem::RegisterObserver(Observer* attr) {
     tmpcmd->SetCallbackFunction(attr, &Observer::NeighborhoodSetEventCallback);
     this->AddObserver(ParticleNeighborhoodSetEvent(), tmpcmd);
   }
-  if (attr->m_DefinedCallbacks.PositionSetEvent == true) {
-    itk::MemberCommand<Observer>::Pointer tmpcmd = itk::MemberCommand<Observer>::New();
-    tmpcmd->SetCallbackFunction(attr, &Observer::PositionSetEventCallback);
-    this->AddObserver(ParticlePositionSetEvent(), tmpcmd);
+  // position sets are dispatched directly, see Observer::PositionSetCallback
+  if (attr->m_DefinedCallbacks.BatchedPositionSetEvent == true) {
+    m_BatchedPositionSetObservers.push_back(attr);
+  } else if (attr->m_DefinedCallbacks.PositionSetEvent == true) {
+    m_PositionSetObservers.push_back(attr);
   }
   if (attr->m_DefinedCallbacks.PositionAddEvent == true) {
     itk::MemberCommand<Observer>::Pointer tmpcmd = itk::MemberCommand<Observer>::New();
@@ -378,4 +400,32 @@ void ParticleSystem::RegisterObserver(Observer* attr) {
   }
 }
 
+void ParticleSystem::BeginBatchedPositionNotifications() {
+  while (m_DirtyPositions.size() < m_Positions.size()) {
+    m_DirtyPositions.push_back(std::make_unique<DirtyParticleSet>());
+  }
+  for (unsigned int d = 0; d < m_Positions.size(); d++) {
+    m_DirtyPositions[d]->Reset(m_Positions[d] ? GetNumberOfParticles(d) : 0);
+  }
+  m_BatchingPositionNotifications = true;
+}
+
+void ParticleSystem::FlushPositionNotifications(unsigned int d) {
+  if (!m_BatchingPositionNotifications) {
+    return;
+  }
+  m_DirtyPositions[d]->Drain([&](size_t k) {
+    for (auto observer : m_BatchedPositionSetObservers) {
+      observer->PositionSetCallback(this, d, k);
+    }
+  });
+}
+
+void ParticleSystem::EndBatchedPositionNotifications() {
+  for (unsigned int d = 0; d < m_DirtyPositions.size(); d++) {
+    FlushPositionNotifications(d);
+  }
+  m_BatchingPositionNotifications = false;
+}
+
 }  // namespace shapeworks
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <random>
+#include <string>
 #include <vector>
 
+#include "Libs/Optimize/Container/DirtyParticleSet.h"
 #include "Libs/Optimize/Container/GenericContainer.h"
 #include "Libs/Optimize/Domain/ParticleDomain.h"
 #include "Libs/Optimize/Neighborhood/ParticleNeighborhood.h"
@@ -91,6 +94,17 @@ class ParticleSystem : public itk::DataObject {
   */
   void RegisterObserver(Observer *attr);
 
+  /** Batches the position set notifications of observers that allow it
+      (BatchedPositionSetEvent).  Until EndBatchedPositionNotifications, SetPosition
+      only marks the particle as changed in a per-domain bitset, which is safe
+      from any number of threads, and FlushPositionNotifications(d) tells the
+      batched observers about the changed particles of domain d.  The number of
+      particles must not change while batching. */
+  void BeginBatchedPositionNotifications();
+  void FlushPositionNotifications(unsigned int d);
+  //! Flushes all domains and returns to notifying every SetPosition immediately
+  void EndBatchedPositionNotifications();
+
   /** Invokes the set event on all particle positions, resetting them to their
       current value.  This method may be called to synchronize positional
       information among various observers which may have gone out of sync. */
@@ -144,6 +158,12 @@ class ParticleSystem : public itk::DataObject {
   void SplitAllParticles(double epsilon);
   void SplitParticle(double epsilon, unsigned int idx, unsigned int d = 0);
   void AdvancedAllParticleSplitting(double epsilon, unsigned int domains_per_shape, unsigned int dom_to_process);
+
+  /** Get/Set the state of the random number generator used for splitting, serialized as text.  Used to resume a
+      checkpointed optimization with the same splits. */
+  std::string GetRandomState() const;
+  void SetRandomState(const std::string& state);
+
   // Debug function
   void PrintParticleSystem();
 
@@ -294,6 +314,13 @@ class ParticleSystem : public itk::DataObject {
      std::vector of points and the domain number. */
   void AddPositionList(const std::vector<PointType> &, unsigned int d = 0);
 
+  /** Adds a block of points to the specified domain in one bulk insert.  The
+      neighborhood is updated once for the whole block and the add events are
+      invoked after all points are in place, so observers that grow with the
+      particle count (e.g. the shape matrix) only grow once.  The result is the
+      same as calling AddPosition for each point in order. */
+  void AddPositions(const std::vector<PointType> &, unsigned int d = 0);
+
   /** Transforms a point using the given transform. NOTE: Scaling is not
       currently implemented. (This method may be converted to virtual and
       overridden if tranform type is generalized.)*/
@@ -367,7 +394,8 @@ class ParticleSystem : public itk::DataObject {
     m_Domains, m_Positions, and m_Transform lists. */
   void SetNumberOfDomains(unsigned int);
 
-  // Returns the maximum distance between nearest neighbors in domain dom
+  // Returns the maximum distance between nearest neighbors in domain dom.  See NearestNeighborStatistics for the
+  // other nearest neighbor statistics.
   double ComputeMaxDistNearestNeighbors(size_t dom);
 
   void SetFieldAttributes(const std::vector<std::string> &field_attributes) { m_FieldAttributes = field_attributes; }
@@ -395,6 +423,14 @@ class ParticleSystem : public itk::DataObject {
   ParticleSystem(const Self &);  // purposely not implemented
   void operator=(const Self &);  // purposely not implemented
 
+  /** The two halves of AddPositions.  InsertPositions stores the points,
+      applies the constraints and updates the neighborhood of domain d only, so
+      it may run for different domains concurrently.  NotifyPositionsAdded then
+      grows the fixed particle flags, invokes the add events and advances the
+      index counter, and must run on one thread. */
+  void InsertPositions(const std::vector<PointType> &, unsigned int d);
+  void NotifyPositionsAdded(size_t count, unsigned int d);
+
   /** The 2D array of particle positions.  1st array axis is the domain number.
       These values may only be modified by the ParticleSystem class itself. */
   std::vector<PointContainerType::Pointer> m_Positions;
@@ -435,6 +471,14 @@ class ParticleSystem : public itk::DataObject {
 
   std::vector<std::string> m_FieldAttributes;
 
+  /** Observers of SetPosition, notified immediately or in batches. */
+  std::vector<Observer *> m_PositionSetObservers;
+  std::vector<Observer *> m_BatchedPositionSetObservers;
+
+  /** Particles set since the last flush, per domain, while batching. */
+  std::vector<std::unique_ptr<DirtyParticleSet>> m_DirtyPositions;
+  bool m_BatchingPositionNotifications = false;
+
   std::mt19937 m_rand{42};
 };
 
@@ -1,11 +1,13 @@
 #include "ProcrustesRegistration.h"
 
+#include <tbb/parallel_for.h>
+
 #include "Procrustes3D.h"
 
 namespace shapeworks {
 
 //---------------------------------------------------------------------------
-void ProcrustesRegistration::RunRegistration(int d) {
+std::vector<ProcrustesRegistration::TransformType> ProcrustesRegistration::ComputeTransforms(int d) const {
   // DOES NOT Assume all domains have the same number of particles.
   const int totalDomains = m_ParticleSystem->GetNumberOfDomains();
   const int numPoints = m_ParticleSystem->GetNumberOfParticles(d);
@@ -13,26 +15,21 @@ void ProcrustesRegistration::RunRegistration(int d) {
 
   // Do not run procrustesfor this domain if number of points less than 10
   if (numPoints < 10) {
-    return;
+    return {};
   }
 
-  Procrustes3D::ShapeListType shapelist;
-  Procrustes3D::ShapeType shapevector;
-  Procrustes3D::PointType point;
-
-  // Read input shapes from file list
-
-  for (int i = d % m_DomainsPerShape; i < totalDomains; i += m_DomainsPerShape) {
-    shapevector.clear();
-    for (int j = 0; j < numPoints; j++) {
-      point(0) = m_ParticleSystem->GetPrefixTransformedPosition(j, i)[0];
-      point(1) = m_ParticleSystem->GetPrefixTransformedPosition(j, i)[1];
-      point(2) = m_ParticleSystem->GetPrefixTransformedPosition(j, i)[2];
-
-      shapevector.push_back(point);
+  // Gather the shapes, each shape fills its own entry of the list
+  Procrustes3D::ShapeListType shapelist(numShapes, Procrustes3D::ShapeType(numPoints));
+  tbb::parallel_for(tbb::blocked_range<int>{0, numShapes}, [&](const tbb::blocked_range<int>& r) {
+    for (int s = r.begin(); s < r.end(); s++) {
+      const int i = d % m_DomainsPerShape + s * m_DomainsPerShape;
+      auto& shapevector = shapelist[s];
+      for (int j = 0; j < numPoints; j++) {
+        const auto pos = m_ParticleSystem->GetPrefixTransformedPosition(j, i);
+        shapevector[j] = Procrustes3D::PointType(pos[0], pos[1], pos[2]);
+      }
     }
-    shapelist.push_back(shapevector);
-  }
+  });
 
   // Run alignment
   Procrustes3D::SimilarityTransformListType transforms;
@@ -40,21 +37,34 @@ void ProcrustesRegistration::RunRegistration(int d) {
   procrustes.AlignShapes(transforms, shapelist);
 
   // Construct transform matrices for each particle system.
-
-  int k = d % m_DomainsPerShape;
-
   Procrustes3D::TransformMatrixListType matrices;
   procrustes.ConstructTransformMatrices(transforms, matrices);
+  return matrices;
+}
 
-  for (int i = 0; i < numShapes; i++, k += m_DomainsPerShape) {
-    m_ParticleSystem->SetTransform(k, matrices[i]);
+//---------------------------------------------------------------------------
+void ProcrustesRegistration::ApplyTransforms(int d, const std::vector<TransformType>& transforms) {
+  int k = d % m_DomainsPerShape;
+  for (size_t i = 0; i < transforms.size(); i++, k += m_DomainsPerShape) {
+    m_ParticleSystem->SetTransform(k, transforms[i]);
   }
 }
 
+//---------------------------------------------------------------------------
+void ProcrustesRegistration::RunRegistration(int d) { ApplyTransforms(d, ComputeTransforms(d)); }
+
 //---------------------------------------------------------------------------
 void ProcrustesRegistration::RunRegistration() {
+  // Align the domains concurrently, but set the transforms on this thread since SetTransform notifies observers
+  std::vector<std::vector<TransformType>> transforms(m_DomainsPerShape);
+  tbb::parallel_for(tbb::blocked_range<int>{0, m_DomainsPerShape}, [&](const tbb::blocked_range<int>& r) {
+    for (int i = r.begin(); i < r.end(); i++) {
+      transforms[i] = ComputeTransforms(i);
+    }
+  });
+
   for (int i = 0; i < m_DomainsPerShape; i++) {
-    this->RunRegistration(i);
+    ApplyTransforms(i, transforms[i]);
   }
 }
 }  // namespace shapeworks
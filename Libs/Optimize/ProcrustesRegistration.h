@@ -17,6 +17,7 @@ class ProcrustesRegistration {
   // Particle system typedefs
   using ParticleSystemType = ParticleSystem;
   using PointType = ParticleSystemType::PointType;
+  using TransformType = ParticleSystemType::TransformType;
 
   void SetParticleSystem(ParticleSystemType* p) { m_ParticleSystem = p; }
   ParticleSystemType* GetParticleSystem() const { return m_ParticleSystem; }
@@ -39,6 +40,13 @@ class ProcrustesRegistration {
   void SetRotationTranslation(bool rotationTranslation) { m_RotationTranslation = rotationTranslation; }
 
  private:
+  //! Aligns the shapes of domain i and returns the transform of each shape, empty if domain i is not registered.
+  //! Only reads the particle system, so several domains may be aligned concurrently.
+  std::vector<TransformType> ComputeTransforms(int i) const;
+
+  //! Sets the transforms returned by ComputeTransforms for domain i
+  void ApplyTransforms(int i, const std::vector<TransformType>& transforms);
+
   int m_DomainsPerShape = 1;
   bool m_Scaling = true;
   bool m_RotationTranslation = true;
@@ -232,9 +232,16 @@ void Sampler::ReInitialize() {
   this->m_MeanCurvatureCache->ZeroAllValues();
 }
 
+ParticleSurfaceNeighborhood::Pointer Sampler::CreateNeighborhood() {
+  if (m_UseGridNeighborhood) {
+    return ParticleGridNeighborhood::New().GetPointer();
+  }
+  return ParticleSurfaceNeighborhood::New();
+}
+
 void Sampler::AddMesh(std::shared_ptr<shapeworks::MeshWrapper> mesh) {
   auto domain = std::make_shared<MeshDomain>();
-  m_NeighborhoodList.push_back(ParticleSurfaceNeighborhood::New());
+  m_NeighborhoodList.push_back(CreateNeighborhood());
   if (mesh) {
     this->m_Spacing = 1;
     domain->SetMesh(mesh);
@@ -246,7 +253,7 @@ void Sampler::AddMesh(std::shared_ptr<shapeworks::MeshWrapper> mesh) {
 
 void Sampler::AddContour(vtkSmartPointer<vtkPolyData> poly_data) {
   auto domain = std::make_shared<ContourDomain>();
-  m_NeighborhoodList.push_back(ParticleSurfaceNeighborhood::New());
+  m_NeighborhoodList.push_back(CreateNeighborhood());
   if (poly_data != nullptr) {
     this->m_Spacing = 1;
     domain->SetPolyLine(poly_data);
@@ -305,7 +312,7 @@ void Sampler::AddFreeFormConstraint(int domain, const FreeFormConstraint& ffc) {
 void Sampler::AddImage(ImageType::Pointer image, double narrow_band, std::string name) {
   auto domain = std::make_shared<ImplicitSurfaceDomain<ImageType::PixelType>>();
 
-  m_NeighborhoodList.push_back(ParticleSurfaceNeighborhood::New());
+  m_NeighborhoodList.push_back(CreateNeighborhood());
 
   if (image) {
     this->m_Spacing = image->GetSpacing()[0];
@@ -19,6 +19,7 @@
 #include "Libs/Optimize/Function/SamplingFunction.h"
 #include "Libs/Optimize/Matrix/LinearRegressionShapeMatrix.h"
 #include "Libs/Optimize/Matrix/MixedEffectsShapeMatrix.h"
+#include "Libs/Optimize/Neighborhood/ParticleGridNeighborhood.h"
 #include "Libs/Optimize/Neighborhood/ParticleSurfaceNeighborhood.h"
 #include "ParticleSystem.h"
 #include "TriMesh.h"
@@ -314,6 +315,15 @@ class Sampler {
   void SetSharedBoundaryEnabled(bool enabled) { m_IsSharedBoundaryEnabled = enabled; }
   void SetSharedBoundaryWeight(double weight) { m_SharedBoundaryWeight = weight; }
 
+  //! Use a flat uniform grid (ParticleGridNeighborhood) instead of a PowerOfTwoPointTree for neighborhood queries.
+  //! Must be set before domains are added.
+  void SetUseGridNeighborhood(bool enabled) { m_UseGridNeighborhood = enabled; }
+  bool GetUseGridNeighborhood() const { return m_UseGridNeighborhood; }
+
+  //! Store the general shape matrices and the correspondence update and inverse covariance in single precision
+  void SetUseSinglePrecision(bool enabled) { m_CorrespondenceFunction->SetSinglePrecision(enabled); }
+  bool GetUseSinglePrecision() const { return m_CorrespondenceFunction->IsSinglePrecision(); }
+
   void ReadTransforms();
   void ReadPointsFiles();
   virtual void AllocateDataCaches();
@@ -427,6 +437,9 @@ class Sampler {
 
   bool initialize_ffcs(size_t dom);
 
+  //! Creates the neighborhood object for a new domain
+  ParticleSurfaceNeighborhood::Pointer CreateNeighborhood();
+
  private:
   Sampler(const Sampler&);         // purposely not implemented
   void operator=(const Sampler&);  // purposely not implemented
@@ -449,6 +462,7 @@ class Sampler {
   std::vector<FreeFormConstraint> m_FFCs;
   std::vector<vtkSmartPointer<vtkPolyData>> m_meshes;
   bool m_meshFFCMode = false;
+  bool m_UseGridNeighborhood = false;
 
   std::vector<std::string> fieldAttributes_;
 
@@ -0,0 +1,203 @@
+#include "CheckpointWriter.h"
+
+#include <Logging.h>
+#include <Particles/ParticleFile.h>
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+#include "ObjectWriter.h"
+
+namespace shapeworks {
+
+//---------------------------------------------------------------------------
+CheckpointWriter::CheckpointWriter(size_t max_queue_depth) : max_queue_depth_(std::max<size_t>(1, max_queue_depth)) {
+  thread_ = std::thread(&CheckpointWriter::Run, this);
+}
+
+//---------------------------------------------------------------------------
+CheckpointWriter::~CheckpointWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  queue_changed_.notify_all();
+  thread_.join();
+}
+
+//---------------------------------------------------------------------------
+void CheckpointWriter::Enqueue(std::shared_ptr<const Snapshot> snapshot, std::vector<Target> targets) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  queue_changed_.wait(lock, [&] { return queue_.size() < max_queue_depth_; });
+  queue_.push_back({std::move(snapshot), std::move(targets)});
+  queue_changed_.notify_all();
+}
+
+//---------------------------------------------------------------------------
+void CheckpointWriter::Flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  queue_changed_.wait(lock, [&] { return queue_.empty() && !busy_; });
+}
+
+//---------------------------------------------------------------------------
+void CheckpointWriter::Run() {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      queue_changed_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+      // pending snapshots are still written when stopping
+      if (queue_.empty()) {
+        return;
+      }
+      job = std::move(queue_.front());
+      queue_.pop_front();
+      busy_ = true;
+    }
+    queue_changed_.notify_all();
+
+    for (const auto& target : job.targets) {
+      try {
+        Write(*job.snapshot, target);
+      } catch (std::exception& e) {
+        SW_ERROR("Unable to write checkpoint to {}: {}", target.directory, e.what());
+      } catch (...) {
+        SW_ERROR("Unable to write checkpoint to {}", target.directory);
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      busy_ = false;
+    }
+    queue_changed_.notify_all();
+  }
+}
+
+//---------------------------------------------------------------------------
+void CheckpointWriter::Write(const Snapshot& snapshot, const Target& target) {
+  namespace fs = boost::filesystem;
+
+  std::string directory = target.directory;
+  if (target.atomic_directory) {
+    directory = target.directory + ".partial";
+    fs::remove_all(directory);
+  }
+  fs::create_directories(directory);
+
+  if (target.packed) {
+    WritePackedPointFile(snapshot, directory);
+  } else {
+    WritePointFiles(snapshot, directory, target.particle_format);
+  }
+  if (target.features) {
+    WriteFeatureFiles(snapshot, directory);
+  }
+  if (target.transform_files) {
+    WriteTransformFiles(snapshot, directory);
+  }
+
+  if (!target.transform_file.empty()) {
+    WriteTransformFile(snapshot, directory + "/" + target.transform_file);
+  }
+  if (snapshot.state) {
+    WriteAtomically(directory + "/" + OptimizerState::FILENAME,
+                    [&](const std::string& tmp) { snapshot.state->Write(tmp); });
+  }
+
+  if (target.atomic_directory) {
+    fs::remove_all(target.directory);
+    fs::rename(directory, target.directory);
+  }
+}
+
+//---------------------------------------------------------------------------
+void CheckpointWriter::WritePointFiles(const Snapshot& snapshot, const std::string& directory,
+                                       const std::string& format) {
+  for (size_t i = 0; i < snapshot.names.size(); i++) {
+    const std::string local_file = directory + "/" + snapshot.names[i] + "_local." + format;
+    const std::string world_file = directory + "/" + snapshot.names[i] + "_world." + format;
+    WriteAtomically(local_file, [&](const std::string& tmp) { particles::write_particles(tmp, snapshot.local[i]); });
+    WriteAtomically(world_file, [&](const std::string& tmp) { particles::write_particles(tmp, snapshot.world[i]); });
+  }
+}
+
+//---------------------------------------------------------------------------
+std::string CheckpointWriter::GetPackedPointFilename(const std::string& directory) {
+  return directory + "/particles" + particles::COHORT_EXTENSION;
+}
+
+//---------------------------------------------------------------------------
+void CheckpointWriter::WritePackedPointFile(const Snapshot& snapshot, const std::string& directory) {
+  // one cohort entry per domain, holding its local (0) and world (1) particles
+  std::vector<Eigen::VectorXd> points;
+  points.reserve(snapshot.names.size() * 2);
+  for (size_t i = 0; i < snapshot.names.size(); i++) {
+    points.push_back(snapshot.local[i]);
+    points.push_back(snapshot.world[i]);
+  }
+  WriteAtomically(GetPackedPointFilename(directory), [&](const std::string& tmp) {
+    particles::CohortFile::write(tmp, 2, snapshot.names, points);
+  });
+}
+
+//---------------------------------------------------------------------------
+void CheckpointWriter::WriteTransformFile(const Snapshot& snapshot, const std::string& filename) {
+  WriteAtomically(filename, [&](const std::string& tmp) {
+    ObjectWriter<TransformType> writer;
+    writer.SetFileName(tmp);
+    writer.SetInput(snapshot.transforms);
+    writer.Update();
+  });
+}
+
+//---------------------------------------------------------------------------
+void CheckpointWriter::WriteTransformFiles(const Snapshot& snapshot, const std::string& directory) {
+  for (size_t i = 0; i < snapshot.names.size(); i++) {
+    const auto& transform = snapshot.transforms[i];
+    WriteAtomically(directory + "/" + snapshot.names[i] + ".transform", [&](const std::string& tmp) {
+      std::ofstream out(tmp.c_str());
+      if (!out) {
+        throw std::runtime_error("Error opening output file: " + tmp);
+      }
+      for (int r = 0; r < transform.cols(); r++) {
+        for (int c = 0; c < transform.rows(); c++) {
+          out << transform(r, c) << " ";
+        }
+      }
+      out << std::endl;
+    });
+  }
+}
+
+//---------------------------------------------------------------------------
+void CheckpointWriter::WriteFeatureFiles(const Snapshot& snapshot, const std::string& directory) {
+  for (size_t i = 0; i < snapshot.features.size(); i++) {
+    const auto& features = snapshot.features[i];
+    WriteAtomically(directory + "/" + snapshot.names[i] + "_wptsFeatures.particles", [&](const std::string& tmp) {
+      std::ofstream out(tmp.c_str());
+      if (!out) {
+        throw std::runtime_error("Error opening output file: " + tmp);
+      }
+      for (int j = 0; j < features.rows(); j++) {
+        for (int k = 0; k < features.cols(); k++) {
+          out << features(j, k) << " ";
+        }
+        out << std::endl;
+      }
+    });
+  }
+}
+
+//---------------------------------------------------------------------------
+void CheckpointWriter::WriteAtomically(const std::string& filename,
+                                       const std::function<void(const std::string&)>& write) {
+  namespace fs = boost::filesystem;
+  // keep the extension, writers pick the file format from it
+  const fs::path path(filename);
+  const fs::path tmp = path.parent_path() / (path.stem().string() + ".tmp" + path.extension().string());
+  write(tmp.string());
+  fs::rename(tmp, path);
+}
+
+}  // namespace shapeworks
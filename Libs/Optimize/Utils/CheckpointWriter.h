@@ -0,0 +1,113 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "OptimizerState.h"
+#include "ParticleSystem.h"
+
+namespace shapeworks {
+
+/**
+ * \class CheckpointWriter
+ *
+ * Writes the particle system output files on a background thread.
+ *
+ * The optimizer copies what is written (particle positions, transforms and
+ * feature values) into a Snapshot, which is cheap compared to writing
+ * thousands of small files, and hands it to the writer together with the
+ * places to write it to.  Snapshots are written in the order they were queued.
+ * At most max_queue_depth snapshots wait to be written; Enqueue blocks while
+ * the queue is full so a slow filesystem can't make memory use grow without
+ * bound.
+ *
+ * Every file is written to a temporary file that is renamed over the
+ * destination once complete, so an interrupted run never leaves a partially
+ * written file behind.  Targets with atomic_directory set are written into a
+ * temporary directory that is renamed into place once all their files are
+ * written.
+ */
+class CheckpointWriter {
+ public:
+  using TransformType = ParticleSystem::TransformType;
+
+  //! The output of one iteration, copied out of the particle system
+  struct Snapshot {
+    //! output name of each domain
+    std::vector<std::string> names;
+    //! local and world particles of each domain
+    std::vector<Eigen::VectorXd> local;
+    std::vector<Eigen::VectorXd> world;
+    //! transform of each domain
+    std::vector<TransformType> transforms;
+    //! world positions followed by the attributes of each particle of each domain, empty if not written
+    std::vector<Eigen::MatrixXd> features;
+    //! optimizer state to resume from, not written if null
+    std::shared_ptr<const OptimizerState> state;
+  };
+
+  //! Where and how to write a snapshot
+  struct Target {
+    //! directory of the point, transform and feature files
+    std::string directory;
+    //! name of the binary file holding all transforms within directory, not written if empty
+    std::string transform_file;
+    std::string particle_format = "particles";
+    bool transform_files = false;
+    bool features = false;
+    //! write a single packed cohort file instead of the per-domain point files
+    bool packed = false;
+    //! write into a temporary directory that is renamed to directory when complete
+    bool atomic_directory = false;
+  };
+
+  explicit CheckpointWriter(size_t max_queue_depth = 2);
+  ~CheckpointWriter();
+
+  //! Queues a snapshot to be written to each of the targets, blocks while the queue is full
+  void Enqueue(std::shared_ptr<const Snapshot> snapshot, std::vector<Target> targets);
+
+  //! Blocks until every queued snapshot has been written
+  void Flush();
+
+  //! Writes a snapshot to a target on the calling thread
+  static void Write(const Snapshot& snapshot, const Target& target);
+
+  static void WritePointFiles(const Snapshot& snapshot, const std::string& directory, const std::string& format);
+  static void WritePackedPointFile(const Snapshot& snapshot, const std::string& directory);
+  static void WriteTransformFile(const Snapshot& snapshot, const std::string& filename);
+  static void WriteTransformFiles(const Snapshot& snapshot, const std::string& directory);
+  static void WriteFeatureFiles(const Snapshot& snapshot, const std::string& directory);
+
+  //! Name of the packed point file within a checkpoint directory
+  static std::string GetPackedPointFilename(const std::string& directory);
+
+  //! Calls write with a temporary file name, then renames the temporary file to filename
+  static void WriteAtomically(const std::string& filename, const std::function<void(const std::string&)>& write);
+
+ private:
+  struct Job {
+    std::shared_ptr<const Snapshot> snapshot;
+    std::vector<Target> targets;
+  };
+
+  void Run();
+
+  size_t max_queue_depth_;
+  std::deque<Job> queue_;
+  //! true while the background thread is writing a job it has taken off the queue
+  bool busy_ = false;
+  bool stop_ = false;
+  std::mutex mutex_;
+  std::condition_variable queue_changed_;
+  std::thread thread_;
+};
+
+}  // namespace shapeworks
@@ -0,0 +1,142 @@
+#include "NearestNeighborStatistics.h"
+
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#include "ParticleSystem.h"
+
+namespace shapeworks {
+
+namespace {
+//! A balanced k-d tree stored implicitly in a permutation of the point indices.  Each range of more than LEAF_SIZE
+//! indices is split at its middle element along its widest axis, and that axis is stored at the middle position.
+class PointKdTree {
+ public:
+  using PointType = NearestNeighborStatistics::PointType;
+
+  explicit PointKdTree(const std::vector<PointType>& points)
+      : points_(points), index_(points.size()), axes_(points.size(), 0) {
+    std::iota(index_.begin(), index_.end(), 0);
+    Build(0, index_.size());
+  }
+
+  //! Squared distance from point self to its nearest other point, infinity if there is none
+  double NearestSquaredDistance(size_t self) const {
+    double best = std::numeric_limits<double>::infinity();
+    Search(0, index_.size(), points_[self], self, best);
+    return best;
+  }
+
+ private:
+  static constexpr size_t LEAF_SIZE = 8;
+
+  void Build(size_t begin, size_t end) {
+    if (end - begin <= LEAF_SIZE) {
+      return;
+    }
+
+    PointType lower = points_[index_[begin]];
+    PointType upper = lower;
+    for (size_t i = begin + 1; i < end; i++) {
+      const auto& p = points_[index_[i]];
+      for (unsigned int a = 0; a < 3; a++) {
+        lower[a] = std::min(lower[a], p[a]);
+        upper[a] = std::max(upper[a], p[a]);
+      }
+    }
+    unsigned char axis = 0;
+    for (unsigned char a = 1; a < 3; a++) {
+      if (upper[a] - lower[a] > upper[axis] - lower[axis]) {
+        axis = a;
+      }
+    }
+
+    const size_t mid = begin + (end - begin) / 2;
+    std::nth_element(index_.begin() + begin, index_.begin() + mid, index_.begin() + end,
+                     [&](size_t a, size_t b) { return points_[a][axis] < points_[b][axis]; });
+    axes_[mid] = axis;
+
+    Build(begin, mid);
+    Build(mid, end);
+  }
+
+  void Search(size_t begin, size_t end, const PointType& query, size_t self, double& best) const {
+    if (end - begin <= LEAF_SIZE) {
+      for (size_t i = begin; i < end; i++) {
+        if (index_[i] != self) {
+          best = std::min(best, query.SquaredEuclideanDistanceTo(points_[index_[i]]));
+        }
+      }
+      return;
+    }
+
+    // [begin, mid) lies at or below the split value along the axis, [mid, end) at or above it
+    const size_t mid = begin + (end - begin) / 2;
+    const unsigned char axis = axes_[mid];
+    const double diff = query[axis] - points_[index_[mid]][axis];
+    if (diff < 0) {
+      Search(begin, mid, query, self, best);
+      if (diff * diff < best) {
+        Search(mid, end, query, self, best);
+      }
+    } else {
+      Search(mid, end, query, self, best);
+      if (diff * diff < best) {
+        Search(begin, mid, query, self, best);
+      }
+    }
+  }
+
+  const std::vector<PointType>& points_;
+  std::vector<size_t> index_;
+  std::vector<unsigned char> axes_;
+};
+}  // namespace
+
+//---------------------------------------------------------------------------
+NearestNeighborStatistics NearestNeighborStatistics::Compute(const std::vector<PointType>& points) {
+  NearestNeighborStatistics stats;
+  stats.distances.assign(points.size(), 0.0);
+  if (points.size() < 2) {
+    return stats;
+  }
+
+  const PointKdTree tree(points);
+  tbb::parallel_for(tbb::blocked_range<size_t>{0, points.size()}, [&](const tbb::blocked_range<size_t>& r) {
+    for (size_t i = r.begin(); i < r.end(); i++) {
+      stats.distances[i] = std::sqrt(tree.NearestSquaredDistance(i));
+    }
+  });
+
+  stats.min = *std::min_element(stats.distances.begin(), stats.distances.end());
+  stats.max = *std::max_element(stats.distances.begin(), stats.distances.end());
+  stats.mean = std::accumulate(stats.distances.begin(), stats.distances.end(), 0.0) / stats.distances.size();
+  return stats;
+}
+
+//---------------------------------------------------------------------------
+NearestNeighborStatistics NearestNeighborStatistics::Compute(const ParticleSystem& ps, unsigned int d) {
+  const auto& positions = *ps.GetPositions(d);
+  std::vector<PointType> points(positions.GetSize());
+  for (size_t k = 0; k < points.size(); k++) {
+    points[k] = positions.Get(k);
+  }
+  return Compute(points);
+}
+
+//---------------------------------------------------------------------------
+std::vector<NearestNeighborStatistics> NearestNeighborStatistics::ComputeForDomains(const ParticleSystem& ps) {
+  std::vector<NearestNeighborStatistics> stats(ps.GetNumberOfDomains());
+  tbb::parallel_for(tbb::blocked_range<size_t>{0, stats.size()}, [&](const tbb::blocked_range<size_t>& r) {
+    for (size_t d = r.begin(); d < r.end(); d++) {
+      stats[d] = Compute(ps, d);
+    }
+  });
+  return stats;
+}
+
+}  // namespace shapeworks
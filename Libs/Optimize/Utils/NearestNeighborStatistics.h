@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+
+#include "itkPoint.h"
+
+namespace shapeworks {
+
+class ParticleSystem;
+
+/**
+ * \class NearestNeighborStatistics
+ *
+ * The distance from every particle of a domain to its nearest other particle,
+ * along with the smallest, largest and mean of these distances.
+ *
+ * The nearest neighbors are found with a k-d tree over the particle positions
+ * (in local coordinates), so computing the statistics of N particles takes
+ * O(N log N) rather than comparing every pair of particles.  The queries run
+ * in parallel, as do the domains in ComputeForDomains.
+ */
+class NearestNeighborStatistics {
+ public:
+  using PointType = itk::Point<double, 3>;
+
+  //! distance from each point to its nearest other point (0 for a point without neighbors)
+  std::vector<double> distances;
+  double min = 0.0;
+  double max = 0.0;
+  double mean = 0.0;
+
+  //! Computes the statistics of a set of points
+  static NearestNeighborStatistics Compute(const std::vector<PointType>& points);
+
+  //! Computes the statistics of the particles of domain d
+  static NearestNeighborStatistics Compute(const ParticleSystem& ps, unsigned int d);
+
+  //! Computes the statistics of every domain of the particle system, in parallel
+  static std::vector<NearestNeighborStatistics> ComputeForDomains(const ParticleSystem& ps);
+};
+
+}  // namespace shapeworks
@@ -0,0 +1,224 @@
+#include "OptimizerState.h"
+
+#include <boost/filesystem.hpp>
+#include <cstring>
+#include <fstream>
+
+namespace shapeworks {
+
+namespace {
+const char magic[8] = {'S', 'W', 'O', 'P', 'T', '0', '0', '1'};
+
+class StateWriter {
+ public:
+  explicit StateWriter(std::ofstream& out) : out_(out) {}
+
+  template <class T>
+  void value(const T& v) {
+    out_.write(reinterpret_cast<const char*>(&v), sizeof(T));
+  }
+
+  template <class T>
+  void values(const T* data, size_t count) {
+    value<uint64_t>(count);
+    out_.write(reinterpret_cast<const char*>(data), count * sizeof(T));
+  }
+
+  template <class T>
+  void vector(const std::vector<T>& v) {
+    values(v.data(), v.size());
+  }
+
+  void string(const std::string& s) { values(s.data(), s.size()); }
+
+ private:
+  std::ofstream& out_;
+};
+
+class StateReader {
+ public:
+  StateReader(std::ifstream& in, const std::string& filename) : in_(in), filename_(filename) {
+    const auto position = in_.tellg();
+    in_.seekg(0, std::ios::end);
+    size_ = in_.tellg();
+    in_.seekg(position);
+  }
+
+  template <class T>
+  T value() {
+    T v;
+    read(&v, sizeof(T));
+    return v;
+  }
+
+  template <class T>
+  std::vector<T> vector() {
+    std::vector<T> v(count(sizeof(T)));
+    read(v.data(), v.size() * sizeof(T));
+    return v;
+  }
+
+  Eigen::VectorXd eigen_vector() {
+    Eigen::VectorXd v(count(sizeof(double)));
+    read(v.data(), v.size() * sizeof(double));
+    return v;
+  }
+
+  std::string string() {
+    std::string s(count(1), '\0');
+    read(&s[0], s.size());
+    return s;
+  }
+
+  // Reads the number of elements that follow, each taking at least element_bytes of the file. This guards against
+  // allocating absurd sizes from a corrupt file, so every count has to be read through here.
+  size_t count(size_t element_bytes) {
+    const auto n = value<uint64_t>();
+    const uint64_t remaining = size_ - static_cast<uint64_t>(in_.tellg());
+    if (n > remaining / element_bytes) {
+      throw std::runtime_error("Invalid optimizer state file: " + filename_);
+    }
+    return n;
+  }
+
+ private:
+  void read(void* data, size_t bytes) {
+    in_.read(reinterpret_cast<char*>(data), bytes);
+    if (!in_) {
+      throw std::runtime_error("Truncated optimizer state file: " + filename_);
+    }
+  }
+
+  std::ifstream& in_;
+  std::string filename_;
+  uint64_t size_ = 0;
+};
+}  // namespace
+
+//---------------------------------------------------------------------------
+void OptimizerState::Write(const std::string& filename) const {
+  std::ofstream out(filename, std::ios::binary);
+  if (!out) {
+    throw std::runtime_error("Unable to open " + filename + " for writing");
+  }
+
+  StateWriter w(out);
+  out.write(magic, sizeof(magic));
+  w.value<int32_t>(static_cast<int32_t>(phase));
+  w.value<int32_t>(multiscale_round ? 1 : 0);
+  w.vector(number_of_particles);
+  w.value<int32_t>(split_number);
+  w.value<int32_t>(iteration_count);
+  w.value<int32_t>(optimization_iterations_completed);
+  w.value<int32_t>(optimizer_iterations);
+  w.value<int32_t>(procrustes_counter);
+  w.value<int32_t>(checkpoint_counter);
+  w.value<int64_t>(particle_iterations);
+  w.string(random_state);
+  w.vector(minimum_variances);
+  w.string(energy_name);
+  w.vector(energy_a);
+  w.vector(energy_b);
+  w.vector(total_energy);
+
+  w.value<uint64_t>(domains.size());
+  for (const auto& domain : domains) {
+    w.values(domain.positions.data(), domain.positions.size());
+    w.values(domain.transform.data_block(), domain.transform.size());
+    w.vector(domain.time_steps);
+    w.vector(domain.sigmas);
+    w.value<uint64_t>(domain.constraint_mus.size());
+    for (const auto& mus : domain.constraint_mus) {
+      w.vector(mus);
+    }
+    w.vector(domain.planes);
+  }
+
+  if (!out) {
+    throw std::runtime_error("Error writing " + filename);
+  }
+}
+
+//---------------------------------------------------------------------------
+OptimizerState OptimizerState::Read(const std::string& filename) {
+  std::ifstream in(filename, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("Unable to open optimizer state file: " + filename);
+  }
+
+  char file_magic[sizeof(magic)];
+  in.read(file_magic, sizeof(file_magic));
+  if (!in || std::memcmp(file_magic, magic, sizeof(magic)) != 0) {
+    throw std::runtime_error("Not an optimizer state file: " + filename);
+  }
+
+  StateReader r(in, filename);
+  OptimizerState state;
+  state.phase = static_cast<Phase>(r.value<int32_t>());
+  state.multiscale_round = r.value<int32_t>() != 0;
+  state.number_of_particles = r.vector<int>();
+  state.split_number = r.value<int32_t>();
+  state.iteration_count = r.value<int32_t>();
+  state.optimization_iterations_completed = r.value<int32_t>();
+  state.optimizer_iterations = r.value<int32_t>();
+  state.procrustes_counter = r.value<int32_t>();
+  state.checkpoint_counter = r.value<int32_t>();
+  state.particle_iterations = r.value<int64_t>();
+  state.random_state = r.string();
+  state.minimum_variances = r.vector<double>();
+  state.energy_name = r.string();
+  state.energy_a = r.vector<double>();
+  state.energy_b = r.vector<double>();
+  state.total_energy = r.vector<double>();
+
+  // each domain starts with the count of its positions
+  state.domains.resize(r.count(sizeof(uint64_t)));
+  for (auto& domain : state.domains) {
+    domain.positions = r.eigen_vector();
+    const auto transform = r.vector<double>();
+    if (transform.size() != domain.transform.size()) {
+      throw std::runtime_error("Invalid optimizer state file: " + filename);
+    }
+    std::copy(transform.begin(), transform.end(), domain.transform.data_block());
+    domain.time_steps = r.vector<double>();
+    domain.sigmas = r.vector<double>();
+    domain.constraint_mus.resize(r.count(sizeof(uint64_t)));
+    for (auto& mus : domain.constraint_mus) {
+      mus = r.vector<double>();
+    }
+    domain.planes = r.vector<double>();
+  }
+  return state;
+}
+
+//---------------------------------------------------------------------------
+std::string OptimizerState::FindLatest(const std::string& directory) {
+  namespace fs = boost::filesystem;
+
+  std::vector<fs::path> candidates{fs::path(directory) / FILENAME};
+  const auto checkpoints = fs::path(directory) / "checkpoints";
+  if (fs::is_directory(checkpoints)) {
+    for (const auto& entry : fs::directory_iterator(checkpoints)) {
+      // checkpoints still being written are not complete
+      if (entry.path().extension() != ".partial") {
+        candidates.push_back(entry.path() / FILENAME);
+      }
+    }
+  }
+
+  std::string latest;
+  std::time_t latest_time = 0;
+  for (const auto& candidate : candidates) {
+    if (!fs::exists(candidate)) {
+      continue;
+    }
+    const auto time = fs::last_write_time(candidate);
+    if (latest.empty() || time > latest_time) {
+      latest = candidate.string();
+      latest_time = time;
+    }
+  }
+  return latest;
+}
+
+}  // namespace shapeworks
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <string>
+#include <vector>
+
+#include "ParticleSystem.h"
+
+namespace shapeworks {
+
+/**
+ * \class OptimizerState
+ *
+ * Everything needed to continue an optimization from the iteration it was
+ * checkpointed at, as if it had never stopped.
+ *
+ * Besides the particle positions and transforms this holds the state that the
+ * point files don't capture: where the run was (phase, split, iteration
+ * counters), the adaptive time step of every particle, the cached kernel
+ * width (sigma) of every particle, the constraint multipliers, the current
+ * minimum variance of the correspondence functions and the random number
+ * generator used for splitting.  The optimizer writes it into every checkpoint
+ * as a single binary file.
+ */
+class OptimizerState {
+ public:
+  using TransformType = ParticleSystem::TransformType;
+
+  //! Name of the state file within a checkpoint directory
+  static constexpr const char* FILENAME = "optimizer.swstate";
+
+  //! The step of Optimize::Run the checkpoint was taken in
+  enum class Phase : int32_t { Initialize = 0, Adaptivity = 1, Optimize = 2 };
+
+  struct Domain {
+    //! local particle positions (x1,y1,z1,x2,y2,z2,...)
+    Eigen::VectorXd positions;
+    TransformType transform;
+    std::vector<double> time_steps;
+    std::vector<double> sigmas;
+    //! multipliers of each constraint (cutting planes, then the free-form constraint)
+    std::vector<std::vector<double>> constraint_mus;
+    //! normal and point of each cutting plane, which Procrustes moves along with the shapes
+    std::vector<double> planes;
+  };
+
+  Phase phase = Phase::Initialize;
+  //! true once a multiscale run (use_shape_statistics_after) has finished its first round
+  bool multiscale_round = false;
+  //! particle count targets of the current round
+  std::vector<int> number_of_particles;
+  int split_number = 0;
+  int iteration_count = 0;
+  int optimization_iterations_completed = 0;
+  //! iterations the gradient descent optimizer had performed in the current phase
+  int optimizer_iterations = 0;
+  int procrustes_counter = 0;
+  int checkpoint_counter = 0;
+  int64_t particle_iterations = 0;
+  //! serialized state of the particle splitting random number generator
+  std::string random_state;
+  //! minimum variance of each correspondence function, in Optimize's order
+  std::vector<double> minimum_variances;
+  //! energy history of the current phase
+  std::string energy_name;
+  std::vector<double> energy_a;
+  std::vector<double> energy_b;
+  std::vector<double> total_energy;
+
+  std::vector<Domain> domains;
+
+  //! Writes the state to a file, throws std::runtime_error on failure
+  void Write(const std::string& filename) const;
+
+  //! Reads a state written by Write, throws std::runtime_error if the file is missing or invalid
+  static OptimizerState Read(const std::string& filename);
+
+  //! Returns the most recent state file in directory or in its checkpoints subdirectories ("" if none)
+  static std::string FindLatest(const std::string& directory);
+};
+
+}  // namespace shapeworks
@@ -6,9 +6,124 @@
 #include <vtkPolyDataWriter.h>
 #include <vtkSmartPointer.h>
 
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <sstream>
+
+#ifndef __cpp_lib_to_chars
+#include <locale.h>
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
+#endif
 
 namespace shapeworks::particles {
+
+namespace {
+const char binary_magic[8] = {'S', 'W', 'P', 'T', 'S', '0', '0', '1'};
+const char cohort_magic[8] = {'S', 'W', 'C', 'O', 'H', '0', '0', '1'};
+
+struct BinaryHeader {
+  char magic[8];
+  uint64_t num_values;
+};
+
+struct CohortHeader {
+  char magic[8];
+  uint64_t num_subjects;
+  uint64_t num_domains;
+  uint64_t data_offset;
+};
+
+//! Parse the number after any whitespace at pos and move pos past it, returns false if there is no number.  Unlike
+//! strtod, this always uses '.' as the decimal separator, whatever C locale the application has set (QCoreApplication
+//! sets the user's locale).  text must be null terminated at end.
+bool parse_double(const char*& pos, const char* end, double& value) {
+  while (pos < end && (*pos == ' ' || (*pos >= '\t' && *pos <= '\r'))) {
+    pos++;
+  }
+#ifdef __cpp_lib_to_chars
+  // from_chars doesn't accept a leading '+', which strtod does
+  const char* start = pos < end && *pos == '+' && pos + 1 < end && pos[1] != '-' ? pos + 1 : pos;
+  const auto result = std::from_chars(start, end, value);
+  if (result.ec != std::errc()) {
+    return false;
+  }
+  pos = result.ptr;
+#else
+  static const locale_t c_locale = newlocale(LC_NUMERIC_MASK, "C", nullptr);
+  char* parsed;
+  value = strtod_l(pos, &parsed, c_locale);
+  if (parsed == pos) {
+    return false;
+  }
+  pos = parsed;
+#endif
+  return true;
+}
+
+bool ends_with(const std::string& str, const std::string& suffix) {
+  return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+void open_mapped(boost::iostreams::mapped_file_source& file, const std::string& filename) {
+  try {
+    file.open(filename);
+  } catch (std::exception& e) {
+    throw std::runtime_error("Unable to read file: " + filename);
+  }
+}
+}  // namespace
+
+//---------------------------------------------------------------------------
+bool is_binary_particle_file(const std::string& filename) { return ends_with(filename, BINARY_EXTENSION); }
+
+//---------------------------------------------------------------------------
+bool is_cohort_file(const std::string& filename) { return ends_with(filename, COHORT_EXTENSION); }
+
+//---------------------------------------------------------------------------
+static void write_binary_particles(std::string filename, const Eigen::VectorXd& points) {
+  std::ofstream out(filename, std::ios::binary);
+  if (!out) {
+    throw std::runtime_error("Unable to write file: " + filename);
+  }
+  BinaryHeader header;
+  std::memcpy(header.magic, binary_magic, sizeof(binary_magic));
+  header.num_values = points.size();
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(points.data()), points.size() * sizeof(double));
+  if (!out) {
+    throw std::runtime_error("Error writing file: " + filename);
+  }
+}
+
+//---------------------------------------------------------------------------
+static Eigen::VectorXd read_binary_particles(std::string filename) {
+  // the values are read straight into the returned vector, which owns its data, so there is nothing to gain from
+  // mapping the file (CohortFile maps its file, as it hands out views into it)
+  std::ifstream in(filename, std::ios::binary | std::ios::ate);
+  if (!in.good()) {
+    throw std::runtime_error("Unable to read file: " + filename);
+  }
+  const uint64_t file_size = in.tellg();
+  in.seekg(0);
+
+  BinaryHeader header;
+  if (file_size < sizeof(header) || !in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, binary_magic, sizeof(binary_magic)) != 0 ||
+      header.num_values != (file_size - sizeof(header)) / sizeof(double) ||
+      (file_size - sizeof(header)) % sizeof(double) != 0) {
+    throw std::runtime_error("Invalid particle file: " + filename);
+  }
+
+  Eigen::VectorXd points(header.num_values);
+  if (!in.read(reinterpret_cast<char*>(points.data()), header.num_values * sizeof(double))) {
+    throw std::runtime_error("Invalid particle file: " + filename);
+  }
+  return points;
+}
 //---------------------------------------------------------------------------
 static void write_vtk_particles(std::string filename, const Eigen::VectorXd& points) {
   auto vtk_points = vtkSmartPointer<vtkPoints>::New();
@@ -58,36 +173,30 @@ Eigen::VectorXd read_particles(std::string filename) {
     return read_vtk_particles(filename);
   }
 
-  std::ifstream in(filename);
+  if (is_binary_particle_file(filename)) {
+    return read_binary_particles(filename);
+  }
+
+  std::ifstream in(filename, std::ios::binary);
   if (!in.good()) {
     throw std::runtime_error("Unable to read file: " + filename);
   }
-  Eigen::VectorXd points;
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+  const std::string text = buffer.str();
 
-  auto vtk_points = vtkSmartPointer<vtkPoints>::New();
-  vtk_points->SetDataTypeToDouble();
-  int num_points = 0;
-  while (in.good()) {
-    double x, y, z;
-    in >> x >> y >> z;
-    if (!in.good()) {
-      break;
-    }
-    vtk_points->InsertNextPoint(x, y, z);
-    num_points++;
+  // parse the whole file in place, one number at a time, stopping at the first token that isn't a number
+  std::vector<double> values;
+  const char* pos = text.c_str();
+  const char* end = pos + text.size();
+  double value;
+  while (parse_double(pos, end, value)) {
+    values.push_back(value);
   }
-  in.close();
-  points.setZero();
-  points.resize(num_points * 3);
 
-  int idx = 0;
-  for (int i = 0; i < num_points; i++) {
-    double* pos = vtk_points->GetPoint(i);
-    points[idx++] = pos[0];
-    points[idx++] = pos[1];
-    points[idx++] = pos[2];
-  }
-  return points;
+  // only complete points are kept
+  const size_t num_values = values.size() - values.size() % 3;
+  return Eigen::Map<const Eigen::VectorXd>(values.data(), num_values);
 }
 
 //---------------------------------------------------------------------------
@@ -96,6 +205,10 @@ void write_particles(std::string filename, const Eigen::VectorXd& points) {
     write_vtk_particles(filename, points);
     return;
   }
+  if (is_binary_particle_file(filename)) {
+    write_binary_particles(filename, points);
+    return;
+  }
   std::ofstream out(filename.c_str());
   if (!out) {
     throw std::runtime_error("Unable to write file: " + filename);
@@ -142,4 +255,132 @@ void write_particles_from_vector(std::string filename, std::vector<itk::Point<do
   write_particles(filename, particles);
 }
 
+//---------------------------------------------------------------------------
+CohortFile::CohortFile(const std::string& filename) {
+  open_mapped(file_, filename);
+
+  CohortHeader header;
+  if (file_.size() < sizeof(header)) {
+    throw std::runtime_error("Invalid cohort file: " + filename);
+  }
+  std::memcpy(&header, file_.data(), sizeof(header));
+  if (std::memcmp(header.magic, cohort_magic, sizeof(cohort_magic)) != 0 || header.data_offset < sizeof(header) ||
+      header.data_offset > file_.size()) {
+    throw std::runtime_error("Invalid cohort file: " + filename);
+  }
+  // each (subject, domain) takes an offset and a count in the index, which has to fit before the data
+  const uint64_t max_entries = (header.data_offset - sizeof(header)) / (2 * sizeof(uint64_t));
+  if (header.num_domains == 0 || header.num_subjects > max_entries / header.num_domains) {
+    throw std::runtime_error("Invalid cohort file: " + filename);
+  }
+  num_subjects_ = header.num_subjects;
+  num_domains_ = header.num_domains;
+
+  const char* pos = file_.data() + sizeof(header);
+  const char* data_start = file_.data() + header.data_offset;
+  auto read_u64 = [&]() {
+    if (pos + sizeof(uint64_t) > data_start) {
+      throw std::runtime_error("Invalid cohort file: " + filename);
+    }
+    uint64_t value;
+    std::memcpy(&value, pos, sizeof(uint64_t));
+    pos += sizeof(uint64_t);
+    return value;
+  };
+
+  index_.resize(num_subjects_ * num_domains_);
+  for (auto& [offset, count] : index_) {
+    offset = read_u64();
+    count = read_u64();
+    // the particles are mapped as doubles, so they must be aligned and within the data, checked without overflowing
+    if (offset < header.data_offset || offset > file_.size() || offset % sizeof(double) != 0 ||
+        count > (file_.size() - offset) / sizeof(double)) {
+      throw std::runtime_error("Invalid cohort file: " + filename);
+    }
+  }
+
+  names_.resize(num_subjects_);
+  for (auto& name : names_) {
+    const uint64_t length = read_u64();
+    if (pos + length > data_start) {
+      throw std::runtime_error("Invalid cohort file: " + filename);
+    }
+    name.assign(pos, length);
+    pos += length;
+  }
+}
+
+//---------------------------------------------------------------------------
+void CohortFile::write(const std::string& filename, int num_domains, const std::vector<std::string>& names,
+                       const std::vector<Eigen::VectorXd>& particles) {
+  if (num_domains < 1 || particles.size() != names.size() * num_domains) {
+    throw std::invalid_argument("Cohort particles must hold num_domains entries per subject");
+  }
+
+  CohortHeader header;
+  std::memcpy(header.magic, cohort_magic, sizeof(cohort_magic));
+  header.num_subjects = names.size();
+  header.num_domains = num_domains;
+
+  // the particle data is 8 byte aligned so that it can be mapped directly as doubles
+  uint64_t data_offset = sizeof(header) + particles.size() * 2 * sizeof(uint64_t);
+  for (const auto& name : names) {
+    data_offset += sizeof(uint64_t) + name.size();
+  }
+  data_offset = (data_offset + 7) / 8 * 8;
+  header.data_offset = data_offset;
+
+  std::ofstream out(filename, std::ios::binary);
+  if (!out) {
+    throw std::runtime_error("Unable to write file: " + filename);
+  }
+  auto write_u64 = [&](uint64_t value) { out.write(reinterpret_cast<const char*>(&value), sizeof(value)); };
+
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  uint64_t offset = data_offset;
+  for (const auto& points : particles) {
+    write_u64(offset);
+    write_u64(points.size());
+    offset += points.size() * sizeof(double);
+  }
+  for (const auto& name : names) {
+    write_u64(name.size());
+    out.write(name.data(), name.size());
+  }
+  const std::vector<char> padding(data_offset - out.tellp(), 0);
+  out.write(padding.data(), padding.size());
+  for (const auto& points : particles) {
+    out.write(reinterpret_cast<const char*>(points.data()), points.size() * sizeof(double));
+  }
+  if (!out) {
+    throw std::runtime_error("Error writing file: " + filename);
+  }
+}
+
+//---------------------------------------------------------------------------
+void CohortFile::pack(const std::string& filename, const std::vector<std::string>& particle_files, int num_domains) {
+  if (num_domains < 1 || particle_files.size() % num_domains != 0) {
+    throw std::invalid_argument("Number of particle files must be a multiple of the number of domains");
+  }
+  std::vector<std::string> names;
+  std::vector<Eigen::VectorXd> particles;
+  particles.reserve(particle_files.size());
+  for (size_t i = 0; i < particle_files.size(); i++) {
+    if (i % num_domains == 0) {
+      names.push_back(particle_files[i]);
+    }
+    particles.push_back(read_particles(particle_files[i]));
+  }
+  write(filename, num_domains, names, particles);
+}
+
+//---------------------------------------------------------------------------
+Eigen::Map<const Eigen::VectorXd> CohortFile::get_particles(int subject, int domain) const {
+  if (subject < 0 || subject >= num_subjects_ || domain < 0 || domain >= num_domains_) {
+    throw std::out_of_range("Invalid cohort subject/domain");
+  }
+  const auto& [offset, count] = index_[subject * num_domains_ + domain];
+  return Eigen::Map<const Eigen::VectorXd>(reinterpret_cast<const double*>(file_.data() + offset), count);
+}
+
 }  // namespace shapeworks::particles
@@ -3,11 +3,20 @@
 #include <itkPoint.h>
 
 #include <Eigen/Core>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <string>
+#include <vector>
 
 namespace shapeworks {
 
 namespace particles {
 
+//! Extension of binary particle files
+constexpr const char* BINARY_EXTENSION = ".swpts";
+
+//! Extension of packed cohort particle files
+constexpr const char* COHORT_EXTENSION = ".swcohort";
+
 //---------------------------------------------------------------------------
 Eigen::VectorXd read_particles(std::string filename);
 
@@ -20,6 +29,52 @@ void write_particles(std::string filename, const Eigen::VectorXd& points);
 //---------------------------------------------------------------------------
 void write_particles_from_vector(std::string filename, std::vector<itk::Point<double, 3>> points);
 
+//---------------------------------------------------------------------------
+bool is_binary_particle_file(const std::string& filename);
+
+//---------------------------------------------------------------------------
+bool is_cohort_file(const std::string& filename);
+
+/**
+ * \class CohortFile
+ *
+ * A single packed file holding the particles of every subject and domain of
+ * a cohort.  An index header maps (subject, domain) to the position of its
+ * particles in the file, and the file is memory mapped, so get_particles()
+ * returns a view into the mapping without parsing or copying anything.
+ *
+ * The particles of subject s, domain d are stored in the order
+ * s * num_domains + d, the same order as the point files of a project.
+ */
+class CohortFile {
+ public:
+  explicit CohortFile(const std::string& filename);
+
+  //! Writes a cohort file, particles holds num_domains entries per subject
+  static void write(const std::string& filename, int num_domains, const std::vector<std::string>& names,
+                    const std::vector<Eigen::VectorXd>& particles);
+
+  //! Packs existing particle files (of any supported format) into a cohort file
+  static void pack(const std::string& filename, const std::vector<std::string>& particle_files, int num_domains);
+
+  int num_subjects() const { return num_subjects_; }
+  int num_domains() const { return num_domains_; }
+
+  //! Name of each subject (the file the particles of its first domain came from)
+  const std::vector<std::string>& names() const { return names_; }
+
+  //! Particles of one subject and domain, a view into the memory mapped file
+  Eigen::Map<const Eigen::VectorXd> get_particles(int subject, int domain) const;
+
+ private:
+  boost::iostreams::mapped_file_source file_;
+  int num_subjects_ = 0;
+  int num_domains_ = 0;
+  std::vector<std::string> names_;
+  //! offset (in bytes) and number of values of each (subject, domain)
+  std::vector<std::pair<uint64_t, uint64_t>> index_;
+};
+
 }  // namespace particles
 
 }  // namespace shapeworks
@@ -12,30 +12,49 @@ ParticleSystemEvaluation::ParticleSystemEvaluation(const std::vector<std::string
     throw std::runtime_error("No filenames passed to readParticleSystemEvaluation");
   }
 
+  // a single cohort file holds all shapes, with the domains of a shape stacked as for a multi-domain project
+  if (_paths.size() == 1 && particles::is_cohort_file(_paths[0])) {
+    const particles::CohortFile cohort(_paths[0]);
+    this->paths = cohort.names();
+    int D = 0;
+    for (int d = 0; d < cohort.num_domains(); d++) {
+      D += cohort.get_particles(0, d).size();
+    }
+    P.resize(D, cohort.num_subjects());
+    for (int i = 0; i < cohort.num_subjects(); i++) {
+      int row = 0;
+      for (int d = 0; d < cohort.num_domains(); d++) {
+        const auto points = cohort.get_particles(i, d);
+        if (row + points.size() > D) {
+          throw std::runtime_error("ParticleSystemEvaluation files must have the same number of particles");
+        }
+        P.col(i).segment(row, points.size()) = points;
+        row += points.size();
+      }
+      if (row != D) {
+        throw std::runtime_error("ParticleSystemEvaluation files must have the same number of particles");
+      }
+    }
+    return;
+  }
+
   this->paths = _paths;
   const int N = paths.size();
-  const int VDimension = 3;
   assert(N > 0);
 
-  // TODO: We're using the existing particle file reader here. This is not ideal
-  //  since this particle reader loads into a std::vector, which subsequently
-  //  is copied to Eigen. Refactor it to load directly to Eigen. (This is not a
-  //  huge problem for now because the particle files are quite small)
-
   // Read the first file to find dimensions
-  auto points0 = particles::read_particles_as_vector(paths[0]);
-  const int D = points0.size() * VDimension;
+  const Eigen::VectorXd points0 = particles::read_particles(paths[0]);
+  const int D = points0.size();
 
   P.resize(D, N);
-  P.col(0) = Eigen::Map<const Eigen::VectorXd>((double*)points0.data(), D);
+  P.col(0) = points0;
 
   for (int i = 1; i < N; i++) {
-    auto points = particles::read_particles_as_vector(paths[i]);
-    int count = points.size() * VDimension;
-    if (count != D) {
+    const Eigen::VectorXd points = particles::read_particles(paths[i]);
+    if (points.size() != D) {
       throw std::runtime_error("ParticleSystemEvaluation files must have the same number of particles");
     }
-    P.col(i) = Eigen::Map<const Eigen::VectorXd>((double*)points.data(), D);
+    P.col(i) = points;
   }
 }
 
@@ -1,8 +1,16 @@
 #include "ShapeEvaluation.h"
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 #include <Eigen/Core>
+#include <Eigen/Eigenvalues>
 #include <Eigen/SVD>
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <limits>
+#include <mutex>
 
 #include "EvaluationUtil.h"
 
@@ -10,6 +18,161 @@ typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> R
 
 namespace shapeworks {
 
+namespace {
+
+//! Gram matrix (P^T * P) of the columns of P
+Eigen::MatrixXd GramMatrix(const Eigen::MatrixXd& P) {
+  Eigen::MatrixXd K = Eigen::MatrixXd::Zero(P.cols(), P.cols());
+  K.selfadjointView<Eigen::Lower>().rankUpdate(P.transpose());
+  return K.selfadjointView<Eigen::Lower>();
+}
+
+//! Eigendecomposition of a symmetric matrix with the eigenvalues in descending order
+void SortedEigenDecomposition(const Eigen::MatrixXd& G, Eigen::VectorXd& eigenvalues, Eigen::MatrixXd& eigenvectors) {
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> solver(G);
+  eigenvalues = solver.eigenvalues().reverse();
+  eigenvectors = solver.eigenvectors().rowwise().reverse();
+}
+
+//! Eigenvalues below this are treated as zero (directions not spanned by the data)
+double EigenvalueTolerance(const Eigen::VectorXd& eigenvalues) {
+  return std::max(eigenvalues(0), 0.0) * eigenvalues.size() * std::numeric_limits<double>::epsilon();
+}
+
+/**
+ * PCA of the (already centered) columns of Y, limited to the first num_modes modes.
+ *
+ * The D x N data matrix of a shape model has many more rows than columns, so
+ * the modes are computed from the eigendecomposition of the N x N gram matrix
+ * Y^T * Y rather than from an SVD of Y: with Y^T Y = V S^2 V^T, the modes are
+ * U = Y V S^-1 and the singular values are S.
+ */
+void ComputeGramPCA(const Eigen::MatrixXd& Y, int num_modes, Eigen::MatrixXd& modes,
+                    Eigen::VectorXd& singular_values) {
+  Eigen::VectorXd eigenvalues;
+  Eigen::MatrixXd eigenvectors;
+  SortedEigenDecomposition(GramMatrix(Y), eigenvalues, eigenvectors);
+  const double tolerance = EigenvalueTolerance(eigenvalues);
+
+  singular_values.resize(num_modes);
+  Eigen::MatrixXd W = Eigen::MatrixXd::Zero(Y.cols(), num_modes);
+  for (int k = 0; k < num_modes; k++) {
+    singular_values(k) = eigenvalues(k) > tolerance ? std::sqrt(eigenvalues(k)) : 0.0;
+    if (singular_values(k) > 0.0) {
+      W.col(k) = eigenvectors.col(k) / singular_values(k);
+    }
+  }
+  modes = Y * W;
+}
+
+//! Sum of the euclidean distances between corresponding particles of two shapes, stops early once above bound
+double ShapeDistance(const double* a, const double* b, int numParticles, double bound) {
+  constexpr int dim = ShapeEvaluation::VDimension;
+  double sum = 0.0;
+  for (int p = 0; p < numParticles; p++) {
+    double sq = 0.0;
+    for (int d = 0; d < dim; d++) {
+      const double diff = a[p * dim + d] - b[p * dim + d];
+      sq += diff * diff;
+    }
+    sum += std::sqrt(sq);
+    if ((p & 63) == 63 && sum >= bound) {
+      return sum;
+    }
+  }
+  return sum;
+}
+
+/**
+ * PCA coordinates of the training shapes.  coords holds modes^T (y - mu) for
+ * every training shape y, residual_sq the squared norm of the part of
+ * (y - mu) that is outside the span of the modes used.
+ */
+struct TrainingCoordinates {
+  Eigen::MatrixXd coords;
+  Eigen::VectorXd residual_sq;
+};
+
+TrainingCoordinates ComputeTrainingCoordinates(const Eigen::MatrixXd& modes, const Eigen::MatrixXd& Y) {
+  TrainingCoordinates training;
+  training.coords = modes.transpose() * Y;
+  training.residual_sq = Y.colwise().squaredNorm().transpose() - training.coords.colwise().squaredNorm().transpose();
+  return training;
+}
+
+/**
+ * Finds the closest training shape of each sampled shape, using the sum of
+ * the particle to particle euclidean distances as the distance between shapes.
+ *
+ * The samples are given by their PCA coordinates (sample = mu + modes * betas)
+ * and are generated a tile at a time.  A sample lies in the span of the modes,
+ * so its euclidean distance to a training shape is sqrt(|betas - z|^2 + r^2),
+ * with z and r from TrainingCoordinates.  This is a lower bound of the shape
+ * distance (a sum of norms is at least the norm of the whole), so the training
+ * shapes are visited in increasing order of their bound and the search stops
+ * once the bound reaches the closest distance found.
+ */
+void SearchClosestTrainingShapes(Eigen::Ref<const Eigen::MatrixXd> modes, const Eigen::VectorXd& mu,
+                                 const Eigen::MatrixXd& betas, const Eigen::MatrixXd& train,
+                                 Eigen::Ref<const Eigen::MatrixXd> train_coords,
+                                 const Eigen::VectorXd& train_residual_sq, Eigen::VectorXd& distances,
+                                 std::vector<int>& closest) {
+  const int numSamples = betas.cols();
+  const int numTrain = train.cols();
+  const int numParticles = train.rows() / ShapeEvaluation::VDimension;
+  const int tile_size = 32;
+
+  distances.resize(numSamples);
+  closest.resize(numSamples);
+  const Eigen::VectorXd train_coords_sq = train_coords.colwise().squaredNorm().transpose();
+
+  tbb::parallel_for(tbb::blocked_range<int>(0, numSamples, tile_size), [&](const tbb::blocked_range<int>& r) {
+    const int count = r.end() - r.begin();
+    const auto tile_betas = betas.middleCols(r.begin(), count);
+    const Eigen::MatrixXd samples = (modes * tile_betas).colwise() + mu;
+    const Eigen::MatrixXd cross = tile_betas.transpose() * train_coords;
+
+    std::vector<std::pair<double, int>> candidates(numTrain);
+    for (int i = 0; i < count; i++) {
+      const double betas_sq = tile_betas.col(i).squaredNorm();
+      for (int j = 0; j < numTrain; j++) {
+        // slack for the rounding of the expanded square
+        const double slack = 1e-12 * (betas_sq + train_coords_sq(j));
+        const double bound_sq = betas_sq - 2.0 * cross(i, j) + train_coords_sq(j) + train_residual_sq(j) - slack;
+        candidates[j] = {std::sqrt(std::max(bound_sq, 0.0)), j};
+      }
+      std::sort(candidates.begin(), candidates.end());
+
+      double best = std::numeric_limits<double>::infinity();
+      int best_index = 0;
+      for (const auto& [bound, j] : candidates) {
+        if (bound >= best) {
+          break;
+        }
+        const double dist = ShapeDistance(samples.col(i).data(), train.col(j).data(), numParticles, best);
+        if (dist < best) {
+          best = dist;
+          best_index = j;
+        }
+      }
+      distances(r.begin() + i) = best;
+      closest[r.begin() + i] = best_index;
+    }
+  });
+}
+
+}  // namespace
+
+//---------------------------------------------------------------------------
+void ShapeEvaluation::FindClosestTrainingShapes(const Eigen::MatrixXd& modes, const Eigen::VectorXd& mu,
+                                                const Eigen::MatrixXd& betas, const Eigen::MatrixXd& train,
+                                                Eigen::VectorXd& distances, std::vector<int>& closest) {
+  Eigen::MatrixXd Y = train;
+  Y.colwise() -= mu;
+  const TrainingCoordinates training = ComputeTrainingCoordinates(modes, Y);
+  SearchClosestTrainingShapes(modes, mu, betas, train, training.coords, training.residual_sq, distances, closest);
+}
+
 //---------------------------------------------------------------------------
 double ShapeEvaluation::ComputeCompactness(const ParticleSystemEvaluation& ParticleSystemEvaluation, const int nModes,
                                            const std::string& saveTo) {
@@ -82,7 +245,7 @@ double ShapeEvaluation::ComputeGeneralization(const ParticleSystemEvaluation& Pa
     const Eigen::VectorXd Ytest = P.col(leave);
 
     Eigen::JacobiSVD<Eigen::MatrixXd> svd(Y, Eigen::ComputeFullU);
-    const auto epsi = svd.matrixU().block(0, 0, D, nModes);
+    const auto epsi = svd.matrixU().leftCols(nModes);
     const auto betas = epsi.transpose() * (Ytest - mu);
     const Eigen::VectorXd rec = epsi * betas + mu;
 
@@ -105,6 +268,7 @@ double ShapeEvaluation::ComputeGeneralization(const ParticleSystemEvaluation& Pa
   return generalization;
 }
 
+//---------------------------------------------------------------------------
 Eigen::VectorXd ShapeEvaluation::ComputeFullGeneralization(const ParticleSystemEvaluation& ParticleSystemEvaluation,
                                                            std::function<void(float)> progress_callback) {
   const int N = ParticleSystemEvaluation.N();
@@ -115,40 +279,103 @@ Eigen::VectorXd ShapeEvaluation::ComputeFullGeneralization(const ParticleSystemE
     return Eigen::VectorXd();
   }
 
-  Eigen::VectorXd generalizations(N - 1);
-
-  Eigen::VectorXd totalDists = Eigen::VectorXd::Zero(N - 1);
-
-  for (int leave = 0; leave < N; leave++) {
-    if (progress_callback) {
-      progress_callback(static_cast<float>(leave) / static_cast<float>(N));
+  // Every leave-one-out model is built from N-1 training shapes.  Rather than an SVD of each D x (N-1) training
+  // matrix, the model modes are obtained from the eigendecomposition of its (N-1) x (N-1) centered gram matrix, which
+  // is a double centered submatrix of the gram matrix of all shapes, computed once here.
+  const int numParticles = D / VDimension;
+  const int numTrain = N - 1;
+  const Eigen::MatrixXd K = GramMatrix(P);
+  const Eigen::VectorXd P_sum = P.rowwise().sum();
+
+  // modes are reconstructed in blocks to bound the per-subject memory to D x block_size
+  const int block_size = 32;
+
+  std::vector<Eigen::VectorXd> dists(N);
+  std::atomic<int> completed{0};
+  std::mutex progress_mutex;
+
+  tbb::parallel_for(0, N, [&](int leave) {
+    std::vector<int> train;
+    train.reserve(numTrain);
+    for (int j = 0; j < N; j++) {
+      if (j != leave) {
+        train.push_back(j);
+      }
     }
-    Eigen::MatrixXd Y(D, N - 1);
-    Y.leftCols(leave) = P.leftCols(leave);
-    Y.rightCols(N - leave - 1) = P.rightCols(N - leave - 1);
 
-    const Eigen::VectorXd mu = Y.rowwise().mean();
-    Y.colwise() -= mu;
-    const Eigen::VectorXd Ytest = P.col(leave);
+    // centered gram matrix of the training shapes: G = H K_tt H, with H = I - 11^T/(N-1)
+    Eigen::MatrixXd G(numTrain, numTrain);
+    Eigen::VectorXd k_test(numTrain);
+    for (int a = 0; a < numTrain; a++) {
+      k_test(a) = K(train[a], leave);
+      for (int b = 0; b < numTrain; b++) {
+        G(a, b) = K(train[a], train[b]);
+      }
+    }
+    const Eigen::VectorXd row_means = G.rowwise().mean();
+    const double total_mean = row_means.mean();
+    G.colwise() -= row_means;
+    G.rowwise() -= row_means.transpose();
+    G.array() += total_mean;
+
+    // centered training shapes projected on the centered test shape: Y^T (Ytest - mu) = H (K_t,test - K_tt 1/(N-1))
+    Eigen::VectorXd c = k_test - row_means;
+    c.array() -= c.mean();
+
+    Eigen::VectorXd eigenvalues;
+    Eigen::MatrixXd eigenvectors;
+    SortedEigenDecomposition(G, eigenvalues, eigenvectors);
+    const double tolerance = EigenvalueTolerance(eigenvalues);
+
+    const Eigen::VectorXd mu = (P_sum - P.col(leave)) / numTrain;
+    Eigen::VectorXd residual = P.col(leave) - mu;
+
+    // Adding mode k to the reconstruction removes u_k * beta_k from the residual, where u_k = Y v_k / s_k and
+    // beta_k = u_k^T (Ytest - mu) = v_k^T c / s_k.
+    Eigen::VectorXd& subject_dists = dists[leave];
+    subject_dists.resize(numTrain);
+    for (int start = 0; start < numTrain; start += block_size) {
+      const int count = std::min(block_size, numTrain - start);
+
+      // V S^-1 of this block, expanded to all N shapes with a zero row for the left out one
+      Eigen::MatrixXd W = Eigen::MatrixXd::Zero(N, count);
+      Eigen::VectorXd betas = Eigen::VectorXd::Zero(count);
+      for (int k = 0; k < count; k++) {
+        const double eigenvalue = eigenvalues(start + k);
+        if (eigenvalue <= tolerance) {
+          continue;
+        }
+        const double s = std::sqrt(eigenvalue);
+        for (int a = 0; a < numTrain; a++) {
+          W(train[a], k) = eigenvectors(a, start + k) / s;
+        }
+        betas(k) = eigenvectors.col(start + k).dot(c) / s;
+      }
 
-    Eigen::JacobiSVD<Eigen::MatrixXd> svd(Y, Eigen::ComputeFullU);
+      // U = (P_train - mu 1^T) V S^-1
+      Eigen::MatrixXd U = P * W;
+      U -= mu * W.colwise().sum();
 
-    for (int mode = 1; mode < N; mode++) {
-      const auto epsi = svd.matrixU().block(0, 0, D, mode);
-      const auto betas = epsi.transpose() * (Ytest - mu);
-      const Eigen::VectorXd rec = epsi * betas + mu;
+      for (int k = 0; k < count; k++) {
+        residual -= U.col(k) * betas(k);
+        const Eigen::Map<const RowMajorMatrix> residual_reshaped(residual.data(), numParticles, VDimension);
+        subject_dists(start + k) = residual_reshaped.rowwise().norm().sum() / numParticles;
+      }
+    }
 
-      const int numParticles = D / VDimension;
-      const Eigen::Map<const RowMajorMatrix> Ytest_reshaped(Ytest.data(), numParticles, VDimension);
-      const Eigen::Map<const RowMajorMatrix> rec_reshaped(rec.data(), numParticles, VDimension);
-      const double dist = (rec_reshaped - Ytest_reshaped).rowwise().norm().sum() / numParticles;
-      totalDists(mode - 1) += dist;
+    const int done = ++completed;
+    if (progress_callback) {
+      std::lock_guard<std::mutex> lock(progress_mutex);
+      progress_callback(static_cast<float>(done) / static_cast<float>(N));
     }
-  }
+  });
 
-  generalizations = totalDists / N;
+  Eigen::VectorXd totalDists = Eigen::VectorXd::Zero(N - 1);
+  for (const auto& subject_dists : dists) {
+    totalDists += subject_dists;
+  }
 
-  return generalizations;
+  return totalDists / N;
 }
 
 //---------------------------------------------------------------------------
@@ -176,10 +403,10 @@ double ShapeEvaluation::ComputeSpecificity(const ParticleSystemEvaluation& Parti
 
   Y.colwise() -= mu;
 
-  Eigen::JacobiSVD<Eigen::MatrixXd> svd(Y, Eigen::ComputeFullU);
-  const auto epsi = svd.matrixU().block(0, 0, D, nModes);
-  const auto allEigenValues = svd.singularValues();
-  const auto eigenValues = allEigenValues.head(nModes);
+  Eigen::MatrixXd epsi;
+  Eigen::VectorXd eigenValues;
+  ComputeGramPCA(Y, nModes, epsi, eigenValues);
+  const TrainingCoordinates training = ComputeTrainingCoordinates(epsi, Y);
 
   Eigen::MatrixXd samplingBetas(nModes, nSamples);
   MultiVariateNormalRandom sampling{eigenValues.asDiagonal()};
@@ -188,31 +415,20 @@ double ShapeEvaluation::ComputeSpecificity(const ParticleSystemEvaluation& Parti
       samplingBetas.col(i) = sampling();
     }
 
-    Eigen::MatrixXd samplingPoints = (epsi * samplingBetas).colwise() + mu;
-
     const int numParticles = D / VDimension;
-    const int nTrain = ptsModels.cols();
 
-    Eigen::VectorXd distanceToClosestTrainingSample(nSamples);
-
-    for (int i = 0; i < nSamples; i++) {
-      Eigen::VectorXd pts_m = samplingPoints.col(i);
-      Eigen::MatrixXd ptsDistance_vec = ptsModels.colwise() - pts_m;
-      Eigen::MatrixXd ptsDistance(Eigen::MatrixXd::Constant(1, nTrain, 0.0));
-
-      for (int j = 0; j < nTrain; j++) {
-        Eigen::Map<const RowMajorMatrix> ptsDistance_vec_reshaped(ptsDistance_vec.col(j).data(), numParticles,
-                                                                  VDimension);
-        ptsDistance(j) = (ptsDistance_vec_reshaped).rowwise().norm().sum();
-      }
-
-      int closestIdx, _r;
-      distanceToClosestTrainingSample(i) = ptsDistance.minCoeff(&_r, &closestIdx);
+    Eigen::VectorXd distanceToClosestTrainingSample;
+    std::vector<int> closestIdx;
+    SearchClosestTrainingShapes(epsi, mu, samplingBetas, ptsModels, training.coords, training.residual_sq,
+                                distanceToClosestTrainingSample, closestIdx);
 
+    // the samples are only materialized when they are saved
+    for (int i = 0; i < nSamples && !saveTo.empty(); i++) {
+      const Eigen::VectorXd pts_m = epsi * samplingBetas.col(i) + mu;
       Eigen::Map<const RowMajorMatrix> pts_m_reshaped(pts_m.data(), numParticles, VDimension);
       reconstructions.push_back(Reconstruction{
           distanceToClosestTrainingSample(i),
-          (int)closestIdx,
+          closestIdx[i],
           pts_m_reshaped,
       });
     }
@@ -241,13 +457,15 @@ Eigen::VectorXd ShapeEvaluation::ComputeFullSpecificity(const ParticleSystemEval
 
   // PCA calculations
   const Eigen::MatrixXd& ptsModels = ParticleSystemEvaluation.Particles();
-  const int nTrain = ptsModels.cols();
 
   const Eigen::VectorXd mu = ptsModels.rowwise().mean();
   Eigen::MatrixXd Y = ptsModels;
   Y.colwise() -= mu;
-  Eigen::JacobiSVD<Eigen::MatrixXd> svd(Y, Eigen::ComputeFullU);
-  const auto allEigenValues = svd.singularValues();
+  Eigen::MatrixXd allModes;
+  Eigen::VectorXd allEigenValues;
+  ComputeGramPCA(Y, N - 1, allModes, allEigenValues);
+  const TrainingCoordinates training = ComputeTrainingCoordinates(allModes, Y);
+  Eigen::VectorXd residual_sq = Y.colwise().squaredNorm().transpose();
 
   for (int nModes = 1; nModes < N; nModes++) {
     if (progress_callback) {
@@ -259,7 +477,7 @@ Eigen::VectorXd ShapeEvaluation::ComputeFullSpecificity(const ParticleSystemEval
     Eigen::VectorXd stdSpecificity(nModes);
     Eigen::MatrixXd spec_store(nModes, 4);
     const auto eigenValues = allEigenValues.head(nModes);
-    const auto epsi = svd.matrixU().block(0, 0, D, nModes);
+    const auto epsi = allModes.leftCols(nModes);
 
     Eigen::MatrixXd samplingBetas(nModes, nSamples);
     MultiVariateNormalRandom sampling{eigenValues.asDiagonal()};
@@ -267,23 +485,13 @@ Eigen::VectorXd ShapeEvaluation::ComputeFullSpecificity(const ParticleSystemEval
       samplingBetas.col(i) = sampling();
     }
 
-    Eigen::MatrixXd samplingPoints = (epsi * samplingBetas).colwise() + mu;
-    Eigen::VectorXd distanceToClosestTrainingSample(nSamples);
+    // the part of each training shape outside the first nModes modes
+    residual_sq -= training.coords.row(nModes - 1).array().square().matrix().transpose();
 
-    for (int i = 0; i < nSamples; i++) {
-      Eigen::VectorXd pts_m = samplingPoints.col(i);
-      Eigen::MatrixXd ptsDistance_vec = ptsModels.colwise() - pts_m;
-      Eigen::MatrixXd ptsDistance(Eigen::MatrixXd::Constant(1, nTrain, 0.0));
-
-      for (int j = 0; j < nTrain; j++) {
-        Eigen::Map<const RowMajorMatrix> ptsDistance_vec_reshaped(ptsDistance_vec.col(j).data(), numParticles,
-                                                                  VDimension);
-        ptsDistance(j) = (ptsDistance_vec_reshaped).rowwise().norm().sum();
-      }
-
-      int closestIdx, _r;
-      distanceToClosestTrainingSample(i) = ptsDistance.minCoeff(&_r, &closestIdx);
-    }
+    Eigen::VectorXd distanceToClosestTrainingSample;
+    std::vector<int> closestIdx;
+    SearchClosestTrainingShapes(epsi, mu, samplingBetas, ptsModels, training.coords.topRows(nModes), residual_sq,
+                                distanceToClosestTrainingSample, closestIdx);
 
     double meanSpecificity = distanceToClosestTrainingSample.mean();
     const double specificity = meanSpecificity / numParticles;
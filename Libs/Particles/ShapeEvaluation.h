@@ -2,6 +2,7 @@
 
 #include <Eigen/Core>
 #include <string>
+#include <vector>
 
 #include "ParticleShapeStatistics.h"
 #include "ParticleSystemEvaluation.h"
@@ -30,5 +31,11 @@ class ShapeEvaluation {
 
   static Eigen::VectorXd ComputeFullSpecificity(const ParticleSystemEvaluation& ParticleSystemEvaluation,
                                                 std::function<void(float)> progress_callback = nullptr);
+
+  //! Finds the closest training shape (column of train) of each sample mu + modes * betas, by the sum of the
+  //! particle to particle distances as specificity measures it.  The modes must be orthonormal.
+  static void FindClosestTrainingShapes(const Eigen::MatrixXd& modes, const Eigen::VectorXd& mu,
+                                        const Eigen::MatrixXd& betas, const Eigen::MatrixXd& train,
+                                        Eigen::VectorXd& distances, std::vector<int>& closest);
 };
 }  // namespace shapeworks
@@ -32,6 +32,7 @@ using namespace pybind11::literals;
 #include "MeshWarper.h"
 #include "Optimize.h"
 #include "Parameters.h"
+#include "ParticleFile.h"
 #include "ParticleShapeStatistics.h"
 #include "ParticleSystemEvaluation.h"
 #include "Project.h"
@@ -1148,15 +1149,18 @@ PYBIND11_MODULE(shapeworks_py, m)
   .def("toDistanceTransform",
        [](Mesh& mesh, PhysicalRegion &region,
           std::vector<double>& spacing,
-          std::vector<unsigned long>& padding) -> decltype(auto) {
+          std::vector<unsigned long>& padding,
+          double narrow_band) -> decltype(auto) {
          return mesh.toDistanceTransform(region,
                                          Point({spacing[0], spacing[1], spacing[2]}),
-                                         Dims({padding[0], padding[1], padding[2]}));
+                                         Dims({padding[0], padding[1], padding[2]}),
+                                         narrow_band);
        },
-       "converts specified region to distance transform image with specified spacing and padding (default: unit spacing and 1 pixel of padding)",
+       "converts specified region to distance transform image with specified spacing and padding (default: unit spacing and 1 pixel of padding), only computing exact distances within narrow_band of the surface if it is positive",
        "region"_a=PhysicalRegion(),
        "spacing"_a=std::vector<double>({1.0, 1.0, 1.0}),
-       "padding"_a=std::vector<unsigned long>({1, 1, 1}))
+       "padding"_a=std::vector<unsigned long>({1, 1, 1}),
+       "narrow_band"_a=0.0)
 
   .def("center",
        [](Mesh &mesh) -> decltype(auto) {
@@ -1344,8 +1348,8 @@ PYBIND11_MODULE(shapeworks_py, m)
 
   .def_static("findReferenceMesh",
               &MeshUtils::findReferenceMesh,
-              "find reference mesh from a set of meshes",
-              "meshes"_a)
+              "find reference mesh from a set of meshes, only registering a shortlist of candidates if shortlist_size is positive",
+              "meshes"_a, "shortlist_size"_a=0)
 
 
   .def_static("boundaryLoopExtractor",
@@ -1420,6 +1424,47 @@ PYBIND11_MODULE(shapeworks_py, m)
        &ParticleSystemEvaluation::EvaluationCompare)
   ;
 
+  m.def("readParticles",
+        &particles::read_particles,
+        "reads a particle file (text, .vtk or binary .swpts) as a flat array of x/y/z values",
+        "filename"_a);
+
+  m.def("writeParticles",
+        &particles::write_particles,
+        "writes a flat array of x/y/z values as a particle file, the format is chosen by the extension (text, .vtk or binary .swpts)",
+        "filename"_a, "points"_a);
+
+  // CohortFile
+  py::class_<particles::CohortFile>(m, "CohortFile")
+
+  .def(py::init<const std::string &>())
+
+  .def_static("write",
+              &particles::CohortFile::write,
+              "writes a cohort file, particles holds numDomains arrays per subject",
+              "filename"_a, "numDomains"_a, "names"_a, "particles"_a)
+
+  .def_static("pack",
+              &particles::CohortFile::pack,
+              "packs particle files into a cohort file, all domains of a subject in a row",
+              "filename"_a, "particleFiles"_a, "numDomains"_a=1)
+
+  .def("numSubjects",
+       &particles::CohortFile::num_subjects)
+
+  .def("numDomains",
+       &particles::CohortFile::num_domains)
+
+  .def("names",
+       &particles::CohortFile::names)
+
+  .def("getParticles",
+       &particles::CohortFile::get_particles,
+       py::return_value_policy::reference_internal,
+       "returns a read-only view of the particles of a subject and domain, valid as long as the cohort file",
+       "subject"_a, "domain"_a=0)
+  ;
+
   // ShapeEvaluation
   py::class_<ShapeEvaluation>(m, "ShapeEvaluation")
 
@@ -2,7 +2,15 @@
 
 #include "Testing.h"
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <vtkPoints.h>
+
 #include <Groom/Groom.h>
+#include <Groom/GroomCache.h>
+#include <Groom/GroomScheduler.h>
 #include <Project/Project.h>
 
 using namespace shapeworks;
@@ -28,3 +36,131 @@ TEST(GroomTests, basic_test)
   ASSERT_TRUE(image == ground_truth);
 
 }
+
+//---------------------------------------------------------------------------
+TEST(GroomTests, scheduler_budget_test)
+{
+  // each job takes more than half of the budget, so at most one may be in flight at a time
+  GroomScheduler scheduler(100, 4);
+
+  std::atomic<int> in_flight = 0;
+  std::atomic<int> max_in_flight = 0;
+  std::vector<int> written(8, 0);
+
+  std::vector<GroomScheduler::Job> jobs(written.size());
+  for (size_t i = 0; i < jobs.size(); i++) {
+    jobs[i].footprint = 60;
+    jobs[i].read = [&]() {
+      int count = ++in_flight;
+      int max = max_in_flight;
+      while (count > max && !max_in_flight.compare_exchange_weak(max, count)) {
+      }
+      return true;
+    };
+    jobs[i].process = [&]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      return true;
+    };
+    jobs[i].write = [&, i]() {
+      written[i]++;
+      in_flight--;
+      return true;
+    };
+  }
+
+  ASSERT_TRUE(scheduler.run(jobs, []() { return false; }));
+  ASSERT_EQ(max_in_flight, 1);
+  ASSERT_EQ(written, std::vector<int>(written.size(), 1));
+
+  auto statistics = scheduler.get_statistics();
+  ASSERT_EQ(statistics.size(), 3u);
+  for (const auto& stage : statistics) {
+    ASSERT_EQ(stage.count, written.size());
+  }
+}
+
+//---------------------------------------------------------------------------
+TEST(GroomTests, cache_test)
+{
+  GroomCache cache(TestUtils::Instance().get_output_dir("groom_cache"), 0);
+  cache.clear();
+
+  auto key = GroomCache::make_key("image 0123 | isolate | blur 2");
+  ASSERT_NE(key, GroomCache::make_key("image 0123 | isolate | blur 2.5"));
+  ASSERT_EQ(cache.load(key), nullptr);
+
+  Image image(Dims({4, 4, 4}));
+  image.getITKImage()->FillBuffer(1.5);
+  cache.store(key, image);
+  ASSERT_EQ(cache.get_count(), 1u);
+
+  auto cached = cache.load(key);
+  ASSERT_NE(cached, nullptr);
+  ASSERT_TRUE(*cached == image);
+
+  cache.prune(0);
+  ASSERT_EQ(cache.get_count(), 0u);
+  ASSERT_EQ(cache.load(key), nullptr);
+}
+
+//---------------------------------------------------------------------------
+TEST(GroomTests, cache_restart_test)
+{
+  std::string test_location = std::string(TEST_DATA_DIR) + std::string("/optimize/sphere");
+  chdir(test_location.c_str());
+
+  ProjectHandle project = std::make_shared<Project>();
+  project->load("groom.xlsx");
+  GroomCache(Groom::get_cache_directory(project), 0).clear();
+  const int num_subjects = project->get_subjects().size();
+
+  // fill the cache with a groom that blurs twice as much as the baseline
+  GroomParameters params(project);
+  const double blur = params.get_blur_amount();
+  params.set_groom_cache(true);
+  params.set_blur_amount(blur * 2);
+  params.save_to_project();
+  {
+    Groom app(project);
+    ASSERT_TRUE(app.run());
+    ASSERT_EQ(app.get_cached_stage_count(), 0);
+  }
+
+  // with only the blur changed, every image restarts from the stage before the blur
+  params.set_blur_amount(blur);
+  params.save_to_project();
+  Groom app(project);
+  ASSERT_TRUE(app.run());
+  const int restarted_before_blur = app.get_cached_stage_count();
+
+  Image ground_truth("../shared/spheres/sphere10_DT_baseline.nrrd");
+  ASSERT_TRUE(Image("groomed/sphere10_DT.nrrd") == ground_truth);
+
+  // grooming again restores every stage, which is one stage per subject more than the run above
+  ASSERT_TRUE(app.run());
+  ASSERT_EQ(app.get_cached_stage_count(), restarted_before_blur + num_subjects);
+  ASSERT_TRUE(Image("groomed/sphere10_DT.nrrd") == ground_truth);
+
+  GroomCache(Groom::get_cache_directory(project), 0).clear();
+}
+
+//---------------------------------------------------------------------------
+TEST(GroomTests, find_reference_landmarks_shortlist_test)
+{
+  // the same five landmarks with the third and fifth stretched by 1, 3 and 2, so the last subject is the middle shape
+  std::vector<vtkSmartPointer<vtkPoints>> landmarks;
+  for (double h : {1.0, 3.0, 2.0}) {
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    points->InsertNextPoint(0, 0, 0);
+    points->InsertNextPoint(1, 0, 0);
+    points->InsertNextPoint(0, h, 0);
+    points->InsertNextPoint(0, 0, 1);
+    points->InsertNextPoint(h, h, 0);
+    landmarks.push_back(points);
+  }
+
+  ASSERT_EQ(Groom::find_reference_landmarks(landmarks), 2);
+  // the shortlist must rank the subjects by shape, not by their order
+  ASSERT_EQ(Groom::find_reference_landmarks(landmarks, 1), 2);
+  ASSERT_EQ(Groom::find_reference_landmarks(landmarks, 2), 2);
+}
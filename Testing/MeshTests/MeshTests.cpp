@@ -498,6 +498,28 @@ TEST(MeshTests, toDistanceTransformTest1) {
   ASSERT_TRUE(image == ground_truth);
 }
 
+TEST(MeshTests, toDistanceTransformNarrowBandTest) {
+  Mesh femur(std::string(TEST_DATA_DIR) + "/femur_remesh.ply");
+  const double band = 10.0;
+  Image full = femur.toDistanceTransform(PhysicalRegion(), Point3({5., 5., 5.}), Dims({3, 3, 3}));
+  Image narrow = femur.toDistanceTransform(PhysicalRegion(), Point3({5., 5., 5.}), Dims({3, 3, 3}), band);
+
+  // exact within the band, the sign of the distance outside of it
+  auto full_itk = full.getITKImage();
+  auto narrow_itk = narrow.getITKImage();
+  ASSERT_EQ(full_itk->GetLargestPossibleRegion(), narrow_itk->GetLargestPossibleRegion());
+  const size_t num_pixels = full_itk->GetLargestPossibleRegion().GetNumberOfPixels();
+  for (size_t i = 0; i < num_pixels; i++) {
+    const float expected = full_itk->GetBufferPointer()[i];
+    const float value = narrow_itk->GetBufferPointer()[i];
+    if (std::abs(expected) < band) {
+      ASSERT_NEAR(value, expected, 1e-4);
+    } else {
+      ASSERT_EQ(value, expected > 0 ? band : -band);
+    }
+  }
+}
+
 TEST(MeshTests, coverageTest) {
   Mesh femur(std::string(TEST_DATA_DIR) + "/femur.vtk");
   Mesh pelvis(std::string(TEST_DATA_DIR) + "/pelvis.vtk");
@@ -759,6 +781,17 @@ TEST(MeshTests, findReferenceMeshTest) {
   ASSERT_EQ(ref, 2);
 }
 
+TEST(MeshTests, findReferenceMeshShortlistTest) {
+  // concentric spheres of radius 1, 2 and 3 times the original, the middle one is closest to the others
+  std::vector<Mesh> meshes;
+  for (double scale : {1.0, 2.0, 3.0}) {
+    Mesh mesh(std::string(TEST_DATA_DIR) + "/sphere_00.ply");
+    meshes.push_back(mesh.scale(makeVector({scale, scale, scale})));
+  }
+  ASSERT_EQ(MeshUtils::findReferenceMesh(meshes), 1);
+  ASSERT_EQ(MeshUtils::findReferenceMesh(meshes, 2), 1);
+}
+
 TEST(MeshTests, addMesh) {
   Mesh mesh1(std::string(TEST_DATA_DIR) + "/sphere_00.ply");
   Mesh mesh2(std::string(TEST_DATA_DIR) + "/sphere_00_translated.ply");
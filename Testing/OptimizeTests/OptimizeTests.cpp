@@ -4,13 +4,24 @@
 #include <itkApproximateSignedDistanceMapImageFilter.h>
 #include <itkImageFileReader.h>
 #include <itkImageFileWriter.h>
+#include <tbb/parallel_for.h>
+#include <vnl/vnl_rotation_matrix.h>
 
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <cmath>
 #include <cstdio>
+#include <limits>
+#include <random>
 
+#include "Libs/Optimize/Container/DirtyParticleSet.h"
+#include "Libs/Optimize/Domain/DomainDataRegistry.h"
 #include "Libs/Optimize/Domain/VtkMeshWrapper.h"
+#include "Libs/Optimize/Utils/NearestNeighborStatistics.h"
 #include "Optimize.h"
 #include "OptimizeParameterFile.h"
 #include "ParticleShapeStatistics.h"
+#include "Procrustes3D.h"
 #include "Testing.h"
 
 using namespace shapeworks;
@@ -69,6 +80,34 @@ static bool check_constraint_violations(Optimize &app, double slack) {
   return good;
 };
 
+//---------------------------------------------------------------------------
+// Times function->Evaluate over every particle of every domain and logs the nanoseconds per call. The timing depends
+// on the machine, so it is only reported; the evaluations themselves must produce finite results.
+static void benchmark_evaluate(VectorFunction* function, ParticleSystem* system, const std::string& name) {
+  const int repeats = 200;
+  size_t evaluations = 0;
+  double checksum = 0.0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeats; r++) {
+    for (unsigned int d = 0; d < system->GetNumberOfDomains(); d++) {
+      for (unsigned int p = 0; p < system->GetNumberOfParticles(d); p++) {
+        double maxdt, energy;
+        auto gradient = function->Evaluate(p, d, system, maxdt, energy);
+        checksum += energy + gradient.magnitude();
+        evaluations++;
+      }
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double ns = std::chrono::duration<double, std::nano>(end - start).count() / evaluations;
+  std::cerr << name << "::Evaluate: " << ns << " ns/call (" << evaluations << " calls)\n";
+
+  EXPECT_GT(evaluations, 0);
+  EXPECT_TRUE(std::isfinite(checksum));
+}
+
 //---------------------------------------------------------------------------
 TEST(OptimizeTests, sample) {
   prep_temp("/optimize/sphere", "sample");
@@ -703,3 +742,337 @@ TEST(OptimizeTests, vtk_output) {
   double value = values[values.size() - 1];
   ASSERT_LT(value, 100);
 }
+
+//---------------------------------------------------------------------------
+TEST(OptimizeTests, grid_neighborhood_test) {
+  prep_temp("/optimize/sphere", "grid_neighborhood");
+
+  // make sure we clean out at least one necessary file to make sure we re-run
+  std::remove("optimize_particles/sphere10_DT_world.particles");
+
+  // run with the uniform grid neighborhood instead of the tree
+  Optimize app;
+  ProjectHandle project = std::make_shared<Project>();
+  ASSERT_TRUE(project->load("optimize.swproj"));
+  OptimizeParameters params(project);
+  params.set_use_grid_neighborhood(true);
+  ASSERT_TRUE(params.set_up_optimize(&app));
+  app.Run();
+
+  // compute stats
+  ParticleShapeStatistics stats;
+  stats.ReadPointFiles("analyze.xml");
+  stats.ComputeModes();
+  stats.PrincipalComponentProjections();
+
+  // print out eigenvalues (for debugging)
+  auto values = stats.Eigenvalues();
+  for (int i = 0; i < values.size(); i++) {
+    std::cerr << "Eigenvalue " << i << " : " << values[i] << "\n";
+  }
+
+  // the grid finds the same neighbors as the tree, so the model should match the 'sample' test
+  double value = values[values.size() - 1];
+  ASSERT_LT(value, 100);
+}
+
+//---------------------------------------------------------------------------
+TEST(OptimizeTests, resume_test) {
+  prep_temp("/optimize/sphere", "resume");
+
+  ProjectHandle project = std::make_shared<Project>();
+  ASSERT_TRUE(project->load("optimize.swproj"));
+  OptimizeParameters params(project);
+  params.set_checkpoint_interval(100);
+  params.set_keep_checkpoints(true);
+
+  // uninterrupted run
+  Optimize app;
+  ASSERT_TRUE(params.set_up_optimize(&app));
+  ASSERT_TRUE(app.Run());
+  auto full = app.GetSampler()->GetParticleSystem();
+
+  // resume from a checkpoint in the middle of the optimization step
+  std::vector<std::string> checkpoints;
+  for (const auto& entry : boost::filesystem::directory_iterator(params.get_output_prefix() + "/checkpoints")) {
+    if (entry.path().filename().string().find("_opt") != std::string::npos) {
+      checkpoints.push_back(entry.path().string());
+    }
+  }
+  ASSERT_GT(checkpoints.size(), 2u);
+  std::sort(checkpoints.begin(), checkpoints.end());
+
+  Optimize resumed_app;
+  ASSERT_TRUE(params.set_up_optimize(&resumed_app));
+  resumed_app.SetResumeDirectory(checkpoints[checkpoints.size() / 2]);
+  ASSERT_TRUE(resumed_app.Run());
+  auto resumed = resumed_app.GetSampler()->GetParticleSystem();
+
+  // the resumed run continues exactly where the checkpoint left off
+  ASSERT_EQ(full->GetNumberOfDomains(), resumed->GetNumberOfDomains());
+  for (unsigned int d = 0; d < full->GetNumberOfDomains(); d++) {
+    ASSERT_EQ(full->GetNumberOfParticles(d), resumed->GetNumberOfParticles(d));
+    for (unsigned int i = 0; i < full->GetNumberOfParticles(d); i++) {
+      for (unsigned int k = 0; k < 3; k++) {
+        ASSERT_NEAR(full->GetPosition(i, d)[k], resumed->GetPosition(i, d)[k], 1e-6);
+      }
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+TEST(OptimizeTests, procrustes_align_shapes_test) {
+  // random shapes, each a rotated, scaled and translated copy of a base shape plus a little noise
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  const size_t num_shapes = 20;
+  const size_t num_points = 64;
+
+  Procrustes3D::ShapeType base(num_points);
+  for (auto& p : base) {
+    p = Procrustes3D::PointType(10 * uniform(rng), 10 * uniform(rng), 10 * uniform(rng));
+  }
+
+  Procrustes3D::ShapeListType shapes(num_shapes);
+  for (auto& shape : shapes) {
+    const vnl_matrix_fixed<double, 3, 3> rotation =
+        vnl_rotation_matrix(vnl_vector_fixed<double, 3>(uniform(rng), uniform(rng), uniform(rng)) * 3.0);
+    const double scale = 1.0 + 0.5 * uniform(rng);
+    const Procrustes3D::PointType offset(5 * uniform(rng), 5 * uniform(rng), 5 * uniform(rng));
+    for (const auto& p : base) {
+      shape.push_back(scale * (rotation * p) + offset +
+                      Procrustes3D::PointType(0.01 * uniform(rng), 0.01 * uniform(rng), 0.01 * uniform(rng)));
+    }
+  }
+
+  // the sum of squares matches the sum over all pairs of shapes
+  auto pairwise = [&](const Procrustes3D::ShapeListType& list) {
+    double sum = 0.0;
+    for (const auto& a : list) {
+      for (const auto& b : list) {
+        for (size_t k = 0; k < num_points; k++) {
+          sum += (a[k] - b[k]).squared_magnitude();
+        }
+      }
+    }
+    return sum / (num_shapes * num_points);
+  };
+  ASSERT_NEAR(Procrustes3D::ComputeSumOfSquares(shapes), pairwise(shapes), 1e-6 * pairwise(shapes));
+
+  // aligned shapes differ only by the noise
+  Procrustes3D::SimilarityTransformListType transforms;
+  Procrustes3D procrustes;
+  procrustes.AlignShapes(transforms, shapes);
+  ASSERT_EQ(transforms.size(), num_shapes);
+  ASSERT_LT(Procrustes3D::ComputeSumOfSquares(shapes), 0.05);
+  ASSERT_NEAR(Procrustes3D::ComputeSumOfSquares(shapes), pairwise(shapes), 1e-9);
+}
+
+//---------------------------------------------------------------------------
+TEST(OptimizeTests, nearest_neighbor_statistics_test) {
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<double> uniform(-50.0, 50.0);
+  std::vector<NearestNeighborStatistics::PointType> points(2000);
+  for (auto& p : points) {
+    p[0] = uniform(rng);
+    p[1] = uniform(rng);
+    p[2] = 0.1 * uniform(rng);
+  }
+  // duplicates are each other's nearest neighbor
+  points[10] = points[20];
+
+  auto stats = NearestNeighborStatistics::Compute(points);
+  ASSERT_EQ(stats.distances.size(), points.size());
+
+  double max = 0.0;
+  for (size_t i = 0; i < points.size(); i++) {
+    double nearest = std::numeric_limits<double>::max();
+    for (size_t j = 0; j < points.size(); j++) {
+      if (i != j) {
+        nearest = std::min(nearest, points[i].EuclideanDistanceTo(points[j]));
+      }
+    }
+    ASSERT_DOUBLE_EQ(stats.distances[i], nearest);
+    max = std::max(max, nearest);
+  }
+  ASSERT_DOUBLE_EQ(stats.max, max);
+  ASSERT_EQ(stats.min, 0.0);
+}
+
+//---------------------------------------------------------------------------
+TEST(OptimizeTests, dirty_particle_set_test) {
+  DirtyParticleSet set;
+  set.Reset(1000);
+  ASSERT_TRUE(set.Empty());
+
+  // mark every third particle from several threads, some of them twice
+  tbb::parallel_for(tbb::blocked_range<size_t>{0, 2000}, [&](const tbb::blocked_range<size_t>& r) {
+    for (size_t i = r.begin(); i < r.end(); i++) {
+      if ((i % 1000) % 3 == 0) {
+        set.Mark(i % 1000);
+      }
+    }
+  });
+  ASSERT_FALSE(set.Empty());
+
+  std::vector<size_t> drained;
+  set.Drain([&](size_t k) { drained.push_back(k); });
+  ASSERT_EQ(drained.size(), 334u);
+  for (size_t i = 0; i < drained.size(); i++) {
+    ASSERT_EQ(drained[i], 3 * i);
+  }
+
+  ASSERT_TRUE(set.Empty());
+  set.Drain([&](size_t) { FAIL(); });
+}
+
+//---------------------------------------------------------------------------
+TEST(OptimizeTests, domain_data_registry_test) {
+  auto& registry = DomainDataRegistry::Instance();
+  int num_created = 0;
+  auto create = [&]() {
+    num_created++;
+    return std::make_shared<const std::vector<double>>(100, 1.0);
+  };
+
+  ContentHash hash;
+  hash.AddValue(42);
+  auto a = registry.GetOrCreate<const std::vector<double>>("registry_test", hash.Get(), create);
+  auto b = registry.GetOrCreate<const std::vector<double>>("registry_test", hash.Get(), create);
+  ASSERT_EQ(a, b);
+  ASSERT_EQ(num_created, 1);
+
+  // a different name, hash or type is a different entry
+  auto c = registry.GetOrCreate<const std::vector<double>>("registry_test_other", hash.Get(), create);
+  ASSERT_NE(a, c);
+  hash.AddValue(43);
+  auto d = registry.GetOrCreate<const std::vector<double>>("registry_test", hash.Get(), create);
+  ASSERT_NE(a, d);
+  auto e = registry.GetOrCreate<const std::vector<float>>("registry_test", hash.Get(), [] {
+    return std::make_shared<const std::vector<float>>(10, 2.0f);
+  });
+  ASSERT_EQ(e->size(), 10u);
+  ASSERT_EQ(num_created, 3);
+
+  // data is rebuilt once every domain using it is gone
+  const auto key = ContentHash().Get();
+  registry.GetOrCreate<const std::vector<double>>("registry_test", key, create);
+  registry.GetOrCreate<const std::vector<double>>("registry_test", key, create);
+  ASSERT_EQ(num_created, 5);
+}
+
+//---------------------------------------------------------------------------
+TEST(OptimizeTests, shared_mesh_domain_test) {
+  const auto sw_mesh = MeshUtils::threadSafeReadMesh(std::string(TEST_DATA_DIR) + "/sphere_highres.ply");
+  VtkMeshWrapper a(sw_mesh.getVTKMesh());
+  const size_t num_entries = DomainDataRegistry::Instance().GetNumberOfEntries();
+
+  // a second copy of the same mesh shares the surface data of the first
+  const auto copy = MeshUtils::threadSafeReadMesh(std::string(TEST_DATA_DIR) + "/sphere_highres.ply");
+  VtkMeshWrapper b(copy.getVTKMesh());
+  ASSERT_EQ(DomainDataRegistry::Instance().GetNumberOfEntries(), num_entries);
+
+  // particle caches are still per wrapper
+  VtkMeshWrapper::PointType p = a.GetPointOnMesh();
+  VtkMeshWrapper::PointType q = b.SnapToMesh(p, 0);
+  ASSERT_NEAR(p.EuclideanDistanceTo(q), 0.0, 1e-6);
+  ASSERT_EQ(a.SampleNormalAtPoint(p, 0), b.SampleNormalAtPoint(q, 0));
+
+  // geodesic wrappers of the same mesh share the geodesic operators, and each still finds the same distances
+  VtkMeshWrapper geo_a(sw_mesh.getVTKMesh(), true);
+  const size_t num_geo_entries = DomainDataRegistry::Instance().GetNumberOfEntries();
+  VtkMeshWrapper geo_b(copy.getVTKMesh(), true);
+  ASSERT_EQ(DomainDataRegistry::Instance().GetNumberOfEntries(), num_geo_entries);
+
+  VtkMeshWrapper::PointType r;
+  for (int i = 0; i < 3; i++) {
+    r[i] = -p[i];
+  }
+  r = geo_a.SnapToMesh(r, -1);
+  ASSERT_EQ(geo_a.ComputeDistance(p, -1, r, -1), geo_b.ComputeDistance(p, -1, r, -1));
+}
+
+//---------------------------------------------------------------------------
+TEST(OptimizeTests, single_precision_accuracy_test) {
+  prep_temp("/optimize/mesh_use_normals", "single_precision_accuracy_test");
+
+  Optimize app;
+  ProjectHandle project = std::make_shared<Project>();
+  ASSERT_TRUE(project->load("optimize.swproj"));
+  OptimizeParameters params(project);
+  ASSERT_TRUE(params.set_up_optimize(&app));
+  app.Run();
+
+  auto sampler = app.GetSampler();
+  auto ps = sampler->GetParticleSystem();
+  auto function = sampler->GetMeshBasedGeneralEntropyGradientFunction();
+
+  auto evaluate = [&](std::vector<double>& gradients, std::vector<double>& energies) {
+    function->BeforeIteration();
+    for (unsigned int d = 0; d < ps->GetNumberOfDomains(); d++) {
+      for (unsigned int i = 0; i < ps->GetNumberOfParticles(d); i++) {
+        double maxdt, energy;
+        auto gradient = function->Evaluate(i, d, ps, maxdt, energy);
+        for (int k = 0; k < 3; k++) {
+          gradients.push_back(gradient[k]);
+        }
+        energies.push_back(energy);
+      }
+    }
+  };
+
+  std::vector<double> gradients, energies;
+  evaluate(gradients, energies);
+
+  sampler->SetUseSinglePrecision(true);
+  ASSERT_TRUE(sampler->GetGeneralShapeMatrix()->IsSinglePrecision());
+  std::vector<double> single_gradients, single_energies;
+  evaluate(single_gradients, single_energies);
+  sampler->SetUseSinglePrecision(false);
+
+  auto compare = [](const std::vector<double>& expected, const std::vector<double>& actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    double max_magnitude = 0.0;
+    for (double value : expected) {
+      max_magnitude = std::max(max_magnitude, std::abs(value));
+    }
+    ASSERT_GT(max_magnitude, 0.0);
+    for (size_t i = 0; i < expected.size(); i++) {
+      ASSERT_NEAR(expected[i], actual[i], 1e-3 * max_magnitude);
+    }
+  };
+  compare(gradients, single_gradients);
+  compare(energies, single_energies);
+}
+
+//---------------------------------------------------------------------------
+TEST(OptimizeTests, ensemble_entropy_evaluate_benchmark) {
+  prep_temp("/optimize/sphere", "ensemble_entropy_evaluate_benchmark");
+
+  Optimize app;
+  ProjectHandle project = std::make_shared<Project>();
+  ASSERT_TRUE(project->load("optimize.swproj"));
+  OptimizeParameters params(project);
+  ASSERT_TRUE(params.set_up_optimize(&app));
+  app.Run();
+
+  auto sampler = app.GetSampler();
+  benchmark_evaluate(sampler->GetEnsembleEntropyFunction(), sampler->GetParticleSystem(),
+                     "LegacyCorrespondenceFunction");
+}
+
+//---------------------------------------------------------------------------
+TEST(OptimizeTests, mesh_entropy_evaluate_benchmark) {
+  prep_temp("/optimize/mesh_use_normals", "mesh_entropy_evaluate_benchmark");
+
+  Optimize app;
+  ProjectHandle project = std::make_shared<Project>();
+  ASSERT_TRUE(project->load("optimize.swproj"));
+  OptimizeParameters params(project);
+  ASSERT_TRUE(params.set_up_optimize(&app));
+  app.Run();
+
+  auto sampler = app.GetSampler();
+  benchmark_evaluate(sampler->GetMeshBasedGeneralEntropyGradientFunction(), sampler->GetParticleSystem(),
+                     "CorrespondenceFunction");
+}
@@ -1,7 +1,13 @@
+#include <Eigen/SVD>
+#include <clocale>
+#include <fstream>
+#include <limits>
+#include <random>
 #include <string>
 #include <vector>
 
 #include "Libs/Optimize/Domain/VtkMeshWrapper.h"
+#include "ParticleFile.h"
 #include "ParticleNormalEvaluation.h"
 #include "ParticleShapeStatistics.h"
 #include "ParticleSystemEvaluation.h"
@@ -74,6 +80,86 @@ TEST(ParticlesTests, pca)
   ASSERT_TRUE(((pcaVec - ground_truth).norm() < 1E-4));
 }
 
+TEST(ParticlesTests, binary_particle_files)
+{
+  const std::string output_dir = TestUtils::Instance().get_output_dir("binary_particle_files");
+
+  std::vector<std::string> binary_files;
+  for (const auto& filename : subFilenames) {
+    const Eigen::VectorXd points = particles::read_particles(filename);
+    const std::string binary_file = output_dir + "/" + boost::filesystem::path(filename).stem().string() + ".swpts";
+    particles::write_particles(binary_file, points);
+    ASSERT_TRUE(particles::read_particles(binary_file) == points);
+    binary_files.push_back(binary_file);
+  }
+
+  const std::string cohort_file = output_dir + "/cohort.swcohort";
+  particles::CohortFile::pack(cohort_file, binary_files, 1);
+  particles::CohortFile cohort(cohort_file);
+  ASSERT_EQ(cohort.num_subjects(), static_cast<int>(subFilenames.size()));
+  ASSERT_EQ(cohort.num_domains(), 1);
+
+  ParticleSystemEvaluation text_system(subFilenames);
+  ParticleSystemEvaluation cohort_system(std::vector<std::string>{cohort_file});
+  ASSERT_EQ(cohort_system.Paths(), binary_files);
+  ASSERT_TRUE(cohort_system.Particles() == text_system.Particles());
+}
+
+TEST(ParticlesTests, corrupt_cohort_files)
+{
+  const std::string output_dir = TestUtils::Instance().get_output_dir("corrupt_cohort_files");
+  const std::string cohort_file = output_dir + "/cohort.swcohort";
+
+  // the index entry of the only subject follows the 32 byte header, as an offset and a count
+  auto write_cohort = [&](uint64_t offset_change, uint64_t count) {
+    particles::CohortFile::write(cohort_file, 1, {"subject"}, {Eigen::VectorXd::Ones(6)});
+    std::fstream file(cohort_file, std::ios::in | std::ios::out | std::ios::binary);
+    uint64_t offset;
+    file.seekg(32);
+    file.read(reinterpret_cast<char*>(&offset), sizeof(offset));
+    offset += offset_change;
+    file.seekp(32);
+    file.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+  };
+
+  write_cohort(0, 6);
+  ASSERT_TRUE(particles::CohortFile(cohort_file).get_particles(0, 0) == Eigen::VectorXd::Ones(6));
+
+  // particles that aren't 8 byte aligned
+  write_cohort(4, 5);
+  ASSERT_THROW(particles::CohortFile{cohort_file}, std::runtime_error);
+
+  // a count whose size in bytes wraps around
+  write_cohort(0, std::numeric_limits<uint64_t>::max() / sizeof(double) + 2);
+  ASSERT_THROW(particles::CohortFile{cohort_file}, std::runtime_error);
+}
+
+TEST(ParticlesTests, text_particle_files_ignore_locale)
+{
+  const std::string filename = TestUtils::Instance().get_output_dir("text_particle_locale") + "/points.particles";
+  {
+    std::ofstream out(filename);
+    out << "1.5 -2.25 3e-1\n4.75 5 6.125\n";
+  }
+
+  // a locale with a decimal comma, as QCoreApplication sets for German users, must not change how the file is read
+  const std::string previous = setlocale(LC_NUMERIC, nullptr);
+  for (const char* locale : {"de_DE.UTF-8", "de_DE", "German_Germany"}) {
+    if (setlocale(LC_NUMERIC, locale)) {
+      break;
+    }
+  }
+  const Eigen::VectorXd points = particles::read_particles(filename);
+  setlocale(LC_NUMERIC, previous.c_str());
+
+  ASSERT_EQ(points.size(), 6);
+  ASSERT_DOUBLE_EQ(points[0], 1.5);
+  ASSERT_DOUBLE_EQ(points[1], -2.25);
+  ASSERT_DOUBLE_EQ(points[2], 0.3);
+  ASSERT_DOUBLE_EQ(points[5], 6.125);
+}
+
 TEST(ParticlesTests, compactness)
 {
   ParticleSystemEvaluation ParticleSystemEvaluation(filenames);
@@ -88,6 +174,19 @@ TEST(ParticlesTests, generalization)
   ASSERT_DOUBLE_EQ(generalization, 0.19815116412998687);
 }
 
+TEST(ParticlesTests, full_generalization)
+{
+  ParticleSystemEvaluation ParticleSystemEvaluation(filenames);
+  const Eigen::VectorXd generalizations = ShapeEvaluation::ComputeFullGeneralization(ParticleSystemEvaluation);
+  ASSERT_EQ(generalizations.size(), ParticleSystemEvaluation.N() - 1);
+
+  // the last mode of a leave-one-out model has no variance, so only the others are compared
+  for (int mode = 1; mode < ParticleSystemEvaluation.N() - 1; mode++) {
+    const double generalization = ShapeEvaluation::ComputeGeneralization(ParticleSystemEvaluation, mode);
+    ASSERT_NEAR(generalizations(mode - 1), generalization, 1e-8);
+  }
+}
+
 TEST(ParticlesTests, specificity)
 {
   ParticleSystemEvaluation ParticleSystemEvaluation(filenames);
@@ -95,6 +194,54 @@ TEST(ParticlesTests, specificity)
   ASSERT_NEAR(specificity, 0.262809, 1e-1f);
 }
 
+TEST(ParticlesTests, closest_training_shapes)
+{
+  const int num_particles = 300;
+  const int num_train = 25;
+  const int num_modes = 4;
+  const int num_samples = 200;
+
+  std::mt19937 generator(42);
+  std::normal_distribution<double> normal;
+  auto random = [&](int rows, int cols) {
+    return Eigen::MatrixXd::NullaryExpr(rows, cols, [&]() { return normal(generator); });
+  };
+
+  // training shapes with a few dominant modes plus noise
+  const Eigen::MatrixXd train = random(3 * num_particles, num_modes) * random(num_modes, num_train) * 5.0 +
+                                random(3 * num_particles, num_train);
+  const Eigen::VectorXd mu = train.rowwise().mean();
+  Eigen::JacobiSVD<Eigen::MatrixXd> svd(train.colwise() - mu, Eigen::ComputeThinU);
+  const Eigen::MatrixXd modes = svd.matrixU().leftCols(num_modes);
+  const Eigen::VectorXd scale = svd.singularValues().head(num_modes) / std::sqrt(num_train - 1.0);
+  const Eigen::MatrixXd betas = scale.asDiagonal() * random(num_modes, num_samples);
+
+  Eigen::VectorXd distances;
+  std::vector<int> closest;
+  ShapeEvaluation::FindClosestTrainingShapes(modes, mu, betas, train, distances, closest);
+  ASSERT_EQ(distances.size(), num_samples);
+  ASSERT_EQ(closest.size(), num_samples);
+
+  // the pruned search must find what an exhaustive scan does
+  for (int i = 0; i < num_samples; i++) {
+    const Eigen::VectorXd sample = modes * betas.col(i) + mu;
+    double best = std::numeric_limits<double>::infinity();
+    int best_index = -1;
+    for (int j = 0; j < num_train; j++) {
+      double dist = 0.0;
+      for (int p = 0; p < num_particles; p++) {
+        dist += (sample.segment<3>(3 * p) - train.col(j).segment<3>(3 * p)).norm();
+      }
+      if (dist < best) {
+        best = dist;
+        best_index = j;
+      }
+    }
+    ASSERT_EQ(closest[i], best_index);
+    ASSERT_NEAR(distances(i), best, 1e-9 * best);
+  }
+}
+
 TEST(ParticlesTests, reconstructsurfaceTestRBFS)
 {
   ReconstructSurface<RBFSSparseTransform> reconstructor(denseFile, sparseFile, goodPointsFile);